@@ -0,0 +1,48 @@
+/*
+ * Benchmark of the batched closest intersection query against one
+ * find_closest_intersection() call per point.
+ */
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "batch.h"
+#include "../tests/map_fixture.h"
+
+#define BATCH_BENCH_POINTS 1000000
+
+SUITE(batch_nearest_bench){
+
+    TEST_FIXTURE(MapFixture, batch_vs_single){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        //GPS-like pings scattered around random intersections
+        std::mt19937 rng(297);
+        std::uniform_int_distribution<int> intersection(0, getNumIntersections()-1);
+        std::normal_distribution<double> noise(0, 0.0005);
+        std::vector<LatLon> pings(BATCH_BENCH_POINTS);
+        for(unsigned i = 0; i < pings.size(); i++){
+            LatLon center = getIntersectionPosition(intersection(rng));
+            pings[i] = LatLon(center.lat()+noise(rng), center.lon()+noise(rng));
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<unsigned> single(pings.size());
+        for(unsigned i = 0; i < pings.size(); i++){
+            single[i] = find_closest_intersection(pings[i]);
+        }
+        auto middle = std::chrono::high_resolution_clock::now();
+        std::vector<unsigned> batch = find_closest_intersections(pings);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        CHECK(single == batch);
+
+        double single_s = std::chrono::duration<double>(middle-start).count();
+        double batch_s = std::chrono::duration<double>(end-middle).count();
+        std::cout << "closest intersection of " << pings.size() << " points: single "
+                  << pings.size()/single_s << " pts/s, batch " << pings.size()/batch_s << " pts/s" << std::endl;
+    }
+}
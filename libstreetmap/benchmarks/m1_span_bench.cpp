@@ -0,0 +1,55 @@
+/*
+ * Microbenchmark comparing the copying m1 id list accessors with their
+ * IdSpan variants.
+ */
+#include <iostream>
+#include <chrono>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "spans.h"
+#include "../tests/map_fixture.h"
+
+#define SPAN_BENCH_ROUNDS 20
+
+SUITE(m1_span_accessors_bench){
+
+    TEST_FIXTURE(MapFixture, span_vs_vector){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        //Sum the ids so the loops can't be optimized away
+        unsigned long long vector_sum = 0, span_sum = 0;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for(int r = 0; r < SPAN_BENCH_ROUNDS; r++){
+            for(int i = 0; i < getNumIntersections(); i++){
+                for(unsigned id : find_intersection_street_segments(i)) vector_sum += id;
+                for(unsigned id : find_adjacent_intersections(i)) vector_sum += id;
+            }
+            for(int i = 0; i < getNumStreets(); i++){
+                for(unsigned id : find_street_street_segments(i)) vector_sum += id;
+                for(unsigned id : find_all_street_intersections(i)) vector_sum += id;
+            }
+        }
+        auto middle = std::chrono::high_resolution_clock::now();
+        for(int r = 0; r < SPAN_BENCH_ROUNDS; r++){
+            for(int i = 0; i < getNumIntersections(); i++){
+                for(unsigned id : find_intersection_street_segments_span(i)) span_sum += id;
+                for(unsigned id : find_adjacent_intersections_span(i)) span_sum += id;
+            }
+            for(int i = 0; i < getNumStreets(); i++){
+                for(unsigned id : find_street_street_segments_span(i)) span_sum += id;
+                for(unsigned id : find_all_street_intersections_span(i)) span_sum += id;
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        CHECK_EQUAL(vector_sum, span_sum);
+
+        double vector_ms = std::chrono::duration<double, std::milli>(middle-start).count();
+        double span_ms = std::chrono::duration<double, std::milli>(end-middle).count();
+        std::cout << "m1 accessors over " << SPAN_BENCH_ROUNDS << " rounds: vector " << vector_ms
+                  << " ms, span " << span_ms << " ms (" << vector_ms/span_ms << "x)" << std::endl;
+    }
+}
@@ -0,0 +1,173 @@
+/*
+ * Benchmark of the radix street name trie against a per-character pointer
+ * trie (the layout it replaced): build time, memory and lookup latency.
+ * Also times ranked top-k autocomplete and the typo tolerant search.
+ */
+#include <iostream>
+#include <chrono>
+#include <map>
+#include <random>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "name_trie.h"
+#include "street_search.h"
+#include "../tests/map_fixture.h"
+
+#define TRIE_BENCH_TOP_K 10
+
+SUITE(name_trie_bench){
+
+    //One heap node per character, each holding every id below it
+    struct PointerTrie{
+        std::vector<unsigned> street_ids;
+        std::map<char, PointerTrie*> names;
+
+        ~PointerTrie(){
+            for(std::map<char, PointerTrie*>::iterator i = names.begin(); i != names.end(); i++)
+                delete i->second;
+        }
+
+        size_t memory_usage() const{
+            size_t bytes = sizeof(PointerTrie) + street_ids.capacity()*sizeof(unsigned);
+            for(std::map<char, PointerTrie*>::const_iterator i = names.begin(); i != names.end(); i++){
+                //Map node overhead is roughly three pointers and a colour
+                bytes += 4*sizeof(void*) + sizeof(std::pair<const char, PointerTrie*>) + i->second->memory_usage();
+            }
+            return bytes;
+        }
+    };
+
+    //Every prefix of every street name up to max_length characters, as typed into a search box
+    static std::vector<std::string> street_name_prefixes(unsigned max_length){
+        std::vector<std::string> prefixes;
+        for(int i = 0; i < getNumStreets(); i++){
+            std::string name = getStreetName(i);
+            for(unsigned length = 1; length <= name.size() && length <= max_length; length++){
+                prefixes.push_back(name.substr(0, length));
+            }
+        }
+        prefixes.push_back("#no such street#");
+        return prefixes;
+    }
+
+    TEST_FIXTURE(MapFixture, radix_vs_pointer_trie){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        std::vector<std::string> names(getNumStreets());
+        for(unsigned i = 0; i < names.size(); i++){
+            names[i] = getStreetName(i);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        PointerTrie pointer_trie;
+        for(unsigned i = 0; i < names.size(); i++){
+            PointerTrie *current = &pointer_trie;
+            for(unsigned j = 0; j < names[i].size(); j++){
+                char c = tolower(names[i][j]);
+                if(!current->names.count(c)){
+                    current->names.insert({c, new PointerTrie()});
+                }
+                current = current->names[c];
+                current->street_ids.push_back(i);
+            }
+        }
+        auto middle = std::chrono::high_resolution_clock::now();
+        NameTrie radix_trie;
+        radix_trie.build(names);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        std::vector<std::string> prefixes = street_name_prefixes(12);
+
+        auto lookup_start = std::chrono::high_resolution_clock::now();
+        size_t pointer_total = 0;
+        for(unsigned p = 0; p < prefixes.size(); p++){
+            const PointerTrie *current = &pointer_trie;
+            for(unsigned j = 0; j < prefixes[p].size() && current != nullptr; j++){
+                std::map<char, PointerTrie*>::const_iterator next = current->names.find(tolower(prefixes[p][j]));
+                current = next == current->names.end() ? nullptr : next->second;
+            }
+            if(current != nullptr){
+                std::vector<unsigned> found = current->street_ids;
+                pointer_total += found.size();
+            }
+        }
+        auto lookup_middle = std::chrono::high_resolution_clock::now();
+        size_t radix_total = 0;
+        for(unsigned p = 0; p < prefixes.size(); p++){
+            std::vector<unsigned> found = find_street_ids_from_partial_street_name(prefixes[p]);
+            radix_total += found.size();
+        }
+        auto lookup_end = std::chrono::high_resolution_clock::now();
+        CHECK_EQUAL(pointer_total, radix_total);
+
+        std::cout << "street name trie over " << names.size() << " streets:" << std::endl
+                  << "  pointer trie: build " << std::chrono::duration<double, std::milli>(middle-start).count() << " ms, "
+                  << pointer_trie.memory_usage()/1e6 << " MB, "
+                  << std::chrono::duration<double, std::nano>(lookup_middle-lookup_start).count()/prefixes.size() << " ns/lookup" << std::endl
+                  << "  radix trie: build " << std::chrono::duration<double, std::milli>(end-middle).count() << " ms, "
+                  << radix_trie.memory_usage()/1e6 << " MB, "
+                  << std::chrono::duration<double, std::nano>(lookup_end-lookup_middle).count()/prefixes.size() << " ns/lookup" << std::endl;
+    }
+
+    TEST_FIXTURE(MapFixture, top_k_autocomplete){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        std::vector<std::string> prefixes = street_name_prefixes(6);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t length_total = 0;
+        for(unsigned p = 0; p < prefixes.size(); p++){
+            length_total += find_top_street_ids_from_partial_street_name(prefixes[p], TRIE_BENCH_TOP_K).size();
+        }
+        auto middle = std::chrono::high_resolution_clock::now();
+        size_t segment_total = 0;
+        for(unsigned p = 0; p < prefixes.size(); p++){
+            segment_total += find_top_street_ids_from_partial_street_name(prefixes[p], TRIE_BENCH_TOP_K, StreetRank::SEGMENT_COUNT).size();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        CHECK_EQUAL(length_total, segment_total);
+
+        std::cout << "top " << TRIE_BENCH_TOP_K << " autocomplete: by length "
+                  << std::chrono::duration<double, std::micro>(middle-start).count()/prefixes.size() << " us/keystroke, by segment count "
+                  << std::chrono::duration<double, std::micro>(end-middle).count()/prefixes.size() << " us/keystroke" << std::endl;
+    }
+
+    TEST_FIXTURE(MapFixture, approximate_search){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        //Mistyped names: one character replaced or two neighbours swapped
+        std::mt19937 rng(39);
+        std::vector<std::string> queries;
+        std::vector<unsigned> targets;
+        for(int i = 0; i < getNumStreets() && queries.size() < 500; i += 1+getNumStreets()/500){
+            std::string name = normalize_street_name(getStreetName(i));
+            if(name.size() < 8) continue;
+            std::string typo = name;
+            unsigned at = 1+rng()%(typo.size()-2);
+            if(rng()%2) typo[at] = typo[at] == 'x' ? 'y' : 'x';
+            else std::swap(typo[at], typo[at+1]);
+            queries.push_back(typo);
+            targets.push_back(i);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        unsigned found = 0;
+        for(unsigned q = 0; q < queries.size(); q++){
+            std::vector<unsigned> top = find_street_ids_from_approximate_street_name(queries[q], TRIE_BENCH_TOP_K);
+            for(unsigned t = 0; t < top.size(); t++){
+                if(normalize_street_name(getStreetName(top[t])) == normalize_street_name(getStreetName(targets[q]))){
+                    found++;
+                    break;
+                }
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        std::cout << "approximate search: " << found << "/" << queries.size() << " mistyped names found, "
+                  << std::chrono::duration<double, std::micro>(end-start).count()/queries.size() << " us/query" << std::endl;
+    }
+}
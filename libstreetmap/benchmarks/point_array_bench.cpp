@@ -0,0 +1,55 @@
+/*
+ * Benchmark of the batched PointArray distances against the scalar
+ * find_distance_between_two_points().
+ */
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "point_array.h"
+
+#define POINT_ARRAY_BENCH_POINTS 1000000
+#define POINT_ARRAY_BENCH_TOLERANCE 1e-9
+
+SUITE(point_array_distances_bench){
+
+    //Positions spread over a city sized area and over the whole globe
+    static std::vector<LatLon> random_positions(unsigned count, double lat_center, double lon_center, double spread, unsigned seed){
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> offset(-spread, spread);
+        std::vector<LatLon> positions(count);
+        for(unsigned i = 0; i < count; i++){
+            positions[i] = LatLon(std::max(-89.0, std::min(89.0, lat_center+offset(rng))), lon_center+offset(rng));
+        }
+        return positions;
+    }
+
+    TEST(batch_vs_scalar){
+        std::vector<LatLon> from = random_positions(POINT_ARRAY_BENCH_POINTS, 43.7, -79.4, 0.3, 7);
+        std::vector<LatLon> to = random_positions(POINT_ARRAY_BENCH_POINTS, 43.7, -79.4, 0.3, 8);
+        PointArray from_array(from), to_array(to);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        double scalar_sum = 0;
+        for(unsigned i = 0; i < from.size(); i++){
+            scalar_sum += find_distance_between_two_points(from[i], to[i]);
+        }
+        auto middle = std::chrono::high_resolution_clock::now();
+        std::vector<double> batch;
+        from_array.distances_to(to_array, batch);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double batch_sum = 0;
+        for(unsigned i = 0; i < batch.size(); i++){
+            batch_sum += batch[i];
+        }
+        CHECK_CLOSE(scalar_sum, batch_sum, POINT_ARRAY_BENCH_TOLERANCE*scalar_sum);
+
+        double scalar_ms = std::chrono::duration<double, std::milli>(middle-start).count();
+        double batch_ms = std::chrono::duration<double, std::milli>(end-middle).count();
+        std::cout << "distances of " << from.size() << " pairs: scalar " << scalar_ms << " ms, batch "
+                  << batch_ms << " ms (" << scalar_ms/batch_ms << "x)" << std::endl;
+    }
+}
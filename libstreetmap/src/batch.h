@@ -0,0 +1,29 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   batch.h
+ *
+ * Batched versions of m1 queries for offline bulk processing
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+#include <vector>
+#include <string>
+#include "LatLon.h"
+
+//Returns find_closest_intersection() of every position, computed over all
+//OpenMP threads with a vectorized screen of each k-d tree leaf
+std::vector<unsigned> find_closest_intersections(const std::vector<LatLon> &positions);
+
+//Returns find_points_of_interest_by_name() of every query, over all OpenMP threads
+std::vector<std::vector<unsigned> > find_points_of_interest_by_names(const std::vector<std::string> &queries);
+
+//Returns find_intersections_by_name() of every query, over all OpenMP threads
+std::vector<std::vector<unsigned> > find_intersections_by_names(const std::vector<std::string> &queries);
+
+#endif /* BATCH_H */
@@ -0,0 +1,119 @@
+/*
+ * Static R-tree over boxes, built once with sort-tile-recursive packing like
+ * the segment index. Used to find the features in view.
+ */
+
+#include "box_index.h"
+#include <cmath>
+#include <algorithm>
+
+static bool boxes_overlap(const Box &a, const Box &b){
+
+    return a.x_min <= b.x_max && b.x_min <= a.x_max && a.y_min <= b.y_max && b.y_min <= a.y_max;
+}
+
+static void extend(Box &box, const Box &other){
+
+    box.x_min = std::min(box.x_min, other.x_min);
+    box.y_min = std::min(box.y_min, other.y_min);
+    box.x_max = std::max(box.x_max, other.x_max);
+    box.y_max = std::max(box.y_max, other.y_max);
+}
+
+//Sorts items into vertical slabs by x, then each slab by y
+void str_order(std::vector<unsigned> &order, const std::vector<double> &center_x, const std::vector<double> &center_y, unsigned node_size){
+
+    unsigned m_groups = (order.size()+node_size-1)/node_size;
+    unsigned m_slabs = std::ceil(std::sqrt(double(m_groups)));
+    unsigned m_slab_size = m_slabs == 0 ? 0 : ((m_groups+m_slabs-1)/m_slabs)*node_size;
+
+    std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b){
+        return center_x[a] < center_x[b];
+    });
+    for(unsigned start = 0; start < order.size(); start += m_slab_size){
+        unsigned m_end = std::min<unsigned>(order.size(), start+m_slab_size);
+        std::sort(order.begin()+start, order.begin()+m_end, [&](unsigned a, unsigned b){
+            return center_y[a] < center_y[b];
+        });
+    }
+}
+
+//Builds the R-tree bottom up, one level at a time; the root ends up last
+void BoxIndex::build(const std::vector<Box> &m_boxes){
+
+    nodes.clear();
+    boxes = m_boxes;
+    ids.resize(boxes.size());
+
+    std::vector<double> m_center_x(boxes.size()), m_center_y(boxes.size());
+    for(unsigned i = 0; i < boxes.size(); i++){
+        m_center_x[i] = (boxes[i].x_min+boxes[i].x_max)/2.0;
+        m_center_y[i] = (boxes[i].y_min+boxes[i].y_max)/2.0;
+        ids[i] = i;
+    }
+    str_order(ids, m_center_x, m_center_y, BOX_INDEX_NODE_SIZE);
+
+    std::vector<Node> m_level;
+    for(unsigned first = 0; first < ids.size(); first += BOX_INDEX_NODE_SIZE){
+        Node m_node = {boxes[ids[first]], first, std::min<unsigned>(BOX_INDEX_NODE_SIZE, ids.size()-first), true};
+        for(unsigned i = first+1; i < first+m_node.count; i++){
+            extend(m_node.box, boxes[ids[i]]);
+        }
+        m_level.push_back(m_node);
+    }
+
+    while(m_level.size() > 1){
+        std::vector<double> m_level_x(m_level.size()), m_level_y(m_level.size());
+        std::vector<unsigned> m_level_order(m_level.size());
+        for(unsigned i = 0; i < m_level.size(); i++){
+            m_level_x[i] = (m_level[i].box.x_min+m_level[i].box.x_max)/2.0;
+            m_level_y[i] = (m_level[i].box.y_min+m_level[i].box.y_max)/2.0;
+            m_level_order[i] = i;
+        }
+        str_order(m_level_order, m_level_x, m_level_y, BOX_INDEX_NODE_SIZE);
+
+        unsigned m_base = nodes.size();
+        for(unsigned i = 0; i < m_level_order.size(); i++){
+            nodes.push_back(m_level[m_level_order[i]]);
+        }
+
+        std::vector<Node> m_parents;
+        for(unsigned first = 0; first < m_level_order.size(); first += BOX_INDEX_NODE_SIZE){
+            Node m_node = {nodes[m_base+first].box, m_base+first,
+                           std::min<unsigned>(BOX_INDEX_NODE_SIZE, m_level_order.size()-first), false};
+            for(unsigned i = m_base+first+1; i < m_base+first+m_node.count; i++){
+                extend(m_node.box, nodes[i].box);
+            }
+            m_parents.push_back(m_node);
+        }
+        m_level.swap(m_parents);
+    }
+    nodes.insert(nodes.end(), m_level.begin(), m_level.end());
+}
+
+//Depth first walk of the nodes overlapping box
+std::vector<unsigned> BoxIndex::in_box(const Box &box) const{
+
+    std::vector<unsigned> m_found;
+    if(nodes.empty()){
+        return m_found;
+    }
+
+    std::vector<unsigned> m_stack(1, nodes.size()-1);
+    while(!m_stack.empty()){
+        const Node &m_node = nodes[m_stack.back()];
+        m_stack.pop_back();
+        if(!boxes_overlap(m_node.box, box)){
+            continue;
+        }
+        for(unsigned i = m_node.first; i < m_node.first+m_node.count; i++){
+            if(!m_node.leaf){
+                m_stack.push_back(i);
+            }else if(boxes_overlap(boxes[ids[i]], box)){
+                m_found.push_back(ids[i]);
+            }
+        }
+    }
+    std::sort(m_found.begin(), m_found.end());
+    return m_found;
+}
@@ -0,0 +1,53 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   box_index.h
+ *
+ * Static R-tree over axis aligned boxes, for culling drawn items to the view
+ */
+
+#ifndef BOX_INDEX_H
+#define BOX_INDEX_H
+#include <vector>
+
+//Entries per R-tree node
+#define BOX_INDEX_NODE_SIZE 16
+
+struct Box{
+    double x_min, y_min, x_max, y_max;
+};
+
+//Orders items (given by their box centers) into sort-tile-recursive order:
+//vertical slabs by x, each slab sorted by y, so runs of node_size items are
+//spatially compact
+void str_order(std::vector<unsigned> &order, const std::vector<double> &center_x, const std::vector<double> &center_y, unsigned node_size);
+
+//Packed (sort-tile-recursive) R-tree over one box per id
+class BoxIndex{
+public:
+    void build(const std::vector<Box> &boxes);
+
+    //Ids of the boxes intersecting box, in increasing order so items keep
+    //their drawing order
+    std::vector<unsigned> in_box(const Box &box) const;
+
+private:
+    //Bounding box of a node and its children: nodes[first, first+count) for
+    //internal nodes or ids[first, first+count) for leaves
+    struct Node{
+        Box box;
+        unsigned first;
+        unsigned count;
+        bool leaf;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<unsigned> ids;
+    std::vector<Box> boxes;
+};
+
+#endif /* BOX_INDEX_H */
@@ -82,6 +82,9 @@ protected:
   // Only an ezgl::canvas can create a camera.
   friend class canvas;
 
+  // A renderer creates its own camera to draw off-screen images.
+  friend class renderer;
+
   /**
    * Create a camera.
    *
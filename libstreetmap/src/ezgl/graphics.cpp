@@ -12,6 +12,13 @@ renderer::renderer(cairo_t *cairo,
     : m_cairo(cairo), m_transform(std::move(transform)), m_camera(p_camera), rotation_angle(0)
 {
 #ifdef EZGL_USE_X11
+  // off-screen image surfaces have no x11 drawable, so draw them with cairo only
+  if(cairo_surface_get_type(m_surface) != CAIRO_SURFACE_TYPE_XLIB) {
+    x11_display = nullptr;
+    transparency_flag = true;
+    return;
+  }
+
   // get the underlying x11 drawable used by cairo surface
   x11_drawable = cairo_xlib_surface_get_drawable(m_surface);
 
@@ -31,7 +38,8 @@ renderer::~renderer()
 {
 #ifdef EZGL_USE_X11
   // free the x11 context
-  XFreeGC(x11_display, x11_context);
+  if(x11_display != nullptr)
+    XFreeGC(x11_display, x11_context);
 #endif
 }
 
@@ -57,6 +65,45 @@ rectangle renderer::get_visible_world()
   return {(world.bottom_left() - margin), (world.top_right() + margin)};
 }
 
+point2d renderer::get_world_scale_factor()
+{
+  return m_camera->get_world_scale_factor();
+}
+
+point2d renderer::get_text_size(std::string const &text)
+{
+  return get_text_size(text.c_str());
+}
+
+point2d renderer::get_text_size(char const *text)
+{
+  cairo_text_extents_t const &text_extents = measure_text(text).text;
+
+  return {text_extents.width, text_extents.height};
+}
+
+text_extent_cache::extents const &renderer::measure_text(char const *text)
+{
+  // The key holds the font size's bytes, so sizes differing in any bit are kept apart
+  text_key.assign(current_font_family);
+  text_key += '\0';
+  text_key += static_cast<char>(current_font_slant);
+  text_key += static_cast<char>(current_font_weight);
+  text_key.append(reinterpret_cast<char const *>(&current_font_size), sizeof(current_font_size));
+  text_key += text;
+
+  text_extent_cache &cache = text_cache();
+  text_extent_cache::extents const *found = cache.find(text_key);
+  if(found != nullptr)
+    return *found;
+
+  cairo_text_extents(m_cairo, text, &last_extents.text);
+  cairo_font_extents(m_cairo, &last_extents.font);
+  cache.insert(text_key, last_extents);
+
+  return last_extents;
+}
+
 bool renderer::rectangle_off_screen(rectangle rect)
 {
   if(current_coordinate_system == SCREEN)
@@ -104,6 +151,12 @@ void renderer::set_color(uint_fast8_t red,
   else
     transparency_flag = false;
 
+  // without an x11 display (off-screen images) everything is drawn with cairo
+  if(x11_display == nullptr) {
+    transparency_flag = true;
+    return;
+  }
+
   // set color for x11 (no transparency)
   unsigned long xcolor = 0;
   xcolor |= (red << 2 * 8 | red << 8 | red) & 0xFF0000;
@@ -121,7 +174,8 @@ void renderer::set_line_cap(line_cap cap)
 
 #ifdef EZGL_USE_X11
   current_line_cap = cap;
-  XSetLineAttributes(x11_display, x11_context, current_line_width,
+  if(x11_display != nullptr)
+    XSetLineAttributes(x11_display, x11_context, current_line_width,
       current_line_dash == line_dash::none ? LineSolid : LineOnOffDash,
       current_line_cap == line_cap::butt ? CapButt : CapRound, JoinMiter);
 #endif
@@ -142,7 +196,8 @@ void renderer::set_line_dash(line_dash dash)
 
 #ifdef EZGL_USE_X11
   current_line_dash = dash;
-  XSetLineAttributes(x11_display, x11_context, current_line_width,
+  if(x11_display != nullptr)
+    XSetLineAttributes(x11_display, x11_context, current_line_width,
       current_line_dash == line_dash::none ? LineSolid : LineOnOffDash,
       current_line_cap == line_cap::butt ? CapButt : CapRound, JoinMiter);
 #endif
@@ -154,7 +209,8 @@ void renderer::set_line_width(int width)
 
 #ifdef EZGL_USE_X11
   current_line_width = width;
-  XSetLineAttributes(x11_display, x11_context, current_line_width,
+  if(x11_display != nullptr)
+    XSetLineAttributes(x11_display, x11_context, current_line_width,
       current_line_dash == line_dash::none ? LineSolid : LineOnOffDash,
       current_line_cap == line_cap::butt ? CapButt : CapRound, JoinMiter);
 #endif
@@ -163,12 +219,16 @@ void renderer::set_line_width(int width)
 void renderer::set_font_size(double new_size)
 {
   cairo_set_font_size(m_cairo, new_size);
+  current_font_size = new_size;
 }
 
 void renderer::format_font(std::string const &family, font_slant slant, font_weight weight)
 {
   cairo_select_font_face(m_cairo, family.c_str(), static_cast<cairo_font_slant_t>(slant),
       static_cast<cairo_font_weight_t>(weight));
+  current_font_family = family;
+  current_font_slant = slant;
+  current_font_weight = weight;
 }
 
 void renderer::format_font(std::string const &family,
@@ -221,6 +281,79 @@ void renderer::draw_line(point2d start, point2d end)
   cairo_stroke(m_cairo);
 }
 
+void renderer::draw_polyline(std::vector<point2d> const &points)
+{
+  add_polyline(points.data(), points.size());
+  stroke_polylines();
+}
+
+void renderer::stroke_polylines()
+{
+  polyline_begin.push_back(polyline_points.size());
+
+  // Clip whole lines like draw_line() does, so far off screen coordinates are never transformed
+  rectangle visible = get_visible_world();
+  bool clip = current_coordinate_system == WORLD;
+
+#ifdef EZGL_USE_X11
+  if(!transparency_flag) {
+    std::vector<XSegment> segments;
+    segments.reserve(polyline_points.size());
+
+    for(std::size_t line = 0; line + 1 < polyline_begin.size(); ++line) {
+      for(std::size_t i = polyline_begin[line]; i + 1 < polyline_begin[line + 1]; ++i) {
+        point2d start = polyline_points[i];
+        point2d end = polyline_points[i + 1];
+        if(clip) {
+          if(std::max(start.x, end.x) < visible.left() || std::min(start.x, end.x) > visible.right() ||
+              std::max(start.y, end.y) < visible.bottom() || std::min(start.y, end.y) > visible.top())
+            continue;
+          start = m_transform(start);
+          end = m_transform(end);
+        }
+        segments.push_back({static_cast<short>(start.x), static_cast<short>(start.y),
+            static_cast<short>(end.x), static_cast<short>(end.y)});
+      }
+    }
+
+    if(!segments.empty())
+      XDrawSegments(x11_display, x11_drawable, x11_context, segments.data(), segments.size());
+
+    polyline_points.clear();
+    polyline_begin.clear();
+    return;
+  }
+#endif
+
+  // One path for the whole batch. A new sub-path starts after every clipped line
+  bool drawing = false;
+  for(std::size_t line = 0; line + 1 < polyline_begin.size(); ++line) {
+    drawing = false;
+    for(std::size_t i = polyline_begin[line]; i + 1 < polyline_begin[line + 1]; ++i) {
+      point2d start = polyline_points[i];
+      point2d end = polyline_points[i + 1];
+      if(clip) {
+        if(std::max(start.x, end.x) < visible.left() || std::min(start.x, end.x) > visible.right() ||
+            std::max(start.y, end.y) < visible.bottom() || std::min(start.y, end.y) > visible.top()) {
+          drawing = false;
+          continue;
+        }
+        start = m_transform(start);
+        end = m_transform(end);
+      }
+      if(!drawing)
+        cairo_move_to(m_cairo, start.x, start.y);
+      cairo_line_to(m_cairo, end.x, end.y);
+      drawing = true;
+    }
+  }
+
+  cairo_stroke(m_cairo);
+
+  polyline_points.clear();
+  polyline_begin.clear();
+}
+
 void renderer::draw_rectangle(point2d start, point2d end)
 {
   if(rectangle_off_screen({start, end}))
@@ -275,7 +408,12 @@ void renderer::fill_rectangle(rectangle r)
 
 void renderer::fill_poly(std::vector<point2d> const &points)
 {
-  assert(points.size() > 1);
+  fill_poly(points.data(), points.size());
+}
+
+void renderer::fill_poly(point2d const *points, std::size_t count)
+{
+  assert(count > 1);
 
   // Conservative but fast clip test -- check containing rectangle of polygon
   double x_min = points[0].x;
@@ -283,7 +421,7 @@ void renderer::fill_poly(std::vector<point2d> const &points)
   double y_min = points[0].y;
   double y_max = points[0].y;
 
-  for(std::size_t i = 1; i < points.size(); ++i) {
+  for(std::size_t i = 1; i < count; ++i) {
     x_min = std::min(x_min, points[i].x);
     x_max = std::max(x_max, points[i].x);
     y_min = std::min(y_min, points[i].y);
@@ -300,11 +438,11 @@ void renderer::fill_poly(std::vector<point2d> const &points)
     XPoint fixed_trans_points[X11_MAX_FIXED_POLY_PTS];
     XPoint *trans_points = fixed_trans_points;
 
-    if(points.size() > X11_MAX_FIXED_POLY_PTS) {
-      trans_points = new XPoint[points.size()];
+    if(count > X11_MAX_FIXED_POLY_PTS) {
+      trans_points = new XPoint[count];
     }
 
-    for(size_t i = 0; i < points.size(); i++) {
+    for(size_t i = 0; i < count; i++) {
       if(current_coordinate_system == WORLD)
         next_point = m_transform(points[i]);
       else
@@ -313,10 +451,10 @@ void renderer::fill_poly(std::vector<point2d> const &points)
       trans_points[i].y = static_cast<long>(next_point.y);
     }
 
-    XFillPolygon(x11_display, x11_drawable, x11_context, trans_points, points.size(), Complex,
+    XFillPolygon(x11_display, x11_drawable, x11_context, trans_points, count, Complex,
         CoordModeOrigin);
 
-    if(points.size() > X11_MAX_FIXED_POLY_PTS)
+    if(count > X11_MAX_FIXED_POLY_PTS)
       delete[] trans_points;
     return;
   }
@@ -327,7 +465,7 @@ void renderer::fill_poly(std::vector<point2d> const &points)
 
   cairo_move_to(m_cairo, next_point.x, next_point.y);
 
-  for(std::size_t i = 1; i < points.size(); ++i) {
+  for(std::size_t i = 1; i < count; ++i) {
     if(current_coordinate_system == WORLD)
       next_point = m_transform(points[i]);
     else
@@ -392,10 +530,21 @@ void renderer::fill_arc(point2d center, double radius, double start_angle, doubl
 void renderer::draw_text(point2d point, std::string const &text)
 {
   // call the draw_text function with no bounds
-  draw_text(point, text, DBL_MAX, DBL_MAX);
+  draw_text(point, text.c_str(), DBL_MAX, DBL_MAX);
 }
 
 void renderer::draw_text(point2d point, std::string const &text, double bound_x, double bound_y)
+{
+  draw_text(point, text.c_str(), bound_x, bound_y);
+}
+
+void renderer::draw_text(point2d point, char const *text)
+{
+  // call the draw_text function with no bounds
+  draw_text(point, text, DBL_MAX, DBL_MAX);
+}
+
+void renderer::draw_text(point2d point, char const *text, double bound_x, double bound_y)
 {
   // the center point of the text
   point2d center = point;
@@ -413,13 +562,10 @@ void renderer::draw_text(point2d point, std::string const &text, double bound_x,
   if(rectangle_off_screen({{center.x - bound_x / 2, center.y - bound_y / 2}, bound_x, bound_y}))
     return;
 
-  // get the width and height of the drawn text
-  cairo_text_extents_t text_extents{};
-  cairo_text_extents(m_cairo, text.c_str(), &text_extents);
-
-  // get more information about the font used
-  cairo_font_extents_t font_extents{};
-  cairo_font_extents(m_cairo, &font_extents);
+  // get the width and height of the drawn text, and more information about the font used
+  text_extent_cache::extents const &extents = measure_text(text);
+  cairo_text_extents_t const &text_extents = extents.text;
+  cairo_font_extents_t const &font_extents = extents.font;
 
   // get text width and height in world coordinates (text width and height are constant in widget coordinates)
   double scaled_width = text_extents.width * m_camera->get_world_scale_factor().x;
@@ -471,7 +617,7 @@ void renderer::draw_text(point2d point, std::string const &text, double bound_x,
   // move to the reference point, perform the rotation, and draw the text
   cairo_move_to(m_cairo, ref_point.x, ref_point.y);
   cairo_rotate(m_cairo, rotation_angle);
-  cairo_show_text(m_cairo, text.c_str());
+  cairo_show_text(m_cairo, text);
 
   // restore the old state to undo the performed rotation
   cairo_restore(m_cairo);
@@ -616,6 +762,70 @@ void renderer::draw_surface(surface *p_surface, point2d top_left)
   cairo_paint(m_cairo);
 }
 
+void renderer::draw_surface(surface *p_surface, rectangle bounds)
+{
+  // Check if the surface is properly created
+  if(cairo_surface_status(p_surface) != CAIRO_STATUS_SUCCESS)
+    return;
+
+  // pre-clipping
+  if(rectangle_off_screen(bounds))
+    return;
+
+  point2d top_left = bounds.top_left();
+  point2d bottom_right = bounds.bottom_right();
+  if(current_coordinate_system == WORLD) {
+    top_left = m_transform(top_left);
+    bottom_right = m_transform(bottom_right);
+  }
+
+  // Snap to whole pixels so neighbouring surfaces share their edge pixels
+  top_left = {std::round(top_left.x), std::round(top_left.y)};
+  bottom_right = {std::round(bottom_right.x), std::round(bottom_right.y)};
+
+  double s_width = (double)cairo_image_surface_get_width(p_surface);
+  double s_height = (double)cairo_image_surface_get_height(p_surface);
+
+  cairo_save(m_cairo);
+  cairo_translate(m_cairo, top_left.x, top_left.y);
+  cairo_scale(m_cairo, (bottom_right.x - top_left.x) / s_width, (bottom_right.y - top_left.y) / s_height);
+  cairo_set_source_surface(m_cairo, p_surface, 0, 0);
+  cairo_paint(m_cairo);
+  cairo_restore(m_cairo);
+}
+
+surface *renderer::render_to_image(std::function<void(renderer &)> const &draw, rectangle world, int width, int height)
+{
+  cairo_surface_t *image = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+  if(cairo_surface_status(image) != CAIRO_STATUS_SUCCESS)
+    return image;
+
+  // A camera showing exactly the given world on the image
+  camera image_camera(world);
+  image_camera.update_widget(width, height);
+
+  cairo_t *context = cairo_create(image);
+  cairo_set_antialias(context, CAIRO_ANTIALIAS_NONE);
+
+  {
+    using namespace std::placeholders;
+    renderer g(context, std::bind(&camera::world_to_screen, image_camera, _1), &image_camera, image);
+    draw(g);
+  }
+
+  cairo_destroy(context);
+  cairo_surface_flush(image);
+
+  return image;
+}
+
+text_extent_cache &renderer::text_cache()
+{
+  static thread_local text_extent_cache cache(4 * 1024 * 1024);
+
+  return cache;
+}
+
 surface *renderer::load_png(const char *file_path)
 {
   // Create an image surface from a PNG image
@@ -630,4 +840,79 @@ void renderer::free_surface(surface *p_surface)
   if (cairo_surface_status(p_surface) == CAIRO_STATUS_SUCCESS)
     cairo_surface_destroy(p_surface);
 }
+
+text_extent_cache::text_extent_cache(std::size_t new_max_bytes) : max_bytes(new_max_bytes)
+{
+}
+
+text_extent_cache::extents const *text_extent_cache::find(std::string const &key)
+{
+  auto found = index.find(key);
+  if(found == index.end()) {
+    ++misses;
+    return nullptr;
+  }
+
+  ++hits;
+  entries.splice(entries.begin(), entries, found->second);
+  return &found->second->value;
+}
+
+void text_extent_cache::insert(std::string const &key, extents const &value)
+{
+  std::size_t new_bytes = entry_bytes(key.size());
+  if(new_bytes > max_bytes)
+    return;
+
+  evict_to(max_bytes - new_bytes);
+  entries.push_front({key, value});
+  index[key] = entries.begin();
+  bytes += new_bytes;
+}
+
+void text_extent_cache::clear()
+{
+  evict_to(0);
+}
+
+void text_extent_cache::set_max_bytes(std::size_t new_max_bytes)
+{
+  max_bytes = new_max_bytes;
+  evict_to(max_bytes);
+}
+
+std::size_t text_extent_cache::size() const
+{
+  return entries.size();
+}
+
+std::size_t text_extent_cache::memory_usage() const
+{
+  return bytes;
+}
+
+unsigned long text_extent_cache::hit_count() const
+{
+  return hits;
+}
+
+unsigned long text_extent_cache::miss_count() const
+{
+  return misses;
+}
+
+std::size_t text_extent_cache::entry_bytes(std::size_t key_length)
+{
+  // the key is stored twice, in the list node and the index
+  return sizeof(entry) + 2 * sizeof(void *) + sizeof(std::string) + 2 * sizeof(void *) + 2 * key_length;
+}
+
+void text_extent_cache::evict_to(std::size_t limit)
+{
+  while(bytes > limit && !entries.empty()) {
+    bytes -= entry_bytes(entries.back().key.size());
+    index.erase(entries.back().key);
+    entries.pop_back();
+  }
+}
 }
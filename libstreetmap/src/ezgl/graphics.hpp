@@ -18,6 +18,8 @@
 #include <functional>
 #include <string>
 #include <vector>
+#include <list>
+#include <unordered_map>
 #include <cfloat>
 #include <cmath>
 #include <algorithm>
@@ -136,6 +138,93 @@ enum class line_dash : int {
   asymmetric_5_3
 };
 
+/**
+ * Measurements of text made by the renderer, kept across frames.
+ *
+ * Entries are keyed by a string naming the font family, slant, weight and size along with the text. Once the entries
+ * take more than the byte limit, the least recently used ones are dropped.
+ */
+class text_extent_cache {
+public:
+  /**
+   * The measurements of one piece of text, as cairo reports them.
+   */
+  struct extents {
+    cairo_text_extents_t text;
+    cairo_font_extents_t font;
+  };
+
+  /**
+   * Create an empty cache.
+   *
+   * @param max_bytes The most memory the entries may take.
+   */
+  explicit text_extent_cache(std::size_t max_bytes);
+
+  /**
+   * Find the measurements stored for a key, marking them as the most recently used.
+   *
+   * @return The measurements, or nullptr if they are not cached. Valid until the next insert().
+   */
+  extents const *find(std::string const &key);
+
+  /**
+   * Store the measurements for a key that is not cached, dropping least recently used entries to stay in bounds.
+   */
+  void insert(std::string const &key, extents const &value);
+
+  /**
+   * Remove every entry. The hit and miss counts are kept.
+   */
+  void clear();
+
+  /**
+   * Change the most memory the entries may take, dropping entries if they take more.
+   */
+  void set_max_bytes(std::size_t max_bytes);
+
+  /**
+   * The number of entries.
+   */
+  std::size_t size() const;
+
+  /**
+   * The approximate memory taken by the entries, in bytes.
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * The number of find() calls that found their key.
+   */
+  unsigned long hit_count() const;
+
+  /**
+   * The number of find() calls that did not find their key.
+   */
+  unsigned long miss_count() const;
+
+private:
+  struct entry {
+    std::string key;
+    extents value;
+  };
+
+  // Bytes taken by an entry with a key of key_length characters, counting its list node and index slot
+  static std::size_t entry_bytes(std::size_t key_length);
+
+  // Drop least recently used entries until at most limit bytes are taken
+  void evict_to(std::size_t limit);
+
+  std::size_t max_bytes;
+  std::size_t bytes = 0;
+  unsigned long hits = 0;
+  unsigned long misses = 0;
+
+  // Most recently used first
+  std::list<entry> entries;
+  std::unordered_map<std::string, std::list<entry>::iterator> index;
+};
+
 /**
  * Provides functions to draw primitives (e.g., lines, shapes) to a rendering context.
  *
@@ -156,6 +245,29 @@ public:
    */
   rectangle get_visible_world();
 
+  /**
+   * Get the size of a screen pixel in world coordinates
+   */
+  point2d get_world_scale_factor();
+
+  /**
+   * Get the size of text in the current font, as draw_text() would draw it
+   *
+   * @param text The text to measure.
+   *
+   * @return The width and height of the text in pixels.
+   */
+  point2d get_text_size(std::string const &text);
+
+  /**
+   * Get the size of null terminated text in the current font, as draw_text() would draw it
+   *
+   * @param text The text to measure.
+   *
+   * @return The width and height of the text in pixels.
+   */
+  point2d get_text_size(char const *text);
+
   /**** Functions to set graphics attributes (for all subsequent drawing calls). ****/
 
   /**
@@ -258,6 +370,39 @@ public:
    */
   void draw_line(point2d start, point2d end);
 
+  /**
+   * Draw a polyline connecting consecutive points as a single path with one stroke.
+   *
+   * @param points The points to connect, in order.
+   */
+  void draw_polyline(std::vector<point2d> const &points);
+
+  /**
+   * Add a polyline to the pending batch without drawing it.
+   *
+   * Every polyline added since the last stroke_polylines() is drawn by it with a single stroke, using the
+   * graphics attributes set at that time. Drawing many lines of one style this way is much faster than
+   * calling draw_line() for each of them.
+   *
+   * @param points The points of the polyline, in order. Any type with public x and y members can be used.
+   * @param count The number of points.
+   */
+  template <typename point_type>
+  void add_polyline(point_type const *points, std::size_t count)
+  {
+    if(count < 2)
+      return;
+
+    polyline_begin.push_back(polyline_points.size());
+    for(std::size_t i = 0; i < count; ++i)
+      polyline_points.push_back({points[i].x, points[i].y});
+  }
+
+  /**
+   * Draw every polyline added with add_polyline() since the last call, then empty the batch.
+   */
+  void stroke_polylines();
+
   /**
    * Draw the outline a rectangle.
    *
@@ -309,6 +454,14 @@ public:
    */
   void fill_poly(std::vector<point2d> const &points);
 
+  /**
+   * Draw a filled polygon from a contiguous point buffer.
+   *
+   * @param points The points to draw. The first and last points are connected to close the polygon.
+   * @param count The number of points.
+   */
+  void fill_poly(point2d const *points, std::size_t count);
+
   /**
    * Draw the outline of an elliptic arc.
    *
@@ -377,6 +530,24 @@ public:
    */
   void draw_text(point2d point, std::string const &text, double bound_x, double bound_y);
 
+  /**
+   * Draw null terminated text, e.g. a name kept in a pool, without copying it into a string.
+   *
+   * @param point The point where the text is drawn, in pixels.
+   * @param text The text to draw.
+   */
+  void draw_text(point2d point, char const *text);
+
+  /**
+   * Draw null terminated text with bounds.
+   *
+   * @param point The point where the text is drawn, in pixels.
+   * @param text The text to draw.
+   * @param bound_x The maximum allowed width of the text
+   * @param bound_y The maximum allowed height of the text
+   */
+  void draw_text(point2d point, char const *text, double bound_x, double bound_y);
+
   /**
    * Draw a surface
    *
@@ -385,6 +556,16 @@ public:
    */
   void draw_surface(surface *surface, point2d top_left);
 
+  /**
+   * Draw a surface scaled to fill a rectangle
+   *
+   * The corners are snapped to whole pixels, so surfaces drawn into rectangles sharing an edge meet without a seam.
+   *
+   * @param surface The surface to draw
+   * @param bounds The rectangle the surface covers.
+   */
+  void draw_surface(surface *surface, rectangle bounds);
+
   /**
    * load a png image
    *
@@ -394,6 +575,21 @@ public:
    */
   static surface *load_png(const char *file_path);
 
+  /**
+   * Render part of the world into a new off-screen image surface
+   *
+   * The draw callback gets a renderer whose visible world is the given rectangle, mapped onto the whole image. It
+   * draws with cairo only and touches no GTK or X11 state, so it can be called from any thread.
+   *
+   * @param draw The function that draws to the image.
+   * @param world The rectangle of the world to render. It should have the image's aspect ratio.
+   * @param width The width of the image in pixels.
+   * @param height The height of the image in pixels.
+   *
+   * @return a pointer to the created surface. Should be freed using free_surface()
+   */
+  static surface *render_to_image(std::function<void(renderer &)> const &draw, rectangle world, int width, int height);
+
   /**
    * Free a surface
    *
@@ -401,6 +597,14 @@ public:
    */
   static void free_surface(surface *surface);
 
+  /**
+   * The cache of text measurements used by draw_text() and get_text_size() on the calling thread.
+   *
+   * Each thread has its own cache, so renderers drawing on different threads never share one. It starts with a bound
+   * of 4 MB; use text_extent_cache::set_max_bytes() to change it.
+   */
+  static text_extent_cache &text_cache();
+
   /**
    * Destructor.
    */
@@ -465,6 +669,10 @@ private:
   bool transparency_flag = false;
 #endif
 
+  // Points of the polylines waiting for stroke_polylines(), and where each polyline starts in them
+  std::vector<point2d> polyline_points;
+  std::vector<std::size_t> polyline_begin;
+
   transform_fn m_transform;
 
   //A non-owning pointer to camera object
@@ -478,6 +686,21 @@ private:
 
   // Current vertical text justification
   text_just vert_text_just = text_just::center;
+
+  // The font set on the cairo context, which starts with cairo's default font
+  std::string current_font_family;
+  font_slant current_font_slant = font_slant::normal;
+  font_weight current_font_weight = font_weight::normal;
+  double current_font_size = 10.0;
+
+  // Measure text in the current font, from the text cache when it was measured before
+  text_extent_cache::extents const &measure_text(char const *text);
+
+  // The cache key of the last text measured, kept so measuring does not allocate a new one each time
+  std::string text_key;
+
+  // The measurements of the last text measured, which a later insert may drop from the cache
+  text_extent_cache::extents last_extents;
 };
 }
 
@@ -0,0 +1,89 @@
+/*
+ * Occupancy grid of placed labels. Rotated label boxes are binned by their
+ * axis aligned bounds and tested exactly against the boxes sharing a cell, so
+ * a rejected label never reaches cairo. Only cells holding labels are stored,
+ * so the plane has no edges.
+ */
+
+#include "label_placement.h"
+#include <cmath>
+
+//Key of the cell in a row and column
+static long long cell_key(long long row, long long column){
+
+    return (long long)(((unsigned long long)row << 32) ^ ((unsigned long long)column & 0xffffffffULL));
+}
+
+LabelGrid::LabelGrid(double m_cell_size)
+    : cell_size(m_cell_size){
+}
+
+bool LabelGrid::place(const LabelBox &box){
+
+    ezgl::point2d m_extent = label_extent(box);
+    long long m_column_first = (long long)std::floor((box.center.x-m_extent.x)/cell_size);
+    long long m_column_last = (long long)std::floor((box.center.x+m_extent.x)/cell_size);
+    long long m_row_first = (long long)std::floor((box.center.y-m_extent.y)/cell_size);
+    long long m_row_last = (long long)std::floor((box.center.y+m_extent.y)/cell_size);
+
+    for(long long row = m_row_first; row <= m_row_last; row++){
+        for(long long column = m_column_first; column <= m_column_last; column++){
+            std::unordered_map<long long, std::vector<unsigned> >::const_iterator m_cell = cells.find(cell_key(row, column));
+            if(m_cell == cells.end()){
+                continue;
+            }
+            for(unsigned i = 0; i < m_cell->second.size(); i++){
+                if(labels_overlap(box, boxes[m_cell->second[i]])){
+                    return false;
+                }
+            }
+        }
+    }
+
+    unsigned m_index = boxes.size();
+    boxes.push_back(box);
+    for(long long row = m_row_first; row <= m_row_last; row++){
+        for(long long column = m_column_first; column <= m_column_last; column++){
+            cells[cell_key(row, column)].push_back(m_index);
+        }
+    }
+    return true;
+}
+
+size_t LabelGrid::size() const{
+
+    return boxes.size();
+}
+
+ezgl::point2d label_extent(const LabelBox &box){
+
+    return {box.half_width*std::fabs(box.axis.x)+box.half_height*std::fabs(box.axis.y),
+            box.half_width*std::fabs(box.axis.y)+box.half_height*std::fabs(box.axis.x)};
+}
+
+bool label_touches(const LabelBox &box, const Box &area){
+
+    ezgl::point2d m_extent = label_extent(box);
+    return box.center.x+m_extent.x > area.x_min && box.center.x-m_extent.x < area.x_max
+        && box.center.y+m_extent.y > area.y_min && box.center.y-m_extent.y < area.y_max;
+}
+
+//Half the length of a box's shadow on a unit axis
+static double projected_radius(const LabelBox &box, ezgl::point2d axis){
+
+    return box.half_width*std::fabs(box.axis.x*axis.x+box.axis.y*axis.y)
+         + box.half_height*std::fabs(-box.axis.y*axis.x+box.axis.x*axis.y);
+}
+
+bool labels_overlap(const LabelBox &a, const LabelBox &b){
+
+    ezgl::point2d m_offset = b.center-a.center;
+    ezgl::point2d m_axes[4] = {a.axis, {-a.axis.y, a.axis.x}, b.axis, {-b.axis.y, b.axis.x}};
+    for(unsigned i = 0; i < 4; i++){
+        double m_distance = std::fabs(m_offset.x*m_axes[i].x+m_offset.y*m_axes[i].y);
+        if(m_distance >= projected_radius(a, m_axes[i])+projected_radius(b, m_axes[i])){
+            return false;
+        }
+    }
+    return true;
+}
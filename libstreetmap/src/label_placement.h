@@ -0,0 +1,60 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   label_placement.h
+ *
+ * Pixel space collision detection for map labels
+ */
+
+#ifndef LABEL_PLACEMENT_H
+#define LABEL_PLACEMENT_H
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <ezgl/point.hpp>
+#include "box_index.h"
+
+//Rectangle of a label in screen pixels, rotated so axis runs along the text
+struct LabelBox{
+    ezgl::point2d center;
+    ezgl::point2d axis;
+    double half_width;
+    double half_height;
+};
+
+//Labels placed on an unbounded pixel plane, such as every tile of a pyramid
+//level. A box is placed only if it overlaps no box placed before it. Boxes
+//are binned into square cells so each test only looks at the labels around it
+class LabelGrid{
+public:
+    explicit LabelGrid(double cell_size);
+
+    //Places the box if it fits, returning whether it was placed
+    bool place(const LabelBox &box);
+
+    //Number of boxes placed
+    size_t size() const;
+
+private:
+    double cell_size;
+    std::vector<LabelBox> boxes;
+
+    //Indices into boxes of those touching each cell, by cell row and column
+    std::unordered_map<long long, std::vector<unsigned> > cells;
+};
+
+//Whether two label boxes overlap, by separating axis test
+bool labels_overlap(const LabelBox &a, const LabelBox &b);
+
+//Half the width and height of a box's axis aligned bounds
+ezgl::point2d label_extent(const LabelBox &box);
+
+//Whether a label's axis aligned bounds reach inside area, e.g. a tile in pixels.
+//Labels crossing a tile edge touch the tiles on both sides
+bool label_touches(const LabelBox &box, const Box &area);
+
+#endif /* LABEL_PLACEMENT_H */
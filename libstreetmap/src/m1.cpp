@@ -33,35 +33,44 @@
 #include <cmath>
 #include <set>
 #include <map>
+#include <algorithm>
 #include "nodes.h"
+#include "segments.h"
+#include "names.h"
+#include "spans.h"
+#include "point_index.h"
+#include "poi_search.h"
+#include "batch.h"
+#include "point_array.h"
+#include "segment_index.h"
+#include "segment_route.h"
+#include "name_trie.h"
+#include "street_search.h"
+#include "token_index.h"
+#include "name_search.h"
 
 //Create node structure
 std::vector <Node> node_list;
 double max_speed;
-//Structure used for trie of street names
-struct Name{
-    
-    //Container for street ids corresponding to node (prefix)
-    std::vector<unsigned> street_ids;
-	
-    //Branches for next character
-    std::map<char, Name*> names;
-        
-    //Destructor frees all memory
-    ~Name(){
-        //Delete any created branches
-        for(std::map<char, Name*>::iterator i = names.begin(); i != names.end(); i++)
-            delete i->second;
-    }
-};
 
+//Create packed street segment table
+SegmentTable segment_table;
+
+//Create interned name pool
+NamePool name_pool;
+
+//Create intersection position arrays for batched distances
+PointArray intersection_points;
 
+//Size ratio of two streets' intersection lists above which the shared
+//intersections are found by galloping search instead of a linear merge
+#define GALLOP_RATIO 16
 
 //Intersection Struct Contains street segment IDs, street names, and connected intersections of specified intersection
 struct Intersection{
     
     std::vector<unsigned> street_segment_ids;
-    std::vector<std::string> street_names;
+    std::vector<unsigned> street_name_ids;
     std::vector<unsigned> connected_intersections;
 };
 
@@ -77,7 +86,7 @@ struct Streets{
 
     std::vector <unsigned> street_segments;
     std::vector<unsigned> street_intersections;
-    std::string street_name;
+    unsigned street_name_id;
     double length = 0;
 };
 
@@ -89,13 +98,38 @@ struct M1SuperClass{
 
     std::vector<Streets> street_properties;
 
-    //Pointer to beginning of street name trie
-    Name *head;
+    //Radix trie of street names for prefix search, and its distinct names
+    //ranked for autocomplete
+    NameTrie street_name_trie;
+    NameRanking street_length_ranking;
+    NameRanking street_segment_ranking;
+
+    //Trie of normalized street names for typo tolerant search
+    NameTrie normalized_street_name_trie;
+    NameRanking normalized_street_length_ranking;
+
+    //Spatial index over intersection positions for closest intersection queries
+    PointIndex intersection_index;
+
+    //Spatial indices over all points of interest and over those of each type,
+    //keyed by the type's id in the name pool
+    PointIndex poi_index;
+    std::map<unsigned, PointIndex> poi_type_index;
+
+    //Word indices over point of interest and intersection names
+    TokenIndex poi_name_index;
+    TokenIndex intersection_name_index;
 };
 
 M1SuperClass *g_m1_data;
+void load_segment_table();
 void load_intersections_streets();
 void load_street_segments();
+void load_intersection_index();
+void load_poi_index();
+void load_segment_index();
+void load_name_indices();
+const PointIndex *find_poi_index(const std::string &type);
 
 //Loads a map streets.bin file. Returns true if successful and implements data structures required for functions,
 //false if some error occurs and the map can't be loaded.
@@ -117,13 +151,23 @@ bool load_map(std::string map_path) {
         g_m1_data->intersection_properties.resize(getNumIntersections());
         g_m1_data->street_properties.resize(getNumStreets());
         g_m1_data->street_segments.resize(getNumStreetSegments());
-        g_m1_data->head = new Name();
+
+        //Build the packed segment table used by all later loaders
+        load_segment_table();
+
+        //Build the closest intersection, POI and segment indices over the segment table's projection
+        load_intersection_index();
+        load_poi_index();
+        load_segment_index();
 
         //Build the street segments structure
         load_street_segments();
 
         //Build the intersections and streets structure
         load_intersections_streets();
+
+        //Build the point of interest and intersection name search indices
+        load_name_indices();
     }
     
     bool m_load_osm_successful = false;
@@ -133,9 +177,12 @@ bool load_map(std::string map_path) {
     if(!m_load_osm_successful){
         if(m_load_map_successful){
             closeStreetDatabase();
-            delete g_m1_data->head;
             delete g_m1_data;
             node_list.clear();
+            segment_table = SegmentTable();
+            name_pool = NamePool();
+            intersection_points = PointArray();
+            segment_index = SegmentIndex();
         }
         return m_load_osm_successful;
     }
@@ -147,10 +194,13 @@ bool load_map(std::string map_path) {
 void close_map() {
     
     //Delete empty the data structures implemented for m1
-    delete g_m1_data->head;
     delete g_m1_data;
     node_list.clear();
     node_list.shrink_to_fit();
+    segment_table = SegmentTable();
+    name_pool = NamePool();
+    intersection_points = PointArray();
+    segment_index = SegmentIndex();
     closeOSMDatabase();
     
     //Close the database
@@ -164,11 +214,22 @@ std::vector<unsigned> find_intersection_street_segments(unsigned intersection_id
     
 }
 
+//Returns a view of the street segments for the given intersection
+IdSpan find_intersection_street_segments_span(unsigned intersection_id) {
+    
+    return g_m1_data->intersection_properties[intersection_id].street_segment_ids;
+    
+}
+
 //Returns the street names at the given intersection (includes duplicate street 
 //names in returned vector)
 std::vector<std::string> find_intersection_street_names(unsigned intersection_id){
     
-    return g_m1_data->intersection_properties[intersection_id].street_names;
+    std::vector<std::string> m_street_names;
+    for(unsigned name_id : g_m1_data->intersection_properties[intersection_id].street_name_ids){
+        m_street_names.push_back(name_pool.get(name_id));
+    }
+    return m_street_names;
 }
 
 //Returns true if you can get from intersection1 to intersection2 using a single 
@@ -182,8 +243,8 @@ bool are_directly_connected(unsigned intersection_id1, unsigned intersection_id2
     }
     
     //Checks if intersection2 is it is validly connected to intersection1
-    for(int i = 0; i < int(g_m1_data->intersection_properties[intersection_id1].connected_intersections.size()); i++){
-        if(intersection_id2 == g_m1_data->intersection_properties[intersection_id1].connected_intersections[i]){
+    for(unsigned m_adjacent : find_adjacent_intersections_span(intersection_id1)){
+        if(intersection_id2 == m_adjacent){
             return true;
         }
     }
@@ -198,6 +259,12 @@ std::vector<unsigned> find_adjacent_intersections(unsigned intersection_id){
     return g_m1_data->intersection_properties[intersection_id].connected_intersections;
 }
 
+//Returns a view of the intersections adjacent to the given intersection
+IdSpan find_adjacent_intersections_span(unsigned intersection_id){
+    
+    return g_m1_data->intersection_properties[intersection_id].connected_intersections;
+}
+
 //Returns all street segments for the given street
 std::vector<unsigned> find_street_street_segments(unsigned street_id){
 
@@ -205,6 +272,13 @@ std::vector<unsigned> find_street_street_segments(unsigned street_id){
 
 }
 
+//Returns a view of the street segments for the given street
+IdSpan find_street_street_segments_span(unsigned street_id){
+
+    return g_m1_data->street_properties[street_id].street_segments;
+
+}
+
 //Returns all intersections along the a given street
 std::vector<unsigned> find_all_street_intersections(unsigned street_id){
 
@@ -212,21 +286,61 @@ std::vector<unsigned> find_all_street_intersections(unsigned street_id){
 
 }
 
+//Returns a view of the intersections along the given street
+IdSpan find_all_street_intersections_span(unsigned street_id){
+
+    return g_m1_data->street_properties[street_id].street_intersections;
+
+}
+
 //Return all intersection ids for two intersecting streets
 //This function will typically return one intersection id.
 std::vector<unsigned> find_intersection_ids_from_street_ids(unsigned street_id1, 
                                                             unsigned street_id2){
     
-    //Create connected intersections container and checks if any intersections
-    //in street1 are a part of street2 and stores it if true
+    //Create connected intersections container. Both intersection lists are sorted
+    //(built from std::set) so shared ids are found in one pass
     std::vector<unsigned> m_temp_Con_Int;
+    IdSpan m_intersections1 = find_all_street_intersections_span(street_id1);
+    IdSpan m_intersections2 = find_all_street_intersections_span(street_id2);
     
-    for(int i = 0; i < int(g_m1_data->street_properties[street_id1].street_intersections.size()); i++){
+    IdSpan m_small = m_intersections1.size <= m_intersections2.size ? m_intersections1 : m_intersections2;
+    IdSpan m_large = m_intersections1.size <= m_intersections2.size ? m_intersections2 : m_intersections1;
+    
+    if(m_large.size > GALLOP_RATIO*m_small.size){
         
-        for(int j = 0; j < int(g_m1_data->street_properties[street_id2].street_intersections.size()); j++){
+        //Very unequal sizes: gallop through the long list for each id of the short one
+        const unsigned *m_low = m_large.begin();
+        for(unsigned m_id : m_small){
             
-            if(g_m1_data->street_properties[street_id1].street_intersections[i]==g_m1_data->street_properties[street_id2].street_intersections[j]){
-                m_temp_Con_Int.push_back(g_m1_data->street_properties[street_id1].street_intersections[i]);
+            //Double the step until it passes the id, then binary search the last step
+            unsigned m_step = 1;
+            while(m_step <= unsigned(m_large.end()-m_low) && m_low[m_step-1] < m_id){
+                m_step *= 2;
+            }
+            const unsigned *m_high = m_low + std::min(m_step, unsigned(m_large.end()-m_low));
+            m_low = std::lower_bound(m_low + m_step/2, m_high, m_id);
+            
+            if(m_low == m_large.end()){
+                break;
+            }
+            if(*m_low == m_id){
+                m_temp_Con_Int.push_back(m_id);
+            }
+        }
+    }else{
+        
+        //Linear merge of the two sorted lists
+        unsigned i = 0, j = 0;
+        while(i < m_intersections1.size && j < m_intersections2.size){
+            if(m_intersections1[i] < m_intersections2[j]){
+                i++;
+            }else if(m_intersections2[j] < m_intersections1[i]){
+                j++;
+            }else{
+                m_temp_Con_Int.push_back(m_intersections1[i]);
+                i++;
+                j++;
             }
         }
     }
@@ -247,7 +361,7 @@ double find_distance_between_two_points(LatLon point1, LatLon point2){
     double m_y2 = point2.lat()* DEG_TO_RAD;
     
     //Calculate and return the distance between the two points
-    double m_distance = EARTH_RADIUS_IN_METERS * sqrt(pow((m_y2-m_y1),2.0) + pow((m_x2-m_x1),2.0));    
+    double m_distance = EARTH_RADIUS_IN_METERS * sqrt((m_y2-m_y1)*(m_y2-m_y1) + (m_x2-m_x1)*(m_x2-m_x1));    
     
     return m_distance;
     
@@ -275,42 +389,101 @@ double find_street_segment_travel_time(unsigned street_segment_id){
 //Returns the nearest point of interest to the given position
 unsigned find_closest_point_of_interest(LatLon my_position){
     
-    int m_index_of_closest_POI = 0;
-    double m_min_distance = find_distance_between_two_points(getPointOfInterestPosition(0), my_position);
+    //Exact nearest neighbour search of the POI k-d tree
+    return g_m1_data->poi_index.nearest(my_position);
+}
 
-    //loop around all set of distances between every POI with my_position
-    //find the index of the POI with the closest distance from my_position
-    for(int i = 1; i < getNumPointsOfInterest(); i++){
-        
-        double m_distance = find_distance_between_two_points(getPointOfInterestPosition(i), my_position);
-        if(m_min_distance > m_distance){
-            m_index_of_closest_POI = i;
-            m_min_distance = m_distance;
-        }
+//Returns the POI index for a type, nullptr if no POI has that type
+const PointIndex *find_poi_index(const std::string &type){
+    
+    if(type == ANY_POI_TYPE){
+        return &g_m1_data->poi_index;
     }
+    std::map<unsigned, PointIndex>::const_iterator m_found = g_m1_data->poi_type_index.find(name_pool.find(type));
+    return m_found == g_m1_data->poi_type_index.end() ? nullptr : &m_found->second;
+}
+
+//Returns the nearest point of interest of the given type
+unsigned find_closest_point_of_interest_of_type(LatLon my_position, std::string type){
+    
+    const PointIndex *m_index = find_poi_index(type);
+    return m_index ? m_index->nearest(my_position) : NO_POI;
+}
+
+//Returns the k nearest points of interest of the given type
+std::vector<unsigned> find_k_closest_points_of_interest(LatLon my_position, unsigned k, std::string type){
     
-    return m_index_of_closest_POI;
+    const PointIndex *m_index = find_poi_index(type);
+    return m_index ? m_index->k_nearest(my_position, k) : std::vector<unsigned>();
+}
+
+//Returns all points of interest of the given type within radius meters
+std::vector<unsigned> find_points_of_interest_within_radius(LatLon my_position, double radius, std::string type){
+    
+    const PointIndex *m_index = find_poi_index(type);
+    return m_index ? m_index->within_radius(my_position, radius) : std::vector<unsigned>();
+}
+
+//Returns all points of interest of the given type inside the box
+std::vector<unsigned> find_points_of_interest_in_box(LatLon corner1, LatLon corner2, std::string type){
+    
+    const PointIndex *m_index = find_poi_index(type);
+    return m_index ? m_index->in_box(corner1, corner2) : std::vector<unsigned>();
 }
 
 //Returns the nearest intersection to the given position
 unsigned find_closest_intersection(LatLon my_position){
     
-    int m_index_of_closest_intersection = 0;
-    double m_min_distance = find_distance_between_two_points(getIntersectionPosition(0), my_position);
+    //Exact nearest neighbour search of the intersection k-d tree
+    return g_m1_data->intersection_index.nearest(my_position);
+    
+}
 
-    //loop around all set of distances between every intersection with my_position
-    //find the index of the intersection with the closest distance from my_position
-    for(int i = 1; i < getNumIntersections(); i++){
-        
-        double m_distance = find_distance_between_two_points(getIntersectionPosition(i), my_position);
-        if(m_min_distance > m_distance){
-            m_index_of_closest_intersection = i;
-            m_min_distance = m_distance;
-        }
+//Returns the nearest intersection to each of the given positions
+std::vector<unsigned> find_closest_intersections(const std::vector<LatLon> &positions){
+    
+    return g_m1_data->intersection_index.nearest(positions);
+}
+
+//Returns the points of interest whose name matches every word of query
+std::vector<unsigned> find_points_of_interest_by_name(std::string query){
+    
+    return g_m1_data->poi_name_index.find(query);
+}
+
+//Returns the intersections whose name matches every word of query
+std::vector<unsigned> find_intersections_by_name(std::string query){
+    
+    return g_m1_data->intersection_name_index.find(query);
+}
+
+//Returns find_points_of_interest_by_name() of each of the given queries
+std::vector<std::vector<unsigned> > find_points_of_interest_by_names(const std::vector<std::string> &queries){
+    
+    std::vector<std::vector<unsigned> > m_found(queries.size());
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(unsigned i = 0; i < queries.size(); i++){
+        m_found[i] = g_m1_data->poi_name_index.find(queries[i]);
     }
+    return m_found;
+}
+
+//Returns find_intersections_by_name() of each of the given queries
+std::vector<std::vector<unsigned> > find_intersections_by_names(const std::vector<std::string> &queries){
     
-    return m_index_of_closest_intersection;
+    std::vector<std::vector<unsigned> > m_found(queries.size());
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(unsigned i = 0; i < queries.size(); i++){
+        m_found[i] = g_m1_data->intersection_name_index.find(queries[i]);
+    }
+    return m_found;
+}
+
+//Returns the closest point on any street segment
+SegmentProjection find_closest_street_segment(LatLon my_position){
     
+    //Best first search of the segment R-tree
+    return segment_index.nearest(my_position);
 }
 
 //Returns all street ids corresponding to street names that start with the given prefix
@@ -325,19 +498,101 @@ std::vector<unsigned> find_street_ids_from_partial_street_name(std::string stree
         return m_empty;
     }
     
-    //Move through the names trie structure according to the street_prefix's characters
-    //Returns an empty vector if no names contain the prefix
-    Name* current = g_m1_data->head;
-    for(int i=0; i<int(street_prefix.length()); i++){
-        char m_character = tolower(street_prefix[i]);
-        if(current->names.count(m_character)){
-            current = current->names[m_character];
-        }else{
-            return m_empty;
+    //Walk the names trie to the node covering the prefix and copy out its
+    //range of streets, which are ordered by name
+    IdSpan m_streets = g_m1_data->street_name_trie.find_prefix(street_prefix);
+    return std::vector<unsigned>(m_streets.begin(), m_streets.end());
+    
+}
+
+//Returns the k best ranked distinct street names starting with the prefix
+std::vector<unsigned> find_top_street_ids_from_partial_street_name(std::string street_prefix, unsigned k, StreetRank rank){
+    
+    if(street_prefix.empty()){
+        return std::vector<unsigned>();
+    }
+    
+    if(rank == StreetRank::SEGMENT_COUNT){
+        return g_m1_data->street_segment_ranking.top_k(g_m1_data->street_name_trie, street_prefix, k);
+    }
+    return g_m1_data->street_length_ranking.top_k(g_m1_data->street_name_trie, street_prefix, k);
+}
+
+//Street type abbreviations and the words they stand for
+static const std::map<std::string, std::string> street_abbreviations = {
+    {"st", "street"}, {"ave", "avenue"}, {"av", "avenue"}, {"rd", "road"},
+    {"blvd", "boulevard"}, {"dr", "drive"}, {"cres", "crescent"}, {"crt", "court"},
+    {"ct", "court"}, {"pl", "place"}, {"ln", "lane"}, {"hwy", "highway"},
+    {"pkwy", "parkway"}, {"sq", "square"}, {"trl", "trail"}, {"cir", "circle"},
+    {"terr", "terrace"}, {"gdns", "gardens"}
+};
+
+//Splits a street name into lower case words with periods removed
+static std::vector<std::string> street_name_words(const std::string &street_name){
+    
+    std::vector<std::string> m_words(1);
+    for(unsigned i = 0; i < street_name.size(); i++){
+        if(street_name[i] == ' '){
+            if(!m_words.back().empty()){
+                m_words.push_back("");
+            }
+        }else if(street_name[i] != '.'){
+            m_words.back().push_back(tolower(static_cast<unsigned char>(street_name[i])));
         }
     }
-    return current->street_ids;
+    if(m_words.back().empty()){
+        m_words.pop_back();
+    }
+    return m_words;
+}
+
+//Joins words with single spaces, spelling out abbreviations in the first count words
+static std::string join_street_name_words(const std::vector<std::string> &words, unsigned count){
+    
+    std::string m_name;
+    for(unsigned i = 0; i < words.size(); i++){
+        std::map<std::string, std::string>::const_iterator m_full = street_abbreviations.find(words[i]);
+        m_name += i == 0 ? "" : " ";
+        m_name += i < count && m_full != street_abbreviations.end() ? m_full->second : words[i];
+    }
+    return m_name;
+}
+
+std::string normalize_street_name(std::string street_name){
+    
+    std::vector<std::string> m_words = street_name_words(street_name);
+    return join_street_name_words(m_words, m_words.size());
+}
+
+std::vector<unsigned> find_street_ids_from_approximate_street_name(std::string street_prefix, unsigned k){
+    
+    //Count characters the way they are searched
+    unsigned m_length = normalize_street_name(street_prefix).size();
+    unsigned m_edits = m_length <= FUZZY_EXACT_LENGTH ? 0 : m_length <= FUZZY_ONE_EDIT_LENGTH ? 1 : 2;
+    return find_street_ids_from_approximate_street_name(street_prefix, k, m_edits);
+}
+
+std::vector<unsigned> find_street_ids_from_approximate_street_name(std::string street_prefix, unsigned k, unsigned max_edits){
+    
+    std::vector<std::string> m_words = street_name_words(street_prefix);
+    if(m_words.empty()){
+        return std::vector<unsigned>();
+    }
+    
+    //The last word may still be being typed ("st" on the way to "stanley"),
+    //so search it both as typed and spelled out unless a space follows it
+    bool m_last_complete = street_prefix.back() == ' ';
+    std::vector<std::string> m_queries(1, join_street_name_words(m_words, m_words.size()) + (m_last_complete ? " " : ""));
+    if(!m_last_complete && join_street_name_words(m_words, m_words.size()-1) != m_queries[0]){
+        m_queries.push_back(join_street_name_words(m_words, m_words.size()-1));
+    }
     
+    std::vector<NameMatch> m_matches;
+    for(unsigned i = 0; i < m_queries.size(); i++){
+        std::vector<NameMatch> m_query_matches = g_m1_data->normalized_street_name_trie.find_approximate_prefix_names(m_queries[i], max_edits);
+        m_matches.insert(m_matches.end(), m_query_matches.begin(), m_query_matches.end());
+    }
+    return g_m1_data->normalized_street_length_ranking.top_k(m_matches, k);
 }
 
 void load_intersections_streets(){
@@ -345,12 +600,18 @@ void load_intersections_streets(){
     std::vector<std::set<unsigned> > m_temp_Int_ID(getNumStreets());
     std::vector<std::set<unsigned> > m_temp_Str_Seg_ID(getNumStreets());
     node_list.resize(getNumIntersections());
+    
+    //Intern every street name once and store its id for street properties
+    for(int i = 0; i < getNumStreets(); i++){
+        g_m1_data->street_properties[i].street_name_id = name_pool.intern(getStreetName(i));
+    }
+    
     //Determines values to insert into intersection properties data structure and inserts if applicable
     for(int i = 0; i < getNumIntersections(); i++){
         
         //Resize temporary data structures to store street segment ids and street names
         g_m1_data->intersection_properties[i].street_segment_ids.resize(getIntersectionStreetSegmentCount(i));
-        g_m1_data->intersection_properties[i].street_names.resize(getIntersectionStreetSegmentCount(i));
+        g_m1_data->intersection_properties[i].street_name_ids.resize(getIntersectionStreetSegmentCount(i));
         
         //Create temporary set container to store unique connected intersections
         std::set<unsigned> m_temp_Con_Int;
@@ -364,30 +625,29 @@ void load_intersections_streets(){
             
             //Store segment id and street name to avoid repetitive function calls
             unsigned m_str_Seg_ID = getIntersectionStreetSegment(s, i);
-            unsigned m_str_ID = getInfoStreetSegment(m_str_Seg_ID).streetID;
+            unsigned m_str_ID = segment_table.street_id[m_str_Seg_ID];
+            unsigned m_from = segment_table.from[m_str_Seg_ID];
+            unsigned m_to = segment_table.to[m_str_Seg_ID];
             
             //Insert street segment and street name for intersection properties
             g_m1_data->intersection_properties[i].street_segment_ids[s] = m_str_Seg_ID;
-            g_m1_data->intersection_properties[i].street_names[s] = getStreetName(m_str_ID);
+            g_m1_data->intersection_properties[i].street_name_ids[s] = g_m1_data->street_properties[m_str_ID].street_name_id;
             
             //Temporarily store intersection id and street segment id for street properties
             m_temp_Int_ID[m_str_ID].insert(i);
             m_temp_Str_Seg_ID[m_str_ID].insert(m_str_Seg_ID);
             
-            //Store street name for street properties
-            g_m1_data->street_properties[m_str_ID].street_name = g_m1_data->intersection_properties[i].street_names[s];
-            
            
             //Stores unique intersection id if you come from the current intersection or to the current intersection on a two way street and update node with segment, intersection, and time
-            if(getInfoStreetSegment(m_str_Seg_ID).from == i){
-                m_temp_Con_Int.insert(getInfoStreetSegment(m_str_Seg_ID).to);
-                node_list[i].inter.push_back(getInfoStreetSegment(m_str_Seg_ID).to);
+            if(m_from == unsigned(i)){
+                m_temp_Con_Int.insert(m_to);
+                node_list[i].inter.push_back(m_to);
                 node_list[i].out_edge.push_back(m_str_Seg_ID);
                 node_list[i].time.push_back(find_street_segment_travel_time(m_str_Seg_ID));
             }
-            else if(!getInfoStreetSegment(m_str_Seg_ID).oneWay&&getInfoStreetSegment(m_str_Seg_ID).to == i){
-                m_temp_Con_Int.insert(getInfoStreetSegment(m_str_Seg_ID).from);
-                node_list[i].inter.push_back(getInfoStreetSegment(m_str_Seg_ID).from);
+            else if(!segment_table.one_way[m_str_Seg_ID]&&m_to == unsigned(i)){
+                m_temp_Con_Int.insert(m_from);
+                node_list[i].inter.push_back(m_from);
                 node_list[i].out_edge.push_back(m_str_Seg_ID);
                 node_list[i].time.push_back(find_street_segment_travel_time(m_str_Seg_ID));
             }
@@ -398,58 +658,158 @@ void load_intersections_streets(){
         g_m1_data->intersection_properties[i].connected_intersections.assign(m_temp_Con_Int.begin(),m_temp_Con_Int.end());
     }
     
-    //Move through all streets and inserts them into names trie structure and
-    //inserts temporary data structure contents into street properties structure
+    //Inserts temporary data structure contents into street properties structure
+    std::vector<std::string> m_street_names(g_m1_data->street_properties.size());
+    std::vector<double> m_street_lengths(g_m1_data->street_properties.size());
+    std::vector<double> m_street_segment_counts(g_m1_data->street_properties.size());
     for(int i=0; i< int(g_m1_data->street_properties.size()); i++){
         
         //Insert temporary structure contents into street properties structure
         g_m1_data->street_properties[i].street_segments.assign(m_temp_Str_Seg_ID[i].begin(),m_temp_Str_Seg_ID[i].end());
         g_m1_data->street_properties[i].street_intersections.assign(m_temp_Int_ID[i].begin(),m_temp_Int_ID[i].end());
+        m_street_names[i] = name_pool.get(g_m1_data->street_properties[i].street_name_id);
+        m_street_lengths[i] = g_m1_data->street_properties[i].length;
+        m_street_segment_counts[i] = g_m1_data->street_properties[i].street_segments.size();
+    }
+    
+    //Build the street names trie and its autocomplete rankings
+    g_m1_data->street_name_trie.build(m_street_names);
+    g_m1_data->street_length_ranking.build(g_m1_data->street_name_trie, m_street_lengths);
+    g_m1_data->street_segment_ranking.build(g_m1_data->street_name_trie, m_street_segment_counts);
+    
+    //Build the normalized names trie used by the approximate search
+    for(unsigned i = 0; i < m_street_names.size(); i++){
+        m_street_names[i] = normalize_street_name(m_street_names[i]);
+    }
+    g_m1_data->normalized_street_name_trie.build(m_street_names);
+    g_m1_data->normalized_street_length_ranking.build(g_m1_data->normalized_street_name_trie, m_street_lengths);
+}
+
+//Reads every street segment from the database once into the packed segment table
+void load_segment_table(){
+    
+    unsigned m_num_segments = getNumStreetSegments();
+    segment_table.from.resize(m_num_segments);
+    segment_table.to.resize(m_num_segments);
+    segment_table.street_id.resize(m_num_segments);
+    segment_table.one_way.resize(m_num_segments);
+    segment_table.speed_limit.resize(m_num_segments);
+    segment_table.way_osmid.resize(m_num_segments);
+    segment_table.curve_offset.resize(m_num_segments+1);
+    
+    unsigned m_curve_offset = 0;
+    for(unsigned s = 0; s < m_num_segments; s++){
+        InfoStreetSegment m_info = getInfoStreetSegment(s);
         
-        //Move through characters of street name to insert into trie
-        Name* m_current= g_m1_data->head;
-	for(int j = 0; j < int(g_m1_data->street_properties[i].street_name.length()); j++){
-            char c = tolower(g_m1_data->street_properties[i].street_name[j]);
-            
-            //Create new branch if branch doesn't exist
-            if(!m_current->names.count(c)){
-		Name *tempConInt = new Name();
-		m_current->names.insert({c,tempConInt});
-            }
-            
-            //Move to corresponding branch and store street id
-            m_current = m_current->names[c];
-            m_current->street_ids.push_back(i);
-	}
+        segment_table.from[s] = m_info.from;
+        segment_table.to[s] = m_info.to;
+        segment_table.street_id[s] = m_info.streetID;
+        segment_table.one_way[s] = m_info.oneWay;
+        segment_table.speed_limit[s] = m_info.speedLimit;
+        segment_table.way_osmid[s] = m_info.wayOSMID;
+        segment_table.curve_offset[s] = m_curve_offset;
+        m_curve_offset += m_info.curvePointCount;
+    }
+    segment_table.curve_offset[m_num_segments] = m_curve_offset;
+    
+    //Project all polylines about the middle latitude of the map
+    double m_lat_min = getIntersectionPosition(0).lat();
+    double m_lat_max = m_lat_min;
+    for(int i = 1; i < getNumIntersections(); i++){
+        m_lat_min = std::min(m_lat_min, getIntersectionPosition(i).lat());
+        m_lat_max = std::max(m_lat_max, getIntersectionPosition(i).lat());
+    }
+    segment_table.ref_cos = cos((m_lat_min+m_lat_max)/2.0*DEG_TO_RAD);
+    
+    //Fill the geometry buffer with from, curve points, and to of every segment
+    segment_table.points.resize(m_curve_offset+2*m_num_segments);
+    for(unsigned s = 0; s < m_num_segments; s++){
+        unsigned m_point = segment_table.point_begin(s);
+        LatLon m_position = getIntersectionPosition(segment_table.from[s]);
+        segment_table.points[m_point++] = {segment_table.project_x(m_position.lon()), segment_table.project_y(m_position.lat())};
+        
+        for(int i = 0; i < segment_table.curve_point_count(s); i++){
+            m_position = getStreetSegmentCurvePoint(i, s);
+            segment_table.points[m_point++] = {segment_table.project_x(m_position.lon()), segment_table.project_y(m_position.lat())};
+        }
+        
+        m_position = getIntersectionPosition(segment_table.to[s]);
+        segment_table.points[m_point] = {segment_table.project_x(m_position.lon()), segment_table.project_y(m_position.lat())};
     }
 }
 
+//Builds the k-d tree used by find_closest_intersection() and the position arrays used by A*
+void load_intersection_index(){
+    
+    std::vector<LatLon> m_positions(getNumIntersections());
+    for(int i = 0; i < getNumIntersections(); i++){
+        m_positions[i] = getIntersectionPosition(i);
+    }
+    g_m1_data->intersection_index.build(m_positions);
+    intersection_points = PointArray(m_positions);
+}
+
+//Builds the k-d trees over all points of interest and over each POI type
+void load_poi_index(){
+    
+    std::vector<LatLon> m_positions(getNumPointsOfInterest());
+    std::map<unsigned, std::vector<unsigned> > m_type_ids;
+    for(int i = 0; i < getNumPointsOfInterest(); i++){
+        m_positions[i] = getPointOfInterestPosition(i);
+        m_type_ids[name_pool.intern(getPointOfInterestType(i))].push_back(i);
+    }
+    g_m1_data->poi_index.build(m_positions);
+    
+    for(std::map<unsigned, std::vector<unsigned> >::iterator i = m_type_ids.begin(); i != m_type_ids.end(); i++){
+        std::vector<LatLon> m_type_positions(i->second.size());
+        for(unsigned j = 0; j < i->second.size(); j++){
+            m_type_positions[j] = m_positions[i->second[j]];
+        }
+        g_m1_data->poi_type_index[i->first].build(m_type_positions, i->second);
+    }
+}
+
+//Builds the R-tree over segment geometry used for snapping and map matching
+void load_segment_index(){
+    
+    segment_index.build();
+}
+
+//Builds the word indices used by the point of interest and intersection name searches
+void load_name_indices(){
+    
+    std::vector<std::string> m_names(getNumPointsOfInterest());
+    for(int i = 0; i < getNumPointsOfInterest(); i++){
+        m_names[i] = getPointOfInterestName(i);
+    }
+    g_m1_data->poi_name_index.build(m_names);
+    
+    m_names.resize(getNumIntersections());
+    for(int i = 0; i < getNumIntersections(); i++){
+        m_names[i] = getIntersectionName(i);
+    }
+    g_m1_data->intersection_name_index.build(m_names);
+}
+
 void load_street_segments(){
     
     max_speed=0;
     //Move through all street segments to calculate distance time properties
     for(int s=0; s< getNumStreetSegments(); s++){
-        max_speed=std::max(max_speed,getInfoStreetSegment(s).speedLimit/3.6);
+        max_speed=std::max(max_speed,segment_table.speed_limit[s]/3.6);
         
-        //Sum street segment distances of curve point segments
+        //Sum street segment distances of curve point segments from the geometry buffer
         double m_length = 0;
-    
-        LatLon m_start = getIntersectionPosition(getInfoStreetSegment(s).from);
-        LatLon m_end;
-
-        for(int i = 0; i < getInfoStreetSegment(s).curvePointCount; i++){
-            m_end = getStreetSegmentCurvePoint(i, s);
-            m_length += find_distance_between_two_points(m_start,m_end);
-            m_start = m_end;
+        for(unsigned p = segment_table.point_begin(s); p+1 < segment_table.point_end(s); p++){
+            double m_dx, m_dy;
+            segment_table.point_delta(p, p+1, m_dx, m_dy);
+            m_length += EARTH_RADIUS_IN_METERS * sqrt(m_dy*m_dy + m_dx*m_dx);
         }
-
-        m_end = getIntersectionPosition(getInfoStreetSegment(s).to);
-        m_length += find_distance_between_two_points(m_start,m_end);
         
         //Store length and time into street segments structure and add length to street length
         g_m1_data->street_segments[s].distance = m_length;
-        g_m1_data->street_segments[s].time = g_m1_data->street_segments[s].distance/getInfoStreetSegment(s).speedLimit*3.6;
-        g_m1_data->street_properties[getInfoStreetSegment(s).streetID].length += m_length;
+        g_m1_data->street_segments[s].time = g_m1_data->street_segments[s].distance/segment_table.speed_limit[s]*3.6;
+        g_m1_data->street_properties[segment_table.street_id[s]].length += m_length;
     }
 
 }
@@ -14,33 +14,94 @@
 #include "m3.h"
 #include "StreetsDatabaseAPI.h"
 #include "OSMDatabaseAPI.h"
+#include "segments.h"
+#include "names.h"
+#include "segment_route.h"
+#include "street_search.h"
+#include "token_index.h"
+#include "name_search.h"
+#include "box_index.h"
+#include "segment_index.h"
+#include "poi_search.h"
+#include "polyline_lod.h"
+#include "tile_cache.h"
+#include "tile_workers.h"
+#include "map_style.h"
+#include "label_placement.h"
 #include <cmath>
 #include <set>
 #include <map>
+#include <mutex>
 #include <iostream>
 #include <vector>
 #include <thread>
+#include <memory>
 #include <algorithm>
+#include <unordered_map>
 
 #define INTERSECTION_DOT_RADIUS 0.000001
 #define TEXT_POSTITION_OFFSET 0.000002
 
-//intersection struct that contains the name and the position to be drawn
+//Fraction of the visible world added on each side when culling, so wide
+//lines, icons and labels of items just out of view are still drawn
+#define CULL_MARGIN 0.1
+
+//Base map tiles are TILE_SIZE pixels square, with pyramid levels one zoom
+//step (3/5) apart starting from the scale of the first view. At most
+//TILE_CACHE_BYTES of tile images are kept
+#define TILE_SIZE 256
+#define TILE_CACHE_BYTES (256*1024*1024)
+
+//Labels are kept LABEL_PADDING_PIXELS apart, binned in LABEL_CELL_PIXELS
+//cells, and a street is labelled again only LABEL_REPEAT_PIXELS from its
+//other labels. Tiles look for street and POI labels up to LABEL_MARGIN_PIXELS
+//past their edges, and longer labels are not drawn
+#define LABEL_PADDING_PIXELS 3
+#define LABEL_CELL_PIXELS 64
+#define LABEL_REPEAT_PIXELS 300
+#define LABEL_MARGIN_PIXELS (TILE_SIZE/2)
+
+//Number of ranked street names cycled through by the suggestion box
+#define STREET_SUGGESTION_COUNT 10
+
+//intersection struct that contains the interned name and the position to be drawn
 struct IntersectionData {
     LatLon position;
-    std::string name;
+    unsigned name_id;
 };
 
-//street segment struct with x, y, osmid, highway type, rotation angle, name, and length
+//road class of a segment from its OSM highway tag, links counting as their
+//road. streets come first, then highways (motorways and trunks)
+enum class RoadClass{
+    PRIMARY,
+    SECONDARY,
+    TERTIARY,
+    MINOR,
+    HIGHWAY
+};
+#define NUM_STREET_CLASSES 4
+#define NUM_ROAD_CLASSES 5
+
+//category of a POI type, for the types that have an icon
+enum class POICategory{
+    OTHER,
+    HOSPITAL,
+    CAFE,
+    RESTAURANT,
+    BANK,
+    GAS,
+    STATION
+};
+
+//street segment struct with osmid, road class, one way flag, and interned street name
 struct SegmentData{
-    std::vector<double> x;
-    std::vector<double> y;
     unsigned int osmid;
-    std::string highway;
-    std::vector<double> angle;
+    RoadClass road_class = RoadClass::MINOR;
     bool one_way;
-    std::string name;
-    std::vector<double> length;
+    unsigned name_id;
+
+    //first point of the segment's longest piece, where its name goes
+    unsigned label_point;
 };
 
 //OSM struct with OSMNodes, OSMWays, and OSMRelations
@@ -50,17 +111,6 @@ struct OSMData{
     std::map<OSMID, unsigned int> OSMRelations;
 };
 
-//bool struct the point of interests to be drawn onto the map
-struct POIBools{
-    bool hospital;
-    bool cafe;
-    bool restaurant;
-    bool bank;
-    bool gas;
-    bool station;
-    bool POI;
-};
-
 //feature struct that contains the type, names, location, and area
 struct FeatureData{
     FeatureType feature_type;
@@ -74,15 +124,46 @@ struct FeatureData{
 struct POIData{
     std::string name;
     std::string type;
+    POICategory category = POICategory::OTHER;
     ezgl::point2d location = {0,0};
 };
 
+//POI icons decoded once when the map is loaded and drawn every frame
+struct POIIcons{
+    ezgl::surface *hospital = nullptr;
+    ezgl::surface *cafe = nullptr;
+    ezgl::surface *restaurant = nullptr;
+    ezgl::surface *bank = nullptr;
+    ezgl::surface *gas = nullptr;
+    ezgl::surface *subway = nullptr;
+};
+
+//Labels of all the tiles of a pyramid level drawn for one zoom level, in that
+//level's pixels. Each label is placed or dropped once, by the first tile it
+//touches, and every other tile it touches draws it the same way, so labels
+//crossing tile edges are drawn whole and a street's repeats are spaced across
+//tiles. Tile workers hold mutex while placing
+struct LevelLabels{
+    std::mutex mutex;
+    LabelGrid grid{LABEL_CELL_PIXELS};
+
+    //Choice made for each label id: the place it was drawn at and its box, or
+    //-1 if it was dropped
+    struct Choice{
+        int place;
+        LabelBox box;
+    };
+    std::unordered_map<unsigned long long, Choice> choices;
+
+    //Centers of the names placed for each street
+    std::unordered_map<unsigned, std::vector<ezgl::point2d> > street_labels;
+};
+
 //superclass that contains globally used var
 struct M2_SuperClass{
 
     //map related
     double latMin, latMax, lonMin, lonMax;
-    int zoom_level;
     
     //modes
     bool night_mode_bool = false;
@@ -100,6 +181,13 @@ struct M2_SuperClass{
     ezgl::point2d found_intersection = {0.0,0.0};
     ezgl::point2d found_intersection_2 = {0.0,0.0};
 
+    //Route and end names for the clicked or found intersections, found by
+    //update_selection() when they change so the overlay only draws them
+    std::vector<unsigned> route;
+    unsigned clicked_name_id = 0;
+    unsigned clicked_name_id_2 = 0;
+    unsigned found_name_id_2 = 0;
+
     ezgl::point2d intersection_location = {0.0, 0.0};
 
     
@@ -108,6 +196,9 @@ struct M2_SuperClass{
     std::vector<unsigned> intersection_ids_1;
     std::vector<unsigned> intersection_ids_2;
 
+    //Results of find_intersection_ids_from_street_ids() for street pairs already searched
+    std::map<std::pair<int, int>, std::vector<unsigned> > street_pair_intersections;
+
     bool intersections_found_bool = false;
 
     int street1_id = -1;
@@ -128,17 +219,75 @@ struct M2_SuperClass{
     std::vector<FeatureData> features;
     std::vector<POIData> POIs;
 
+    //Word index over the names of POIs (including stations) for place search
+    TokenIndex place_name_index;
+
+    //R-tree over feature bounding boxes
+    BoxIndex feature_index;
+
+    //R-tree over the longest piece of each segment, where its labels go
+    BoxIndex label_index;
+
+    //Simplified segment polylines and feature outlines, one level per
+    //LOD_LEVELS, indexed like segment_table and features
+    PolylineLOD<SegmentPoint> segment_lod;
+    PolylineLOD<ezgl::point2d> feature_lod;
+
     POIBools POIChecks;
+    POIIcons POI_icons;
+
+    //Pre-rendered tiles of the base map. Cleared whenever anything drawn by
+    //draw_base_layer() changes style
+    TilePyramid tile_pyramid;
+    TileCache base_tiles{TILE_CACHE_BYTES};
+
+    //Labels of each pyramid level and zoom level tiles have been drawn for.
+    //Kept when tiles are dropped, so tiles drawn again agree with the rest
+    std::mutex level_labels_mutex;
+    std::map<std::pair<int, int>, std::unique_ptr<LevelLabels> > level_labels;
+
     std::vector<SegmentData> segments;
     std::vector<IntersectionData> intersections;
 
     std::vector<std::vector<ezgl::point2d> > subways;
     std::string directions;
     int img_count;
+
+    //Running application, for redrawing once tiles are rendered
+    ezgl::application *application = nullptr;
+
+    //Threads rendering base map tiles. Last, so they are stopped before the
+    //data they draw is destroyed
+    std::unique_ptr<TileWorkers> tile_workers;
 };
 
 M2_SuperClass *g_m2_data;
 
+//State of the map a thread is drawing: the zoom level it is drawn at and the
+//segments, features and POIs near its visible world. The GTK thread and each
+//tile worker draw with their own
+struct DrawState{
+    int zoom_level = 1;
+
+    //Style of the view being drawn
+    MapStyle style;
+
+    //Simplified geometry level for zoom_level, or -1 for full geometry
+    int lod_level = -1;
+
+    std::vector<unsigned> visible_class_segments[NUM_ROAD_CLASSES];
+    std::vector<unsigned> visible_features;
+    std::vector<unsigned> visible_POIs;
+
+    //Segments that may hold a label touching the visible world, by road class
+    std::vector<unsigned> label_class_segments[NUM_ROAD_CLASSES];
+
+    //Labels of the pyramid and zoom level of the tile being drawn
+    LevelLabels *labels = nullptr;
+};
+
+thread_local DrawState draw_state;
+
 //functions that will be used
 void act_on_mouse_press(ezgl::application *application, GdkEventButton *event, double x, double y);
 void act_on_mouse_move(ezgl::application *application, GdkEventButton *event, double x, double y);
@@ -173,7 +322,13 @@ void on_help_response(GtkDialog *dialog, gint response_id, gpointer user_data);
 void latlon_to_point(LatLon loc, double &x, double &y);
 void draw_clicked_intersection(ezgl::renderer &g);
 void find_intersections (ezgl::application * application);
+bool find_place(ezgl::application *application, std::string response);
+const std::vector<unsigned> &find_cached_intersection_ids(int street_id1, int street_id2);
 double dynamic_width_large_roads();
+RoadClass road_class_of(const std::string &highway);
+POICategory POI_category_of(const std::string &type);
+double road_width(RoadClass road_class);
+bool road_class_shown(RoadClass road_class, int check);
 double dynamic_width_small_roads();
 double lon_to_x(double lon);
 double lat_to_y(double lat);
@@ -186,28 +341,43 @@ void textbox3_changed (GtkEditable *editable, gpointer data);
 void textbox4_changed (GtkEditable *editable, gpointer data);
 
 void press_street_suggestions(GtkWidget *, gpointer data);
+std::vector<unsigned> suggest_street_ids(std::string response);
 
 void initialize_world();
 void load_POI_data();
 void load_OSM_data();
 void load_segments_data();
 void load_features_data();
+void load_LOD_geometry();
+void load_POI_icons();
+void free_POI_icons();
 
 void press_clear(GtkWidget *, gpointer data);
-void draw_path_between_intersections(ezgl::renderer &g, std::vector<unsigned> path);
+void draw_path_between_intersections(ezgl::renderer &g, const std::vector<unsigned> &path);
+void update_selection();
+void set_directions(const std::vector<unsigned> &path);
 
 void draw_feature(int check, ezgl::renderer &g);
 void draw_street_segments(int check, ezgl::renderer &g);
-void label_street_names(int check, ezgl::renderer &g);
+void label_street_names(int check, ezgl::renderer &g, LevelLabels &labels);
 void draw_highway_segments(ezgl::renderer &g);
-void label_highway_names(ezgl::renderer &g);
+void label_highway_names(ezgl::renderer &g, LevelLabels &labels);
+void label_segments(ezgl::renderer &g, LevelLabels &labels, const std::vector<unsigned> &segments, double font_size, ezgl::color arrow_color);
 void draw_subway_line(int check, ezgl::renderer &g);
 void draw_POIs(int check, ezgl::renderer &g);
+void find_visible_items(ezgl::renderer &g);
+void add_segment_polyline(ezgl::renderer &g, unsigned segment);
 
 
 //Draw to the main canvas using the provided graphics object.
 //The graphics object expects that x and y values will be in the main canvas' world coordinate system.
 void draw_main_canvas(ezgl::renderer &g);
+void draw_base_tiles(ezgl::renderer &g);
+void draw_base_layer(ezgl::renderer &g);
+ezgl::surface *render_base_tile(const TileRequest &request);
+gboolean redraw_finished_tiles(gpointer);
+void invalidate_base_layer();
+int LOD_level(int zoom);
 
 //This function initializes an ezgl application and runs it.
 void draw_map(){
@@ -232,7 +402,9 @@ void draw_map(){
     
     application.run(initial_setup, act_on_mouse_press, act_on_mouse_move, act_on_key_press);
     
-    //Free memory
+    //Free memory, stopping the tile workers before the icons they draw
+    g_m2_data->tile_workers.reset();
+    free_POI_icons();
     delete g_m2_data;
 }
 
@@ -240,6 +412,153 @@ void draw_main_canvas(ezgl::renderer &g){
     
     //get zoom_level whenever main canvas is drawn
     zoom_level(g);
+    draw_state.style.night_mode = g_m2_data->night_mode_bool;
+    draw_state.style.POI_checks = g_m2_data->POIChecks;
+    
+    //the static map comes from cached tiles; only the overlays below are drawn live
+    draw_base_tiles(g);
+    
+    //Draw ONE intersection based on click location.
+    //this happens ONLY IN SEARCH MODE
+    if(g_m2_data->clicked_on_an_Intersection_bool == true){
+        draw_clicked_intersection(g);
+    }
+
+    //Draw PATH between TWO clicked intersections. 
+    //this happens ONLY IN NAVIGATION MODE
+    if(g_m2_data->navigation_mode_bool == true && g_m2_data->clicked_on_second_Intersection_bool == true){
+        draw_path_between_intersections(g, g_m2_data->route);
+    }
+    
+    
+    //Draw ONE intersection based on find. 
+    //this happens ONLY IN SEARCH MODE
+    if(g_m2_data->draw_found_intersection_bool == true){
+        draw_found_intersection(g);
+    }
+    
+    //Draw PATH between TWO found intersections. 
+    //this happens ONLY IN NAVIGATION MODE
+    if(g_m2_data->navigation_mode_bool == true && g_m2_data->found_second_Intersection_bool == true){
+        g.set_color(ezgl::YELLOW);
+        g.fill_arc({g_m2_data->found_intersection_2.x,g_m2_data->found_intersection_2.y}, INTERSECTION_DOT_RADIUS, 0, 360);
+        draw_path_between_intersections(g, g_m2_data->route);
+        
+        if(draw_state.style.night_mode){
+                g.set_color(ezgl::WHITE);
+            }else{
+                g.set_color(ezgl::BLACK);
+            }
+        g.draw_text({g_m2_data->found_intersection_2.x,g_m2_data->found_intersection_2.y + TEXT_POSTITION_OFFSET}, name_pool.c_str(g_m2_data->found_name_id_2), 100, 200);
+        
+    }
+}
+
+//Draws the base map from tiles at the pyramid level nearest the view's
+//scale. Tiles not cached yet are requested from the tile workers, nearest
+//the center first, and stand in as the background colour and any cached
+//tiles of the neighbouring levels until they arrive
+void draw_base_tiles(ezgl::renderer &g){
+    
+    //take the tiles finished since the last frame
+    std::vector<std::pair<TileKey, ezgl::surface *> > finished = g_m2_data->tile_workers->take_finished();
+    for(unsigned i = 0; i < finished.size(); i++){
+        g_m2_data->base_tiles.insert(finished[i].first, finished[i].second);
+    }
+    
+    //the first view sets the scale of level 0
+    double scale = g.get_world_scale_factor().x;
+    if(!g_m2_data->tile_pyramid.valid()){
+        g_m2_data->tile_pyramid = TilePyramid(g_m2_data->initial_world.bottom_left(), scale, 3.0/5.0, TILE_SIZE);
+    }
+    
+    ezgl::rectangle visible = g.get_visible_world();
+    int level = g_m2_data->tile_pyramid.level_for(scale);
+    std::vector<TileKey> tiles = g_m2_data->tile_pyramid.tiles_in(visible, level);
+    std::vector<ezgl::surface *> cached(tiles.size());
+    std::vector<TileRequest> missing;
+    for(unsigned i = 0; i < tiles.size(); i++){
+        tiles[i].zoom_level = draw_state.zoom_level;
+        cached[i] = g_m2_data->base_tiles.find(tiles[i]);
+        if(cached[i] == nullptr){
+            missing.push_back({tiles[i], g_m2_data->tile_pyramid.tile_bounds(tiles[i]), draw_state.style});
+        }
+    }
+    
+    //placeholders go under the cached tiles, as neighbouring levels' tiles
+    //spill past the missing ones. A level apart is a zoom level apart, so
+    //they are looked up as drawn for the neighbouring zoom level
+    if(!missing.empty()){
+        g.set_color(draw_state.style.night_mode ? ezgl::N_BACKGROUND : ezgl::D_BACKGROUND);
+        g.fill_rectangle(visible);
+        std::set<std::pair<int, std::pair<int, int> > > drawn;
+        for(unsigned i = 0; i < missing.size(); i++){
+            for(int other = level-1; other <= level+1; other += 2){
+                std::vector<TileKey> stand_ins = g_m2_data->tile_pyramid.tiles_in(missing[i].bounds, other);
+                for(unsigned j = 0; j < stand_ins.size(); j++){
+                    stand_ins[j].zoom_level = draw_state.zoom_level+other-level;
+                    ezgl::surface *stand_in = g_m2_data->base_tiles.find(stand_ins[j]);
+                    if(stand_in != nullptr && drawn.insert({other, {stand_ins[j].x, stand_ins[j].y}}).second){
+                        g.draw_surface(stand_in, g_m2_data->tile_pyramid.tile_bounds(stand_ins[j]));
+                    }
+                }
+            }
+        }
+    }
+    for(unsigned i = 0; i < tiles.size(); i++){
+        if(cached[i] != nullptr){
+            g.draw_surface(cached[i], g_m2_data->tile_pyramid.tile_bounds(tiles[i]));
+        }
+    }
+    
+    //replacing the requests drops tiles of views already left
+    ezgl::point2d center = visible.center();
+    std::sort(missing.begin(), missing.end(), [center](const TileRequest &a, const TileRequest &b){
+        double a_x = a.bounds.center_x()-center.x, a_y = a.bounds.center_y()-center.y;
+        double b_x = b.bounds.center_x()-center.x, b_y = b.bounds.center_y()-center.y;
+        return a_x*a_x+a_y*a_y < b_x*b_x+b_y*b_y;
+    });
+    g_m2_data->tile_workers->request(missing);
+}
+
+//Renders a base map tile on a tile worker, drawn at the zoom level and in the
+//style of the view that requested it, with the labels of its level
+ezgl::surface *render_base_tile(const TileRequest &request){
+    draw_state.style = request.style;
+    draw_state.zoom_level = request.key.zoom_level;
+    draw_state.lod_level = LOD_level(request.key.zoom_level);
+    {
+        std::lock_guard<std::mutex> m_lock(g_m2_data->level_labels_mutex);
+        std::unique_ptr<LevelLabels> &labels = g_m2_data->level_labels[{request.key.level, request.key.zoom_level}];
+        if(labels == nullptr){
+            labels.reset(new LevelLabels());
+        }
+        draw_state.labels = labels.get();
+    }
+    return ezgl::renderer::render_to_image(draw_base_layer, request.bounds, TILE_SIZE, TILE_SIZE);
+}
+
+//Runs on the GTK main loop after tile workers finish tiles, to show them
+gboolean redraw_finished_tiles(gpointer){
+    if(g_m2_data != nullptr && g_m2_data->application != nullptr){
+        g_m2_data->application->refresh_drawing();
+    }
+    return FALSE;
+}
+
+//Drops the cached and in-flight tiles so the base map is rendered again in
+//its new style
+void invalidate_base_layer(){
+    g_m2_data->tile_workers->invalidate();
+    g_m2_data->base_tiles.clear();
+}
+
+//Draws the static map (features, roads, labels, subways and POIs) of the
+//renderer's visible world, at the zoom level of the main canvas' view
+void draw_base_layer(ezgl::renderer &g){
+    
+    //find what is on screen so the draw functions skip the rest of the map
+    find_visible_items(g);
 
     //Set two sets of color: one for regular mode, one for night mode
     ezgl::color BACKGROUND(0,0,0);
@@ -253,7 +572,7 @@ void draw_main_canvas(ezgl::renderer &g){
     ezgl::color STREETBORDER(0, 0, 0);
 
     //night mode color palette
-    if(g_m2_data->night_mode_bool){
+    if(draw_state.style.night_mode){
         BACKGROUND=ezgl::N_BACKGROUND;
         WATER=ezgl::N_WATER;
         BUILDING=ezgl::N_BUILDING;
@@ -282,83 +601,25 @@ void draw_main_canvas(ezgl::renderer &g){
     //use zoom level to determine 3 checkpoints
     //checkpoints (check) are used to determine what features are to be drawn
     int check=0;
-    if(g_m2_data->zoom_level >= 8){
+    if(draw_state.zoom_level >= 8){
         check=3;
-    }else if(g_m2_data->zoom_level>=6){
+    }else if(draw_state.zoom_level>=6){
         check=2;
     }
-    else if(g_m2_data->zoom_level >=3){
+    else if(draw_state.zoom_level >=3){
         check=1;
     }
     
     //using smaller functions to draw the entire map
+    //labels go on after all roads, highways first, so no road covers them
+    //and highway names win collisions with street names
     draw_feature(check, g);
     draw_street_segments(check, g);
-    label_street_names(check, g);
     draw_highway_segments(g);
-    label_highway_names(g);
+    label_highway_names(g, *draw_state.labels);
+    label_street_names(check, g, *draw_state.labels);
     draw_subway_line(check, g);
     draw_POIs(check, g);
-    
-    //Draw ONE intersection based on click location.
-    //this happens ONLY IN SEARCH MODE
-    if(g_m2_data->clicked_on_an_Intersection_bool == true){
-        draw_clicked_intersection(g);
-    }
-
-    //Draw PATH between TWO clicked intersections. 
-    //this happens ONLY IN NAVIGATION MODE
-    if(g_m2_data->navigation_mode_bool == true && g_m2_data->clicked_on_second_Intersection_bool == true){
-        
-        LatLon clicked_intersection_position(y_to_lat(g_m2_data->clicked_intersection.y),x_to_lon(g_m2_data->clicked_intersection.x));
-        LatLon clicked_intersection_position_2(y_to_lat(g_m2_data->clicked_intersection_2.y),x_to_lon(g_m2_data->clicked_intersection_2.x));
-        int int_clicked_id_1 = find_closest_intersection(clicked_intersection_position);
-        int int_clicked_id_2 = find_closest_intersection(clicked_intersection_position_2);
-        
-        std::vector<unsigned> path = find_path_between_intersections(int_clicked_id_1, int_clicked_id_2, 10, 20);
-        draw_path_between_intersections(g, path);
-        
-        g_m2_data->found_intersection = {0.0,0.0};
-        g_m2_data->found_intersection_2 = {0.0,0.0};    
-        g_m2_data->found_first_Intersection_bool = false;
-        g_m2_data->found_second_Intersection_bool = false;
-
-        g_m2_data->found_first_Intersection_bool = false;
-        g_m2_data->found_second_Intersection_bool = false;
-        g_m2_data->found_intersection = {0.0,0.0};
-        g_m2_data->found_intersection_2 = {0.0,0.0};
-        
-        g_m2_data->draw_found_intersection_bool = false;
-    }
-    
-    
-    //Draw ONE intersection based on find. 
-    //this happens ONLY IN SEARCH MODE
-    if(g_m2_data->draw_found_intersection_bool == true){
-        draw_found_intersection(g);
-    }
-    
-    //Draw PATH between TWO found intersections. 
-    //this happens ONLY IN NAVIGATION MODE
-    if(g_m2_data->navigation_mode_bool == true && g_m2_data->found_second_Intersection_bool == true){
-        LatLon found_intersection_position(y_to_lat(g_m2_data->found_intersection.y),x_to_lon(g_m2_data->found_intersection.x));
-        LatLon found_intersection_position_2(y_to_lat(g_m2_data->found_intersection_2.y),x_to_lon(g_m2_data->found_intersection_2.x));
-        int int_found_id_1 = find_closest_intersection(found_intersection_position);
-        int int_found_id_2 = find_closest_intersection(found_intersection_position_2);
-        
-        std::vector<unsigned> path = find_path_between_intersections(int_found_id_1, int_found_id_2, 10, 20);
-        g.set_color(ezgl::YELLOW);
-        g.fill_arc({g_m2_data->found_intersection_2.x,g_m2_data->found_intersection_2.y}, INTERSECTION_DOT_RADIUS, 0, 360);
-        draw_path_between_intersections(g, path);
-        
-        if(g_m2_data->night_mode_bool){
-                g.set_color(ezgl::WHITE);
-            }else{
-                g.set_color(ezgl::BLACK);
-            }
-        g.draw_text({g_m2_data->found_intersection_2.x,g_m2_data->found_intersection_2.y + TEXT_POSTITION_OFFSET}, g_m2_data->intersections[find_closest_intersection(found_intersection_position_2)].name, 100, 200);
-        
-    }
 }
 
 
@@ -367,6 +628,8 @@ void draw_main_canvas(ezgl::renderer &g){
 //or connect added widgets to their callback functions
 void initial_setup(ezgl::application *application)
 {
+  g_m2_data->application = application;
+  
   // Update the status bar message
   application->update_message("Map To Go Application");
   
@@ -471,18 +734,22 @@ void act_on_mouse_press(ezgl::application *application, GdkEventButton *, double
     //the program will allow users to click two intersections
     }else if(g_m2_data->navigation_mode_bool == true){
         
+        //Route ends snap to the closest point on a street segment so a route
+        //can start or end in the middle of a block
+        LatLon snapped_position = find_closest_street_segment(mouse_LatLon).position;
         if(g_m2_data->clicked_on_an_Intersection_bool == false){
-            g_m2_data->clicked_intersection.x = lon_to_x(getIntersectionPosition(find_closest_intersection(mouse_LatLon)).lon());
-            g_m2_data->clicked_intersection.y = lat_to_y(getIntersectionPosition(find_closest_intersection(mouse_LatLon)).lat());
+            g_m2_data->clicked_intersection.x = lon_to_x(snapped_position.lon());
+            g_m2_data->clicked_intersection.y = lat_to_y(snapped_position.lat());
            
             g_m2_data->clicked_on_an_Intersection_bool = true;
         }else if(g_m2_data->clicked_on_an_Intersection_bool == true){
-            g_m2_data->clicked_intersection_2.x = lon_to_x(getIntersectionPosition(find_closest_intersection(mouse_LatLon)).lon());
-            g_m2_data->clicked_intersection_2.y = lat_to_y(getIntersectionPosition(find_closest_intersection(mouse_LatLon)).lat());
+            g_m2_data->clicked_intersection_2.x = lon_to_x(snapped_position.lon());
+            g_m2_data->clicked_intersection_2.y = lat_to_y(snapped_position.lat());
             g_m2_data->clicked_on_second_Intersection_bool = true;
         }
     }
     
+    update_selection();
     application ->refresh_drawing();
 }
 
@@ -504,8 +771,9 @@ void act_on_key_press(ezgl::application *, GdkEventKey *, char *)
 }
 
 //convert lon to x
+//uses the projection of the segment geometry buffer so its points can be drawn directly
 double lon_to_x(double lon){
-    return lon*DEG_TO_RAD*cos((g_m2_data->latMin+g_m2_data->latMax)/2*DEG_TO_RAD);
+    return segment_table.project_x(lon);
 }
 
 //convert lat to y
@@ -515,7 +783,7 @@ double lat_to_y(double lat){
 
 //convert x to lon
 double x_to_lon(double x){
-    return x / (DEG_TO_RAD*cos((g_m2_data->latMin+g_m2_data->latMax)/2*DEG_TO_RAD));
+    return x / (DEG_TO_RAD*segment_table.ref_cos);
 }
 
 //convert y to lat
@@ -540,6 +808,7 @@ void press_night(GtkWidget *, gpointer data)
     gtk_switch_set_active(night_sw_ptr, !gtk_switch_get_active(night_sw_ptr));
     
     g_m2_data->night_mode_bool = gtk_switch_get_active(night_sw_ptr);
+    invalidate_base_layer();
   
     application->refresh_drawing();
 }
@@ -552,6 +821,7 @@ void press_hospital(GtkWidget *, gpointer data){
     GObject *menu_rev = application->get_object("HospitalCheck");
     GtkToggleButton * menu_rev_p=(GtkToggleButton *)menu_rev;
     g_m2_data->POIChecks.hospital=gtk_toggle_button_get_active(menu_rev_p);
+    invalidate_base_layer();
     application->refresh_drawing();
 }
 
@@ -563,6 +833,7 @@ void press_cafe(GtkWidget *, gpointer data){
     GObject *menu_rev = application->get_object("CafeCheck");
     GtkToggleButton * menu_rev_p=(GtkToggleButton *)menu_rev;
     g_m2_data->POIChecks.cafe=gtk_toggle_button_get_active(menu_rev_p);
+    invalidate_base_layer();
     application->refresh_drawing();
 }
 
@@ -574,6 +845,7 @@ void press_restaurant(GtkWidget *, gpointer data){
     GObject *menu_rev = application->get_object("RestaurantCheck");
     GtkToggleButton * menu_rev_p=(GtkToggleButton *)menu_rev;
     g_m2_data->POIChecks.restaurant=gtk_toggle_button_get_active(menu_rev_p);
+    invalidate_base_layer();
     application->refresh_drawing();
 }
 
@@ -585,6 +857,7 @@ void press_bank(GtkWidget *, gpointer data){
     GObject *menu_rev = application->get_object("BankCheck");
     GtkToggleButton * menu_rev_p=(GtkToggleButton *)menu_rev;
     g_m2_data->POIChecks.bank=gtk_toggle_button_get_active(menu_rev_p);
+    invalidate_base_layer();
     application->refresh_drawing();
 }
 
@@ -596,6 +869,7 @@ void press_gas(GtkWidget *, gpointer data){
     GObject *menu_rev = application->get_object("GasCheck");
     GtkToggleButton * menu_rev_p=(GtkToggleButton *)menu_rev;
     g_m2_data->POIChecks.gas=gtk_toggle_button_get_active(menu_rev_p);
+    invalidate_base_layer();
     application->refresh_drawing();
 }
 
@@ -607,6 +881,7 @@ void press_station(GtkWidget *, gpointer data){
     GObject *menu_rev = application->get_object("StationCheck");
     GtkToggleButton * menu_rev_p=(GtkToggleButton *)menu_rev;
     g_m2_data->POIChecks.station=gtk_toggle_button_get_active(menu_rev_p);
+    invalidate_base_layer();
     application->refresh_drawing();
 }
 
@@ -618,6 +893,7 @@ void press_POI(GtkWidget *, gpointer data){
     GObject *menu_rev = application->get_object("POICheck");
     GtkToggleButton * menu_rev_p=(GtkToggleButton *)menu_rev;
     g_m2_data->POIChecks.POI=gtk_toggle_button_get_active(menu_rev_p);
+    invalidate_base_layer();
     application->refresh_drawing();
 }
 
@@ -685,6 +961,8 @@ void press_find(GtkWidget *widget, gpointer data){
                 
 
                
+            } else if (response_2 == "" && find_place(application, response_1)){    // if an intersection or place has that name
+                application->update_message("Place found! View terminal for results.");
             } else {    // if streets are not found
                 application->update_message("Street 1 not found! Try again: ");
                 gtk_editable_delete_text(editable_find_1, 0, -1);
@@ -822,6 +1100,46 @@ void press_find(GtkWidget *widget, gpointer data){
     application->refresh_drawing();
  }
   
+//this function finds intersections, or failing that POIs and stations, whose
+//names contain the words of response and zooms to the first one found
+bool find_place(ezgl::application *application, std::string response){
+    std::string main_canvas_id = application->get_main_canvas_id();
+    auto canvas = application->get_canvas(main_canvas_id);
+    ezgl::point2d point(0,0);
+    
+    std::vector<unsigned> intersection_ids = find_intersections_by_name(response);
+    if(intersection_ids.size() != 0){
+        std::cout << "Printing found intersections: \n";
+        for(unsigned j = 0; j < intersection_ids.size(); j++){
+            std::cout << getIntersectionName(intersection_ids[j]) << "\n";
+        }
+        std::cout << "End of results\nPress 'Reset' to start searching again.\n";
+        
+        g_m2_data->intersection_ids_1 = intersection_ids;
+        g_m2_data->intersections_found_bool = true;
+        g_m2_data->draw_found_intersection_bool = true;
+        latlon_to_point(getIntersectionPosition(intersection_ids[0]), point.x, point.y);
+    } else {
+        std::vector<unsigned> place_ids = g_m2_data->place_name_index.find(response);
+        if(place_ids.size() == 0){
+            return false;
+        }
+        std::cout << "Printing found places: \n";
+        for(unsigned j = 0; j < place_ids.size(); j++){
+            std::cout << g_m2_data->POIs[place_ids[j]].name << " (" << g_m2_data->POIs[place_ids[j]].type << ")\n";
+        }
+        std::cout << "End of results\nPress 'Reset' to start searching again.\n";
+        
+        point = g_m2_data->POIs[place_ids[0]].location;
+    }
+    g_m2_data->found_intersection = point;
+    
+    //Autozoom to the first result
+    ezgl::zoom_in(canvas,sqrt(canvas->get_camera().get_world().area()/(pow((3.0/5.0),20)*canvas->get_camera().get_initial_world().area())));
+    ezgl::translate(canvas,point.x-canvas->get_camera().get_world().center_x(), point.y-canvas->get_camera().get_world().center_y());
+    return true;
+}
+
 //this function finds the intersections based on street names entered
 void find_intersections (ezgl::application * application){
     // now both streets are selected
@@ -832,7 +1150,7 @@ void find_intersections (ezgl::application * application){
     g_m2_data->found_intersection_2 = {0.0,0.0};  
     ezgl::point2d point(0,0);
     
-    g_m2_data->intersection_ids_1 = find_intersection_ids_from_street_ids(g_m2_data->street1_id, g_m2_data->street2_id);
+    g_m2_data->intersection_ids_1 = find_cached_intersection_ids(g_m2_data->street1_id, g_m2_data->street2_id);
 
     if(g_m2_data->intersection_ids_1.size() == 0){
         g_m2_data->intersections_found_bool = false;
@@ -859,7 +1177,7 @@ void find_intersections (ezgl::application * application){
         ezgl::translate(canvas,point1.x-canvas->get_camera().get_world().center_x(), point1.y-canvas->get_camera().get_world().center_y());
     }
     if ((g_m2_data->street3_id != -1) && (g_m2_data->street4_id != -1)){
-        g_m2_data->intersection_ids_2 = find_intersection_ids_from_street_ids(g_m2_data->street3_id, g_m2_data->street4_id);
+        g_m2_data->intersection_ids_2 = find_cached_intersection_ids(g_m2_data->street3_id, g_m2_data->street4_id);
 
         if(g_m2_data->intersection_ids_2.size() == 0){
             g_m2_data->intersections_found_bool = false;
@@ -888,6 +1206,29 @@ void find_intersections (ezgl::application * application){
             ezgl::translate(canvas,(point1.x+point2.x)/2.0-canvas->get_camera().get_world().center_x(), (point1.y+point2.y)/2.0-canvas->get_camera().get_world().center_y());
         }
     }
+    update_selection();
+}
+
+//returns the intersections of two streets, only searching each street pair once
+//the pair is stored in id order since the result doesn't depend on argument order
+const std::vector<unsigned> &find_cached_intersection_ids(int street_id1, int street_id2){
+    std::pair<int, int> key(std::min(street_id1, street_id2), std::max(street_id1, street_id2));
+    
+    auto found = g_m2_data->street_pair_intersections.find(key);
+    if(found == g_m2_data->street_pair_intersections.end()){
+        found = g_m2_data->street_pair_intersections.insert({key, find_intersection_ids_from_street_ids(key.first, key.second)}).first;
+    }
+    return found->second;
+}
+
+//Ranked streets starting with response, or if there are none the closest
+//names allowing for typos and abbreviations
+std::vector<unsigned> suggest_street_ids(std::string response){
+    std::vector<unsigned> m_street_ids = find_top_street_ids_from_partial_street_name(response, STREET_SUGGESTION_COUNT);
+    if(m_street_ids.empty()){
+        m_street_ids = find_street_ids_from_approximate_street_name(response, STREET_SUGGESTION_COUNT);
+    }
+    return m_street_ids;
 }
 
 // this function handles code for enabaling street name suggestions in the UI
@@ -902,7 +1243,7 @@ void press_street_suggestions(GtkWidget *, gpointer data){
     
     if (response != ""){
         g_m2_data->g_response = response;
-        g_m2_data->street_ids_found = find_street_ids_from_partial_street_name(response);
+        g_m2_data->street_ids_found = suggest_street_ids(response);
     
         if (g_m2_data->street_ids_found.size() != 0){
             std::string street_name = getStreetName(g_m2_data->street_ids_found[g_m2_data->count]);
@@ -951,7 +1292,8 @@ void textbox1_changed (GtkEditable *editable, gpointer data){
     g_m2_data->g_response = response;
     
     if (response != ""){
-        g_m2_data->street_ids_found = find_street_ids_from_partial_street_name(response);
+        g_m2_data->street_ids_found = suggest_street_ids(response);
+        g_m2_data->count = 0;
         
         if (g_m2_data->street_ids_found.size() != 0){
             std::string street_name = getStreetName(g_m2_data->street_ids_found[g_m2_data->count]);
@@ -984,7 +1326,8 @@ void textbox2_changed (GtkEditable *editable, gpointer data){
     g_m2_data->g_response = gtk_editable_get_chars(editable, 0, -1);
     
     if (g_m2_data->g_response != ""){
-        g_m2_data->street_ids_found = find_street_ids_from_partial_street_name(g_m2_data->g_response);
+        g_m2_data->street_ids_found = suggest_street_ids(g_m2_data->g_response);
+        g_m2_data->count = 0;
         
         if (g_m2_data->street_ids_found.size() != 0){
             std::string street_name = getStreetName(g_m2_data->street_ids_found[g_m2_data->count]);
@@ -1017,7 +1360,8 @@ void textbox3_changed (GtkEditable *editable, gpointer data){
         g_m2_data->g_response = gtk_editable_get_chars(editable, 0, -1);
     
         if (g_m2_data->g_response != ""){
-            g_m2_data->street_ids_found = find_street_ids_from_partial_street_name(g_m2_data->g_response);
+            g_m2_data->street_ids_found = suggest_street_ids(g_m2_data->g_response);
+            g_m2_data->count = 0;
 
             if (g_m2_data->street_ids_found.size() != 0){
                 std::string street_name = getStreetName(g_m2_data->street_ids_found[g_m2_data->count]);
@@ -1054,7 +1398,8 @@ void textbox4_changed (GtkEditable *editable, gpointer data){
         g_m2_data->g_response = gtk_editable_get_chars(editable, 0, -1);
     
         if (g_m2_data->g_response != ""){
-            g_m2_data->street_ids_found = find_street_ids_from_partial_street_name(g_m2_data->g_response);
+            g_m2_data->street_ids_found = suggest_street_ids(g_m2_data->g_response);
+            g_m2_data->count = 0;
 
             if (g_m2_data->street_ids_found.size() != 0){
                 std::string street_name = getStreetName(g_m2_data->street_ids_found[g_m2_data->count]);
@@ -1154,7 +1499,7 @@ void press_no(GtkWidget *, gpointer data){
 
             if (g_m2_data->g_response != ""){
                 
-                g_m2_data->street_ids_found = find_street_ids_from_partial_street_name(g_m2_data->g_response);
+                g_m2_data->street_ids_found = suggest_street_ids(g_m2_data->g_response);
                 std::string street_name = getStreetName(g_m2_data->street_ids_found[g_m2_data->count]);
 
 
@@ -1220,6 +1565,7 @@ void press_reset(GtkWidget *, gpointer data)
     g_m2_data->street2_id = -1;
     g_m2_data->street3_id = -1;
     g_m2_data->street4_id = -1;
+    update_selection();
     application->update_message("Reset successful. Type a street name to start searching: ");
     g_m2_data->draw_found_intersection_bool = false;
     application->refresh_drawing();
@@ -1294,6 +1640,7 @@ void press_navigate(GtkWidget *, gpointer data){
     g_m2_data->clicked_intersection_2 = {0.0,0.0};    
     g_m2_data->clicked_on_an_Intersection_bool = false;
     g_m2_data->clicked_on_second_Intersection_bool = false;
+    update_selection();
     
     
     if (gtk_toggle_button_get_active(menu_rev_p_navigate) == true){
@@ -1315,25 +1662,54 @@ void press_navigate(GtkWidget *, gpointer data){
     application->refresh_drawing();
 }
 
+//line width of a road class at the current zoom level; borders are 2 wider
+double road_width(RoadClass road_class){
+    switch(road_class){
+        case RoadClass::PRIMARY:
+            return 5 + dynamic_width_large_roads();
+        case RoadClass::SECONDARY:
+            return 4 + dynamic_width_large_roads();
+        case RoadClass::TERTIARY:
+            return 3 + dynamic_width_small_roads();
+        case RoadClass::HIGHWAY:
+            return 6 + dynamic_width_large_roads();
+        default:
+            return 2 + dynamic_width_small_roads();
+    }
+}
+
+//whether a road class is drawn at a zoom checkpoint (see draw_main_canvas)
+bool road_class_shown(RoadClass road_class, int check){
+    switch(road_class){
+        case RoadClass::HIGHWAY:
+            return true;
+        case RoadClass::PRIMARY:
+        case RoadClass::SECONDARY:
+            return check>=1;
+        default:
+            return check>=2;
+    }
+}
+
 //this function set an addition width to be added to the large road width
 //width size will be set based on the zoom level
 double dynamic_width_large_roads(){
     
-    if(g_m2_data->zoom_level == 4){
+    if(draw_state.zoom_level == 4){
         return 3;
-    }else if(g_m2_data->zoom_level == 5){
+    }else if(draw_state.zoom_level == 5){
         return 4;
-    }else if(g_m2_data->zoom_level == 6){
+    }else if(draw_state.zoom_level == 6){
         return 4;
-    }else if(g_m2_data->zoom_level == 7){
+    }else if(draw_state.zoom_level == 7){
         return 6;
-    }else if(g_m2_data->zoom_level == 8){
+    }else if(draw_state.zoom_level == 8){
         return 8;
-    }else if(g_m2_data->zoom_level == 9){
+    }else if(draw_state.zoom_level == 9){
         return 10; 
-    }else if(g_m2_data->zoom_level == 10){
+    }else if(draw_state.zoom_level == 10){
         return 14;
-    }else if(g_m2_data->zoom_level == 11){
+    }else if(draw_state.zoom_level == 11){
         return 18;
     }
     return 0;
@@ -1343,15 +1719,15 @@ double dynamic_width_large_roads(){
 //width size will be set based on the zoom level
 double dynamic_width_small_roads(){
     
-    if(g_m2_data->zoom_level == 7){
+    if(draw_state.zoom_level == 7){
         return 3;
-    }else if(g_m2_data->zoom_level == 8){
+    }else if(draw_state.zoom_level == 8){
         return 5;
-    }else if(g_m2_data->zoom_level == 9){
+    }else if(draw_state.zoom_level == 9){
         return 7; 
-    }else if(g_m2_data->zoom_level == 10){
+    }else if(draw_state.zoom_level == 10){
         return 8;
-    }else if(g_m2_data->zoom_level == 11){
+    }else if(draw_state.zoom_level == 11){
         return 12;
     }
 
@@ -1366,28 +1742,35 @@ void zoom_level(ezgl::renderer &g){
     //std::cout << "current area: " << g.get_visible_world().area() << std::endl;
     
     if(g.get_visible_world().area() >=  g_m2_data->initial_world.area()){
-        g_m2_data->zoom_level = 1;
+        draw_state.zoom_level = 1;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area() && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),2)){
-        g_m2_data->zoom_level = 2;
+        draw_state.zoom_level = 2;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area()*pow((3.0/5.0),2) && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),4)){
-        g_m2_data->zoom_level = 3;
+        draw_state.zoom_level = 3;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area()*pow((3.0/5.0),4) && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),6)){
-        g_m2_data->zoom_level = 4;
+        draw_state.zoom_level = 4;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area()*pow((3.0/5.0),6) && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),8)){
-        g_m2_data->zoom_level = 5;
+        draw_state.zoom_level = 5;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area()*pow((3.0/5.0),8) && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),10)){
-        g_m2_data->zoom_level = 6;
+        draw_state.zoom_level = 6;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area()*pow((3.0/5.0),10) && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),12)){
-        g_m2_data->zoom_level = 7;
+        draw_state.zoom_level = 7;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area()*pow((3.0/5.0),12) && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),14)){
-        g_m2_data->zoom_level = 8;
+        draw_state.zoom_level = 8;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area()*pow((3.0/5.0),14) && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),16)){
-        g_m2_data->zoom_level = 9;
+        draw_state.zoom_level = 9;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area()*pow((3.0/5.0),16) && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),18)){
-        g_m2_data->zoom_level = 10;
+        draw_state.zoom_level = 10;
     }else if(g.get_visible_world().area() < g_m2_data->initial_world.area()*pow((3.0/5.0),18) && g.get_visible_world().area() >= g_m2_data->initial_world.area()*pow((3.0/5.0),20)){
-        g_m2_data->zoom_level = 11;
+        draw_state.zoom_level = 11;
     }
+    
+    draw_state.lod_level = LOD_level(draw_state.zoom_level);
+}
+
+//Simplified geometry level drawn at a zoom level, or -1 for full geometry
+int LOD_level(int zoom){
+    return zoom <= 2*LOD_LEVELS ? (zoom-1)/2 : -1;
 }
 
 //this function draws the intersection that is clicked by the mouse
@@ -1396,32 +1779,28 @@ void draw_clicked_intersection(ezgl::renderer &g){
 
     //draw one intersection when not in navigation mode
     if(g_m2_data->navigation_mode_bool == false){
-        LatLon intersection_position(y_to_lat(g_m2_data->clicked_intersection.y),x_to_lon(g_m2_data->clicked_intersection.x));
-        
         g.set_text_rotation(0);
-        if(g_m2_data->zoom_level >= 7){
+        if(draw_state.zoom_level >= 7){
             g.set_color(ezgl::RED);
             g.fill_arc({g_m2_data->clicked_intersection.x, g_m2_data->clicked_intersection.y}, INTERSECTION_DOT_RADIUS, 0, 360);
 
-            if(g_m2_data->night_mode_bool){
+            if(draw_state.style.night_mode){
                 g.set_color(ezgl::WHITE);
             }else{
                 g.set_color(ezgl::BLACK);
             }
 
             g.set_font_size(15);
-            g.draw_text({g_m2_data->clicked_intersection.x,g_m2_data->clicked_intersection.y + TEXT_POSTITION_OFFSET}, g_m2_data->intersections[find_closest_intersection(intersection_position)].name, 100, 200);
+            g.draw_text({g_m2_data->clicked_intersection.x,g_m2_data->clicked_intersection.y + TEXT_POSTITION_OFFSET}, name_pool.c_str(g_m2_data->clicked_name_id), 100, 200);
 
-            //std::cout << "First intersection clicked:  " << g_m2_data->intersections[find_closest_intersection(intersection_position)].name << std::endl;
+            //std::cout << "First intersection clicked:  " << name_pool.get(g_m2_data->intersections[find_closest_intersection(intersection_position)].name_id) << std::endl;
         }
     //draw the two clicked intersections when in navigation mode    
     }else if(g_m2_data->navigation_mode_bool == true){
-        LatLon intersection_position(y_to_lat(g_m2_data->clicked_intersection.y),x_to_lon(g_m2_data->clicked_intersection.x));
         //std::cout << "(" << g_m2_data->clicked_intersection.x << ", " << g_m2_data->clicked_intersection.y << ")" << std::endl;
-        LatLon intersection_position_2(y_to_lat(g_m2_data->clicked_intersection_2.y),x_to_lon(g_m2_data->clicked_intersection_2.x));
         
         g.set_text_rotation(0);
-        if(g_m2_data->zoom_level >= 7){
+        if(draw_state.zoom_level >= 7){
             g.set_color(ezgl::RED);
             g.fill_arc({g_m2_data->clicked_intersection.x, g_m2_data->clicked_intersection.y}, INTERSECTION_DOT_RADIUS, 0, 360);
 
@@ -1429,23 +1808,23 @@ void draw_clicked_intersection(ezgl::renderer &g){
                 g.fill_arc({g_m2_data->clicked_intersection_2.x, g_m2_data->clicked_intersection_2.y}, INTERSECTION_DOT_RADIUS, 0, 360);
             }   
 
-            if(g_m2_data->night_mode_bool){
+            if(draw_state.style.night_mode){
                 g.set_color(ezgl::WHITE);
             }else{
                 g.set_color(ezgl::BLACK);
             }
 
             g.set_font_size(15);
-            g.draw_text({g_m2_data->clicked_intersection.x,g_m2_data->clicked_intersection.y + TEXT_POSTITION_OFFSET}, g_m2_data->intersections[find_closest_intersection(intersection_position)].name, 100, 200);
+            g.draw_text({g_m2_data->clicked_intersection.x,g_m2_data->clicked_intersection.y + TEXT_POSTITION_OFFSET}, name_pool.c_str(g_m2_data->clicked_name_id), 100, 200);
 
-            //std::cout << "First intersection clicked:  " << g_m2_data->intersections[find_closest_intersection(intersection_position)].name << std::endl;
+            //std::cout << "First intersection clicked:  " << name_pool.get(g_m2_data->intersections[find_closest_intersection(intersection_position)].name_id) << std::endl;
 
 
             if(g_m2_data->clicked_on_second_Intersection_bool == true){
-                g.draw_text({g_m2_data->clicked_intersection_2.x,g_m2_data->clicked_intersection_2.y + TEXT_POSTITION_OFFSET}, g_m2_data->intersections[find_closest_intersection(intersection_position_2)].name, 100, 200);
+                g.draw_text({g_m2_data->clicked_intersection_2.x,g_m2_data->clicked_intersection_2.y + TEXT_POSTITION_OFFSET}, name_pool.c_str(g_m2_data->clicked_name_id_2), 100, 200);
                             
                 //std::cout << "x:  " << g_m2_data->clicked_intersection_2.x << ". y: " << g_m2_data->clicked_intersection_2.y << std::endl; 
-                //std::cout << "Second intersection clicked:  " << g_m2_data->intersections[find_closest_intersection(intersection_position_2)].name << std::endl << std::endl;
+                //std::cout << "Second intersection clicked:  " << name_pool.get(g_m2_data->intersections[find_closest_intersection(intersection_position_2)].name_id) << std::endl << std::endl;
 
             }
         }
@@ -1473,13 +1852,13 @@ void draw_found_intersection(ezgl::renderer &g){
         g.set_color(ezgl::YELLOW);
         g.fill_arc({g_m2_data->intersection_location.x,g_m2_data->intersection_location.y}, INTERSECTION_DOT_RADIUS, 0, 360);
 
-        if(g_m2_data->night_mode_bool){
+        if(draw_state.style.night_mode){
             g.set_color(ezgl::WHITE);
         }else{
             g.set_color(ezgl::BLACK);
         }
         g.set_font_size(15);
-        g.draw_text({g_m2_data->intersection_location.x,g_m2_data->intersection_location.y + TEXT_POSTITION_OFFSET}, getIntersectionName(g_m2_data->intersection_ids_1[j]), 100, 200);
+        g.draw_text({g_m2_data->intersection_location.x,g_m2_data->intersection_location.y + TEXT_POSTITION_OFFSET}, name_pool.c_str(g_m2_data->intersections[g_m2_data->intersection_ids_1[j]].name_id), 100, 200);
     }
         
     //ezgl::renderer::free_surface(intersection_png);
@@ -1729,10 +2108,13 @@ void on_dialog_response(GtkDialog *dialog, gint response_id, gpointer user_data)
     // response_id is GTK_RESPONSE_DELETE_EVENT which
     // automatically closes the dialog without the following line.
     if(new_map!=""){
+        g_m2_data->tile_workers.reset();
+        free_POI_icons();
         delete g_m2_data;
         close_map();
         load_map(new_map);
         update_map();
+        g_m2_data->application = application;
         application->get_canvas(application->get_main_canvas_id())->get_camera().set_initial_world(g_m2_data->initial_world);
         application->get_canvas(application->get_main_canvas_id())->get_camera().set_world(g_m2_data->initial_world);
         GObject *night_sw = application->get_object("NightSwitch");
@@ -1776,8 +2158,22 @@ void update_map(){
     load_POI_data();
     load_OSM_data();
     
-    load_features_data();
+    //index the names of the POIs and stations for place search
+    std::vector<std::string> place_names(g_m2_data->POIs.size());
+    for(unsigned i = 0; i < g_m2_data->POIs.size(); i++){
+        place_names[i] = g_m2_data->POIs[i].name;
+    }
+    g_m2_data->place_name_index.build(place_names);
     
+    load_features_data();
+    load_LOD_geometry();
+    load_POI_icons();
+    
+    //render base map tiles on all but one core, leaving the GTK thread free
+    unsigned threads = std::thread::hardware_concurrency();
+    g_m2_data->tile_workers.reset(new TileWorkers(threads > 2 ? threads-1 : 1, render_base_tile, [](){
+        g_idle_add(redraw_finished_tiles, nullptr);
+    }));
 }
 
 //set initial world bound based on min/max of LatLon
@@ -1791,7 +2187,7 @@ void initialize_world(){
 
     for(int i = 0; i < getNumIntersections(); ++i){
         g_m2_data->intersections[i].position = getIntersectionPosition(i);
-        g_m2_data->intersections[i].name = getIntersectionName(i);
+        g_m2_data->intersections[i].name_id = name_pool.intern(getIntersectionName(i));
 
         g_m2_data->latMin=std::min(g_m2_data->latMin,g_m2_data->intersections[i].position.lat());
         g_m2_data->latMax=std::max(g_m2_data->latMax,g_m2_data->intersections[i].position.lat());
@@ -1811,12 +2207,86 @@ void initialize_world(){
     g_m2_data->initial_world.m_second={lon_to_x(g_m2_data->lonMax),lat_to_y(g_m2_data->latMax)};
 }
 
+//Builds the simplified segment and feature geometry drawn when zoomed out
+void load_LOD_geometry(){
+    std::vector<double> tolerances = LOD_tolerances(g_m2_data->initial_world.width());
+    
+    std::vector<unsigned> segment_begin(g_m2_data->segments.size()+1);
+    for(unsigned i = 0; i <= g_m2_data->segments.size(); i++){
+        segment_begin[i] = segment_table.point_begin(i);
+    }
+    g_m2_data->segment_lod.build(segment_table.points, segment_begin, tolerances);
+    
+    std::vector<ezgl::point2d> feature_points;
+    std::vector<unsigned> feature_begin;
+    for(unsigned i = 0; i < g_m2_data->features.size(); i++){
+        feature_begin.push_back(feature_points.size());
+        feature_points.insert(feature_points.end(), g_m2_data->features[i].points.begin(), g_m2_data->features[i].points.end());
+    }
+    feature_begin.push_back(feature_points.size());
+    g_m2_data->feature_lod.build(feature_points, feature_begin, tolerances);
+}
+
+//Decodes the POI icons once; draw_POIs() draws from them every frame
+void load_POI_icons(){
+    g_m2_data->POI_icons.hospital = ezgl::renderer::load_png("libstreetmap/resources/hospital.png");
+    g_m2_data->POI_icons.cafe = ezgl::renderer::load_png("libstreetmap/resources/cafe.png");
+    g_m2_data->POI_icons.restaurant = ezgl::renderer::load_png("libstreetmap/resources/restaurant.png");
+    g_m2_data->POI_icons.bank = ezgl::renderer::load_png("libstreetmap/resources/bank.png");
+    g_m2_data->POI_icons.gas = ezgl::renderer::load_png("libstreetmap/resources/gas.png");
+    g_m2_data->POI_icons.subway = ezgl::renderer::load_png("libstreetmap/resources/subway.png");
+}
+
+//Releases the surfaces decoded by load_POI_icons()
+void free_POI_icons(){
+    ezgl::renderer::free_surface(g_m2_data->POI_icons.hospital);
+    ezgl::renderer::free_surface(g_m2_data->POI_icons.cafe);
+    ezgl::renderer::free_surface(g_m2_data->POI_icons.restaurant);
+    ezgl::renderer::free_surface(g_m2_data->POI_icons.bank);
+    ezgl::renderer::free_surface(g_m2_data->POI_icons.gas);
+    ezgl::renderer::free_surface(g_m2_data->POI_icons.subway);
+    g_m2_data->POI_icons = POIIcons();
+}
+
+//resolves an OSM highway tag value to a road class
+RoadClass road_class_of(const std::string &highway){
+    if(highway=="primary"||highway=="primary_link"){
+        return RoadClass::PRIMARY;
+    }else if(highway=="secondary"||highway=="secondary_link"){
+        return RoadClass::SECONDARY;
+    }else if(highway=="tertiary"||highway=="tertiary_link"){
+        return RoadClass::TERTIARY;
+    }else if(highway=="motorway"||highway=="motorway_link"||highway=="trunk"||highway=="trunk_link"){
+        return RoadClass::HIGHWAY;
+    }
+    return RoadClass::MINOR;
+}
+
+//resolves a POI type to the category used to pick its icon
+POICategory POI_category_of(const std::string &type){
+    if(type=="hospital"){
+        return POICategory::HOSPITAL;
+    }else if(type=="cafe"){
+        return POICategory::CAFE;
+    }else if(type=="restaurant"){
+        return POICategory::RESTAURANT;
+    }else if(type=="bank"){
+        return POICategory::BANK;
+    }else if(type=="fuel"){
+        return POICategory::GAS;
+    }else if(type=="station"){
+        return POICategory::STATION;
+    }
+    return POICategory::OTHER;
+}
+
 //Determines values to insert into POI  data structure and inserts if applicable
 void load_POI_data(){
     g_m2_data->POIs.resize(getNumPointsOfInterest());
     for(int i = 0; i < getNumPointsOfInterest(); i++){
         g_m2_data->POIs[i].name=getPointOfInterestName(i);
         g_m2_data->POIs[i].type=getPointOfInterestType(i);
+        g_m2_data->POIs[i].category=POI_category_of(g_m2_data->POIs[i].type);
         latlon_to_point(getPointOfInterestPosition(i),g_m2_data->POIs[i].location.x,g_m2_data->POIs[i].location.y);
     }
 }
@@ -1840,6 +2310,7 @@ void load_OSM_data(){
                 }
                 
                 temp.type = "station";
+                temp.category = POICategory::STATION;
                 latlon_to_point(getNodeByIndex(i)->coords(), temp.location.x,temp.location.y);
                 g_m2_data->POIs.push_back(temp);
             }
@@ -1879,25 +2350,25 @@ void load_OSM_data(){
 //Determines values to insert into segments data structure and inserts if applicable
 void load_segments_data(){
     g_m2_data->segments.resize(getNumStreetSegments());
+    std::vector<Box> label_boxes(getNumStreetSegments());
     for(int i=0; i<getNumStreetSegments();i++){
-        g_m2_data->segments[i].x.resize(getInfoStreetSegment(i).curvePointCount+2);  // + 2 for the beginning and the end
-        g_m2_data->segments[i].y.resize(getInfoStreetSegment(i).curvePointCount+2);
-        g_m2_data->segments[i].name = getStreetName(getInfoStreetSegment(i).streetID);
-        g_m2_data->segments[i].one_way=getInfoStreetSegment(i).oneWay;
-        latlon_to_point(getIntersectionPosition(getInfoStreetSegment(i).from),g_m2_data->segments[i].x[0], g_m2_data->segments[i].y[0]);
-        latlon_to_point(getIntersectionPosition(getInfoStreetSegment(i).to),g_m2_data->segments[i].x[getInfoStreetSegment(i).curvePointCount+1], g_m2_data->segments[i].y[getInfoStreetSegment(i).curvePointCount+1]);
+        g_m2_data->segments[i].name_id = name_pool.intern(getStreetName(segment_table.street_id[i]));
+        g_m2_data->segments[i].one_way=segment_table.one_way[i];
         
-        for(int j=0; j<getInfoStreetSegment(i).curvePointCount; j++){
-            latlon_to_point(getStreetSegmentCurvePoint(j,i),g_m2_data->segments[i].x[j+1], g_m2_data->segments[i].y[j+1]);
-        }
-
-        for(unsigned int j=0; j<g_m2_data->segments[i].x.size()-1; j++){
-            g_m2_data->segments[i].length.push_back(sqrt(pow(g_m2_data->segments[i].y[j+1]-g_m2_data->segments[i].y[j],2)+pow(g_m2_data->segments[i].x[j+1]-g_m2_data->segments[i].x[j],2)));
-            g_m2_data->segments[i].angle.push_back(atan2(g_m2_data->segments[i].y[j+1]-g_m2_data->segments[i].y[j], g_m2_data->segments[i].x[j+1]-g_m2_data->segments[i].x[j]));
-
+        double longest = 0;
+        g_m2_data->segments[i].label_point = segment_table.point_begin(i);
+        for(unsigned j=segment_table.point_begin(i); j+1<segment_table.point_end(i); j++){
+            double length = hypot(segment_table.points[j+1].x-segment_table.points[j].x, segment_table.points[j+1].y-segment_table.points[j].y);
+            if(length > longest){
+                longest = length;
+                g_m2_data->segments[i].label_point = j;
+            }
         }
+        const SegmentPoint &label_from = segment_table.points[g_m2_data->segments[i].label_point];
+        const SegmentPoint &label_to = segment_table.points[std::min(g_m2_data->segments[i].label_point+1, segment_table.point_end(i)-1)];
+        label_boxes[i] = {std::min(label_from.x, label_to.x), std::min(label_from.y, label_to.y), std::max(label_from.x, label_to.x), std::max(label_from.y, label_to.y)};
         
-        g_m2_data->segments[i].osmid=g_m2_data->OSM_data.OSMWays[getInfoStreetSegment(i).wayOSMID];
+        g_m2_data->segments[i].osmid=g_m2_data->OSM_data.OSMWays[segment_table.way_osmid[i]];
 
         const OSMWay *temp = getWayByIndex(g_m2_data->segments[i].osmid);
         for(unsigned j=0;j<getTagCount(temp);j++){
@@ -1905,11 +2376,12 @@ void load_segments_data(){
            std::tie(key,value) = getTagPair(temp,j); 
 
            if(key=="highway"){
-               g_m2_data->segments[i].highway=value;
+               g_m2_data->segments[i].road_class=road_class_of(value);
                break;
            }
         }
     }
+    g_m2_data->label_index.build(label_boxes);
 }
 struct comp{
     bool operator()(FeatureData f1, FeatureData f2){
@@ -1950,6 +2422,19 @@ void load_features_data(){
         
     }
     std::sort(g_m2_data->features.begin(), g_m2_data->features.end(), comp());
+    
+    //index the features' bounding boxes in drawing order for culling
+    std::vector<Box> boxes(g_m2_data->features.size());
+    for(unsigned i = 0; i < g_m2_data->features.size(); i++){
+        boxes[i] = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+        for(unsigned j = 0; j < g_m2_data->features[i].points.size(); j++){
+            boxes[i].x_min = std::min(boxes[i].x_min, g_m2_data->features[i].points[j].x);
+            boxes[i].y_min = std::min(boxes[i].y_min, g_m2_data->features[i].points[j].y);
+            boxes[i].x_max = std::max(boxes[i].x_max, g_m2_data->features[i].points[j].x);
+            boxes[i].y_max = std::max(boxes[i].y_max, g_m2_data->features[i].points[j].y);
+        }
+    }
+    g_m2_data->feature_index.build(boxes);
 }
 
 //this function clears the values for the clicked intersections
@@ -1960,7 +2445,7 @@ void press_clear(GtkWidget *, gpointer data){
     g_m2_data->clicked_intersection_2 = {0.0,0.0};    
     g_m2_data->clicked_on_an_Intersection_bool = false;
     g_m2_data->clicked_on_second_Intersection_bool = false;
-    g_m2_data->directions="";
+    update_selection();
     
 
     GObject * dir=application->get_object("DirLabel");
@@ -1974,28 +2459,49 @@ void press_clear(GtkWidget *, gpointer data){
 
 }
 
-//This function draws a path on the map
-//Path will be the return value from the function find_path_between_intersections
-void draw_path_between_intersections(ezgl::renderer &g, std::vector<unsigned> path){
-    //for clicked intersections
+//Finds the route and the names drawn at its ends for the clicked or found
+//intersections. The event handlers that change them call this, so drawing
+//the overlay never searches and a new selection costs only a repaint
+void update_selection(){
     LatLon intersection_position(y_to_lat(g_m2_data->clicked_intersection.y),x_to_lon(g_m2_data->clicked_intersection.x));
     LatLon intersection_position_2(y_to_lat(g_m2_data->clicked_intersection_2.y),x_to_lon(g_m2_data->clicked_intersection_2.x));
-//    std::string main_canvas_id=g_m2_data->application->get_main_canvas_id();
-//    auto canvas = g_m2_data->application->get_canvas(main_canvas_id);
-//        ezgl::point2d point(0,0);
-//        point.x=(g_m2_data->clicked_intersection.x+g_m2_data->clicked_intersection_2.x)/2.0;
-//        point.y=(g_m2_data->clicked_intersection.y+g_m2_data->clicked_intersection_2.y)/2.0;
-//        
-//        ezgl::zoom_in(canvas,sqrt(canvas->get_camera().get_world().area()/(pow((3.0/5.0),20)*canvas->get_camera().get_initial_world().area())));
-//        ezgl::translate(canvas,point.x-canvas->get_camera().get_world().center_x(), point.y-canvas->get_camera().get_world().center_y());
-//        g_m2_data->application->refresh_drawing();
-    //corner case
-    if(path.size() == 0){
-        g_m2_data->directions="";
-        return;
+    if(g_m2_data->clicked_on_an_Intersection_bool == true){
+        g_m2_data->clicked_name_id = g_m2_data->intersections[find_closest_intersection(intersection_position)].name_id;
+    }
+    if(g_m2_data->clicked_on_second_Intersection_bool == true){
+        g_m2_data->clicked_name_id_2 = g_m2_data->intersections[find_closest_intersection(intersection_position_2)].name_id;
     }
+    
+    g_m2_data->route.clear();
+    if(g_m2_data->navigation_mode_bool == true && g_m2_data->clicked_on_second_Intersection_bool == true){
+        
+        SegmentProjection clicked_start = find_closest_street_segment(intersection_position);
+        SegmentProjection clicked_end = find_closest_street_segment(intersection_position_2);
+        g_m2_data->route = find_path_between_segment_points(clicked_start, clicked_end, 10, 20);
+        
+        //a clicked route replaces the found one
+        g_m2_data->found_first_Intersection_bool = false;
+        g_m2_data->found_second_Intersection_bool = false;
+        g_m2_data->found_intersection = {0.0,0.0};
+        g_m2_data->found_intersection_2 = {0.0,0.0};
+        
+        g_m2_data->draw_found_intersection_bool = false;
+    }else if(g_m2_data->navigation_mode_bool == true && g_m2_data->found_second_Intersection_bool == true){
+        LatLon found_intersection_position(y_to_lat(g_m2_data->found_intersection.y),x_to_lon(g_m2_data->found_intersection.x));
+        LatLon found_intersection_position_2(y_to_lat(g_m2_data->found_intersection_2.y),x_to_lon(g_m2_data->found_intersection_2.x));
+        int int_found_id_1 = find_closest_intersection(found_intersection_position);
+        int int_found_id_2 = find_closest_intersection(found_intersection_position_2);
+        
+        g_m2_data->route = find_path_between_intersections(int_found_id_1, int_found_id_2, 10, 20);
+        g_m2_data->found_name_id_2 = g_m2_data->intersections[int_found_id_2].name_id;
+    }
+    set_directions(g_m2_data->route);
+}
+
+//Writes the turn by turn directions for a path
+void set_directions(const std::vector<unsigned> &path){
+    g_m2_data->directions="";
     if(path.size()>0){
-        g_m2_data->directions="";
         int count = 1;
         //Goes through all path segments
         double distance =0;
@@ -2009,15 +2515,15 @@ void draw_path_between_intersections(ezgl::renderer &g, std::vector<unsigned> pa
             
             //Add appropriate turn penalty
             if(find_turn_type(path[i-1],path[i])==TurnType::RIGHT){
-                g_m2_data->directions += std::to_string(count)+". Head down "+getStreetName(getInfoStreetSegment(path[i-1]).streetID) + " for " +std::to_string(int(round(distance)))+ "m.\n";
+                g_m2_data->directions += std::to_string(count)+". Head down "+getStreetName(segment_table.street_id[path[i-1]]) + " for " +std::to_string(int(round(distance)))+ "m.\n";
                 count ++;
-                g_m2_data->directions += std::to_string(count) + ". Turn right onto " + getStreetName(getInfoStreetSegment(path[i]).streetID) + ".\n";
+                g_m2_data->directions += std::to_string(count) + ". Turn right onto " + getStreetName(segment_table.street_id[path[i]]) + ".\n";
                 count ++;
                 cont = false;
             }else if(find_turn_type(path[i-1],path[i])==TurnType::LEFT){
-                g_m2_data->directions += std::to_string(count)+". Head down "+getStreetName(getInfoStreetSegment(path[i-1]).streetID) + " for " +std::to_string(int(round(distance)))+ "m.\n";
+                g_m2_data->directions += std::to_string(count)+". Head down "+getStreetName(segment_table.street_id[path[i-1]]) + " for " +std::to_string(int(round(distance)))+ "m.\n";
                 count ++;
-                g_m2_data->directions += std::to_string(count) + ". " + "Turn left onto " + getStreetName(getInfoStreetSegment(path[i]).streetID) + ".\n";
+                g_m2_data->directions += std::to_string(count) + ". " + "Turn left onto " + getStreetName(segment_table.street_id[path[i]]) + ".\n";
                 count ++;
                 cont = false;
                 
@@ -2026,76 +2532,97 @@ void draw_path_between_intersections(ezgl::renderer &g, std::vector<unsigned> pa
             }
         }
         distance += find_street_segment_length(path[path.size()-1]);
-        g_m2_data->directions += std::to_string(count) + ". Head down "+getStreetName(getInfoStreetSegment(path[path.size()-1]).streetID) + " for " +std::to_string(int(round(distance)))+ "m.";
+        g_m2_data->directions += std::to_string(count) + ". Head down "+getStreetName(segment_table.street_id[path[path.size()-1]]) + " for " +std::to_string(int(round(distance)))+ "m.";
         
     }
-    if(g_m2_data->zoom_level >= 7){
-        for(unsigned int i = 0 ; i < path.size() ; i++){
-            
-            float id1, id2, x1, x2, y1, y2, x1_curve, x2_curve, y1_curve, y2_curve;
-
-            id1 = getInfoStreetSegment(path[i]).from;
-            id2 = getInfoStreetSegment(path[i]).to;
-
-
-            x1 = lon_to_x(g_m2_data->intersections[id1].position.lon());
-            x2 = lon_to_x(g_m2_data->intersections[id2].position.lon());
-
-            y1 = lat_to_y(g_m2_data->intersections[id1].position.lat());
-            y2 = lat_to_y(g_m2_data->intersections[id2].position.lat());
-
-            //for drawing curved streets
-            if(getInfoStreetSegment(path[i]).curvePointCount >= 1){
-
-                double first_point_x = lon_to_x(getStreetSegmentCurvePoint(0,path[i]).lon());
-                double second_point_x = lon_to_x(getStreetSegmentCurvePoint(getInfoStreetSegment(path[i]).curvePointCount-1,path[i]).lon());
-                double first_point_y =  lat_to_y(getStreetSegmentCurvePoint(0,path[i]).lat());
-                double second_point_y = lat_to_y(getStreetSegmentCurvePoint(getInfoStreetSegment(path[i]).curvePointCount-1,path[i]).lat());
-
-                //draw path
-                g.set_color(ezgl::color(0x7F, 0xD9, 0xF9));
-                g.set_line_width(8);
-                g.draw_line({x1, y1}, {first_point_x,first_point_y});
-                g.draw_line({x2, y2}, {second_point_x,second_point_y});
-
-                for(int j = 0 ; j < getInfoStreetSegment(path[i]).curvePointCount-1 ; j++){
-                    x1_curve = lon_to_x(getStreetSegmentCurvePoint(j,path[i]).lon());
-                    x2_curve = lon_to_x(getStreetSegmentCurvePoint(j+1,path[i]).lon());
-                    y1_curve = lat_to_y(getStreetSegmentCurvePoint(j,path[i]).lat());
-                    y2_curve = lat_to_y(getStreetSegmentCurvePoint(j+1,path[i]).lat());
-
-                    //Draw path
-                    g.set_color(ezgl::color(0x7F, 0xD9, 0xF9));
-                    g.set_line_width(8);
-                    g.draw_line({x1_curve, y1_curve}, {x2_curve, y2_curve});
-
-                }
+}
 
-            }else{
-                //Draw path
-                g.set_color(ezgl::color(0x7F, 0xD9, 0xF9));
-                g.set_line_width(8);
-                g.draw_line({x1, y1}, {x2, y2});
-            }
+//This function draws a path on the map
+//Path is the route found by update_selection()
+void draw_path_between_intersections(ezgl::renderer &g, const std::vector<unsigned> &path){
+    if(draw_state.zoom_level >= 7){
+        //Draw path along the segment polylines
+        g.set_color(ezgl::color(0x7F, 0xD9, 0xF9));
+        g.set_line_width(8);
+        for(unsigned int i = 0 ; i < path.size() ; i++){
+            add_segment_polyline(g, path[i]);
         }
+        g.stroke_polylines();
         
         //redraw the text so that names are at the top
         if(g_m2_data->clicked_on_second_Intersection_bool == true){
-            if(g_m2_data->night_mode_bool == true){
+            if(draw_state.style.night_mode == true){
                 g.set_color(ezgl::WHITE);
             }else{            
                 g.set_color(ezgl::BLACK);
             }
             g.set_font_size(15);
-            g.draw_text({g_m2_data->clicked_intersection.x,g_m2_data->clicked_intersection.y + TEXT_POSTITION_OFFSET}, g_m2_data->intersections[find_closest_intersection(intersection_position)].name, 100, 200);
-            g.draw_text({g_m2_data->clicked_intersection_2.x,g_m2_data->clicked_intersection_2.y + TEXT_POSTITION_OFFSET}, g_m2_data->intersections[find_closest_intersection(intersection_position_2)].name, 100, 200);
+            g.draw_text({g_m2_data->clicked_intersection.x,g_m2_data->clicked_intersection.y + TEXT_POSTITION_OFFSET}, name_pool.c_str(g_m2_data->clicked_name_id), 100, 200);
+            g.draw_text({g_m2_data->clicked_intersection_2.x,g_m2_data->clicked_intersection_2.y + TEXT_POSTITION_OFFSET}, name_pool.c_str(g_m2_data->clicked_name_id_2), 100, 200);
             
         }
     }
 }
 
+//Adds a segment's polyline, simplified for the zoom level, to the renderer's
+//batch; the caller strokes the batch once for all segments drawn in the same style
+void add_segment_polyline(ezgl::renderer &g, unsigned segment){
+    if(draw_state.lod_level >= 0){
+        g.add_polyline(g_m2_data->segment_lod.line(draw_state.lod_level, segment), g_m2_data->segment_lod.line_size(draw_state.lod_level, segment));
+    }else{
+        g.add_polyline(&segment_table.points[segment_table.point_begin(segment)], segment_table.point_end(segment)-segment_table.point_begin(segment));
+    }
+}
+
+//Finds the segments, features and POIs near the visible world from the
+//segment, feature and POI spatial indices
+void find_visible_items(ezgl::renderer &g){
+    ezgl::rectangle visible = g.get_visible_world();
+    double margin_x = visible.width()*CULL_MARGIN;
+    double margin_y = visible.height()*CULL_MARGIN;
+    Box view = {visible.left()-margin_x, visible.bottom()-margin_y, visible.right()+margin_x, visible.top()+margin_y};
+    
+    //bucket the visible segments by road class so each pass only visits its own
+    for(int c = 0; c < NUM_ROAD_CLASSES; c++){
+        draw_state.visible_class_segments[c].clear();
+    }
+    std::vector<unsigned> visible_segments = segment_index.in_box(view.x_min, view.y_min, view.x_max, view.y_max);
+    for(unsigned i = 0; i < visible_segments.size(); i++){
+        draw_state.visible_class_segments[int(g_m2_data->segments[visible_segments[i]].road_class)].push_back(visible_segments[i]);
+    }
+    
+    //a label is centered on its segment's longest piece, so labels touching
+    //the visible world lie on pieces within a label's half length of it
+    ezgl::point2d scale = g.get_world_scale_factor();
+    double label_x = LABEL_MARGIN_PIXELS*scale.x;
+    double label_y = LABEL_MARGIN_PIXELS*scale.y;
+    for(int c = 0; c < NUM_ROAD_CLASSES; c++){
+        draw_state.label_class_segments[c].clear();
+    }
+    std::vector<unsigned> label_candidates = g_m2_data->label_index.in_box({visible.left()-label_x, visible.bottom()-label_y, visible.right()+label_x, visible.top()+label_y});
+    for(unsigned i = 0; i < label_candidates.size(); i++){
+        draw_state.label_class_segments[int(g_m2_data->segments[label_candidates[i]].road_class)].push_back(label_candidates[i]);
+    }
+    draw_state.visible_features = g_m2_data->feature_index.in_box(view);
+    
+    //POIs from the database share their ids with m1's POI index; stations
+    //loaded from OSM follow them and are few, so they are checked directly.
+    //Names are centered on their POI, so POIs up to the label margin away
+    //may have names reaching into view
+    Box POI_view = {visible.left()-label_x, visible.bottom()-label_y, visible.right()+label_x, visible.top()+label_y};
+    draw_state.visible_POIs = find_points_of_interest_in_box(LatLon(y_to_lat(POI_view.y_min), x_to_lon(POI_view.x_min)),
+                                                             LatLon(y_to_lat(POI_view.y_max), x_to_lon(POI_view.x_max)));
+    std::sort(draw_state.visible_POIs.begin(), draw_state.visible_POIs.end());
+    for(unsigned i = getNumPointsOfInterest(); i < g_m2_data->POIs.size(); i++){
+        ezgl::point2d location = g_m2_data->POIs[i].location;
+        if(location.x >= POI_view.x_min && location.x <= POI_view.x_max && location.y >= POI_view.y_min && location.y <= POI_view.y_max){
+            draw_state.visible_POIs.push_back(i);
+        }
+    }
+}
+
 //draws the features onto the map
-//this is a function called inside draw_main_canvas
+//this is a function called inside draw_base_layer
 void draw_feature(int check, ezgl::renderer &g){
     //Set two sets of color: one for regular mode, one for night mode
     ezgl::color BACKGROUND(0,0,0);
@@ -2109,7 +2636,7 @@ void draw_feature(int check, ezgl::renderer &g){
     ezgl::color STREETBORDER(0, 0, 0);
 
     //night mode color palette
-    if(g_m2_data->night_mode_bool){
+    if(draw_state.style.night_mode){
         BACKGROUND=ezgl::N_BACKGROUND;
         WATER=ezgl::N_WATER;
         BUILDING=ezgl::N_BUILDING;
@@ -2133,7 +2660,8 @@ void draw_feature(int check, ezgl::renderer &g){
     }
     
     //setting colors and draw features
-    for(unsigned int i=0; i<g_m2_data->features.size(); i++){
+    for(unsigned int k=0; k<draw_state.visible_features.size(); k++){
+        unsigned int i = draw_state.visible_features[k];
         if(g_m2_data->features[i].feature_type==Lake){
             g.set_color(WATER); 
         }
@@ -2164,13 +2692,24 @@ void draw_feature(int check, ezgl::renderer &g){
         }
         if(!(g_m2_data->features[i].feature_type==Building&&check<2)){
             
-            //Draw depending on if data is polygon, line, or point
-            if(g_m2_data->features[i].points.size()>1){
+            //Outline simplified for the zoom level
+            const ezgl::point2d *points = g_m2_data->features[i].points.data();
+            unsigned point_count = g_m2_data->features[i].points.size();
+            if(draw_state.lod_level >= 0){
+                points = g_m2_data->feature_lod.line(draw_state.lod_level, i);
+                point_count = g_m2_data->feature_lod.line_size(draw_state.lod_level, i);
+            }
+            
+            //Draw depending on if data is polygon, line, or point.
+            //A polygon simplified to fewer than 3 corners is under a pixel across
+            if(point_count>1){
                 if(g_m2_data->features[i].closed){
-                    g.fill_poly(g_m2_data->features[i].points);
+                    if(point_count>3 || draw_state.lod_level<0){
+                        g.fill_poly(points, point_count);
+                    }
                 }else if(check>=2){
-                    for(unsigned int j=0; j<g_m2_data->features[i].points.size()-1;j++)
-                        g.draw_line(g_m2_data->features[i].points[j], g_m2_data->features[i].points[j+1]);
+                    g.add_polyline(points, point_count);
+                    g.stroke_polylines();
                 }
             }
         }
@@ -2178,7 +2717,7 @@ void draw_feature(int check, ezgl::renderer &g){
 }
 
 //draw the street segments onto the map
-//this is a function called inside draw_main_canvas
+//this is a function called inside draw_base_layer
 void draw_street_segments(int check, ezgl::renderer &g){
      //Set two sets of color: one for regular mode, one for night mode
     ezgl::color BACKGROUND(0,0,0);
@@ -2192,7 +2731,7 @@ void draw_street_segments(int check, ezgl::renderer &g){
     ezgl::color STREETBORDER(0, 0, 0);
 
     //night mode color palette
-    if(g_m2_data->night_mode_bool){
+    if(draw_state.style.night_mode){
         BACKGROUND=ezgl::N_BACKGROUND;
         WATER=ezgl::N_WATER;
         BUILDING=ezgl::N_BUILDING;
@@ -2216,81 +2755,51 @@ void draw_street_segments(int check, ezgl::renderer &g){
     }
     //draw street segments borders and set color and width
     //width of the segments are based on dynamic_width sizing function
+    //major roads are drawn and scaled differently from minor roads
+    //classes are stroked from minor up to primary so major roads sit on top
     g.set_line_cap(ezgl::line_cap::round);
-    for(unsigned int i=0; i < g_m2_data->segments.size(); i++){
-        int border_size;
-        bool draw=false;
-
-        //major roads are drawn and scaled differently from minor roads
-        if((g_m2_data->segments[i].highway=="primary"||g_m2_data->segments[i].highway=="primary_link")){
-
-            border_size=7 + dynamic_width_large_roads();
-            draw=check>=1;
-        }else if((g_m2_data->segments[i].highway=="secondary"||g_m2_data->segments[i].highway=="secondary_link")){
-            border_size=6 + dynamic_width_large_roads();
-            draw=check>=1;
-        }else if((g_m2_data->segments[i].highway=="tertiary"||g_m2_data->segments[i].highway=="tertiary_link")){
-            border_size=5 + dynamic_width_small_roads();
-            draw=check>=2;
-        }else if (!(g_m2_data->segments[i].highway=="motorway"||g_m2_data->segments[i].highway=="motorway_link"
-                 ||g_m2_data->segments[i].highway=="trunk"||g_m2_data->segments[i].highway=="trunk_link")){
-            border_size=4 + dynamic_width_small_roads();
-            draw=check>=2;
-        }
-        if(draw)
-        for(unsigned int j=0; j<g_m2_data->segments[i].x.size()-1;j++){
-            g.set_color(STREETBORDER);
-            g.set_line_width(border_size);
-            g.draw_line({g_m2_data->segments[i].x[j],g_m2_data->segments[i].y[j]}, {g_m2_data->segments[i].x[j+1], g_m2_data->segments[i].y[j+1]});
+    g.set_color(STREETBORDER);
+    for(int c=NUM_STREET_CLASSES-1; c>=0; c--){
+        if(!road_class_shown(RoadClass(c), check)) continue;
+        g.set_line_width(road_width(RoadClass(c))+2);
+        const std::vector<unsigned> &bucket = draw_state.visible_class_segments[c];
+        for(unsigned int k=0; k<bucket.size(); k++){
+            unsigned int i = bucket[k];
+            add_segment_polyline(g, i);
         }
+        g.stroke_polylines();
     }
 
     //draw highway borders and set color and width
     //width of the segments are based on dynamic_width sizing function
-    for(unsigned int i=0; i<g_m2_data->segments.size();i++){
-        if(g_m2_data->segments[i].highway=="motorway"||g_m2_data->segments[i].highway=="motorway_link"
-           ||g_m2_data->segments[i].highway=="trunk"||g_m2_data->segments[i].highway=="trunk_link"){  
-            g.set_color(HIGHWAYBORDER);
-            g.set_line_width(8 + dynamic_width_large_roads());
-            for(unsigned int j=0; j<g_m2_data->segments[i].x.size()-1;j++){
-            g.draw_line({g_m2_data->segments[i].x[j],g_m2_data->segments[i].y[j]}, {g_m2_data->segments[i].x[j+1], g_m2_data->segments[i].y[j+1]}); 
-            }
-        }
+    g.set_color(HIGHWAYBORDER);
+    g.set_line_width(road_width(RoadClass::HIGHWAY)+2);
+    const std::vector<unsigned> &highways = draw_state.visible_class_segments[int(RoadClass::HIGHWAY)];
+    for(unsigned int k=0; k<highways.size(); k++){
+        unsigned int i = highways[k];
+        add_segment_polyline(g, i);
     }
+    g.stroke_polylines();
     
     //draw street segments and set color and width
     //width of the segments are based on dynamic_width sizing function
-    for(unsigned int i=0; i < g_m2_data->segments.size(); i++){
-        int  street_size;
-        bool draw=false;
-        if((g_m2_data->segments[i].highway=="primary"||g_m2_data->segments[i].highway=="primary_link")){
-            street_size=5 + dynamic_width_large_roads();
-            draw=check>=1;
-        }else if((g_m2_data->segments[i].highway=="secondary"||g_m2_data->segments[i].highway=="secondary_link")){
-            street_size=4 + dynamic_width_large_roads();
-            draw=check>=1;
-        }else if((g_m2_data->segments[i].highway=="tertiary"||g_m2_data->segments[i].highway=="tertiary_link")){
-            street_size=3 + dynamic_width_small_roads();
-            draw=check>=2;
-        }else if (!(g_m2_data->segments[i].highway=="motorway"||g_m2_data->segments[i].highway=="motorway_link"
-                 ||g_m2_data->segments[i].highway=="trunk"||g_m2_data->segments[i].highway=="trunk_link")){
-            street_size=2 + dynamic_width_small_roads();
-            draw=check>=2;
-        }
-        if(draw){
-            for(unsigned int j=0; j<g_m2_data->segments[i].x.size()-1;j++){
-                g.set_color(STREET);
-                g.set_line_width(street_size);
-                g.draw_line({g_m2_data->segments[i].x[j],g_m2_data->segments[i].y[j]}, {g_m2_data->segments[i].x[j+1], g_m2_data->segments[i].y[j+1]});
-            }
+    g.set_color(STREET);
+    for(int c=NUM_STREET_CLASSES-1; c>=0; c--){
+        if(!road_class_shown(RoadClass(c), check)) continue;
+        g.set_line_width(road_width(RoadClass(c)));
+        const std::vector<unsigned> &bucket = draw_state.visible_class_segments[c];
+        for(unsigned int k=0; k<bucket.size(); k++){
+            unsigned int i = bucket[k];
+            add_segment_polyline(g, i);
         }
+        g.stroke_polylines();
     }
 }
 
 //labels the street names
 //texts are labeled according to segment size
-//this is a function called inside draw_main_canvas
-void label_street_names(int check, ezgl::renderer &g){
+//this is a function called inside draw_base_layer
+void label_street_names(int check, ezgl::renderer &g, LevelLabels &labels){
      //Set two sets of color: one for regular mode, one for night mode
     ezgl::color BACKGROUND(0,0,0);
     ezgl::color WATER(0,0,0);
@@ -2303,7 +2812,7 @@ void label_street_names(int check, ezgl::renderer &g){
     ezgl::color STREETBORDER(0, 0, 0);
 
     //night mode color palette
-    if(g_m2_data->night_mode_bool){
+    if(draw_state.style.night_mode){
         BACKGROUND=ezgl::N_BACKGROUND;
         WATER=ezgl::N_WATER;
         BUILDING=ezgl::N_BUILDING;
@@ -2326,55 +2835,15 @@ void label_street_names(int check, ezgl::renderer &g){
         STREETBORDER=ezgl::D_STREETBORDER;
     }
     
-    //labeling street names
-    //prints out the text with size that are inside each street segment
-    //arrows "-> "points in the direction of the segments
-    for(unsigned int i=0; i < g_m2_data->segments.size(); i++){
-        int  street_size;
-        bool draw=false;
-        if((g_m2_data->segments[i].highway=="primary"||g_m2_data->segments[i].highway=="primary_link")){
-            street_size=5 + dynamic_width_large_roads();
-            draw=check>=1;
-        }else if((g_m2_data->segments[i].highway=="secondary"||g_m2_data->segments[i].highway=="secondary_link")){
-            street_size=4 + dynamic_width_large_roads();
-            draw=check>=1;
-        }else if((g_m2_data->segments[i].highway=="tertiary"||g_m2_data->segments[i].highway=="tertiary_link")){
-            street_size=3 + dynamic_width_small_roads();
-            draw=check>=2;
-        }else if (!(g_m2_data->segments[i].highway=="motorway"||g_m2_data->segments[i].highway=="motorway_link" ||g_m2_data->segments[i].highway=="trunk"||g_m2_data->segments[i].highway=="trunk_link")){
-            street_size=2 + dynamic_width_small_roads();
-            draw=check>=2;
-        }
-        if(draw){
-            g.set_font_size(street_size);
-            for(unsigned int j=0; j<g_m2_data->segments[i].x.size()-1;j++){
-
-                if(g_m2_data->segments[i].one_way){
-                    g.set_color(BUILDING);
-                    g.set_text_rotation(g_m2_data->segments[i].angle[j]*180/M_PI);
-                    g.draw_text({(g_m2_data->segments[i].x[j]+g_m2_data->segments[i].x[j+1])/2.0,(g_m2_data->segments[i].y[j]+g_m2_data->segments[i].y[j+1])/2},"->", g_m2_data->segments[i].length[j], street_size);
-                }
-
-                if(g_m2_data->night_mode_bool){
-                    g.set_color(ezgl::WHITE);
-                }else{
-                    g.set_color(ezgl::BLACK);
-                }
-
-                if(g_m2_data->segments[i].angle[j]>M_PI/2.0){
-                    g.set_text_rotation((g_m2_data->segments[i].angle[j]-M_PI)*180/M_PI);
-                }else if(g_m2_data->segments[i].angle[j]<-M_PI/2.0){
-                    g.set_text_rotation((g_m2_data->segments[i].angle[j]+M_PI)*180/M_PI);
-                }else
-                    g.set_text_rotation(g_m2_data->segments[i].angle[j]*180/M_PI);
-                g.draw_text({(g_m2_data->segments[i].x[j]+g_m2_data->segments[i].x[j+1])/2.0,(g_m2_data->segments[i].y[j]+g_m2_data->segments[i].y[j+1])/2.0},g_m2_data->segments[i].name,g_m2_data->segments[i].length[j],street_size);
-            }
-        }
+    //labeling street names, placed around the highway names
+    for(int c=0; c<NUM_STREET_CLASSES; c++){
+        if(!road_class_shown(RoadClass(c), check)) continue;
+        label_segments(g, labels, draw_state.label_class_segments[c], road_width(RoadClass(c)), BUILDING);
     }
 }
 
 //draws the highways
-//this is a function called inside draw_main_canvas
+//this is a function called inside draw_base_layer
 void draw_highway_segments(ezgl::renderer &g){
      //Set two sets of color: one for regular mode, one for night mode
     ezgl::color BACKGROUND(0,0,0);
@@ -2388,7 +2857,7 @@ void draw_highway_segments(ezgl::renderer &g){
     ezgl::color STREETBORDER(0, 0, 0);
 
     //night mode color palette
-    if(g_m2_data->night_mode_bool){
+    if(draw_state.style.night_mode){
         BACKGROUND=ezgl::N_BACKGROUND;
         WATER=ezgl::N_WATER;
         BUILDING=ezgl::N_BUILDING;
@@ -2412,23 +2881,20 @@ void draw_highway_segments(ezgl::renderer &g){
     }
     //draw highway segments and set color and width
     //width of the segments are based on dynamic_width sizing function
-    for(unsigned int i=0; i<g_m2_data->segments.size();i++){
-        g.set_color(HIGHWAY);
-
-        if(g_m2_data->segments[i].highway=="motorway"||g_m2_data->segments[i].highway=="motorway_link"||g_m2_data->segments[i].highway=="trunk"||g_m2_data->segments[i].highway=="trunk_link"){   
-            double width=6+ dynamic_width_large_roads();
-            g.set_line_width(width);
-            for(unsigned int j=0; j<g_m2_data->segments[i].x.size()-1;j++){
-                g.draw_line({g_m2_data->segments[i].x[j],g_m2_data->segments[i].y[j]}, {g_m2_data->segments[i].x[j+1], g_m2_data->segments[i].y[j+1]});
-            }
-        }
+    g.set_color(HIGHWAY);
+    g.set_line_width(road_width(RoadClass::HIGHWAY));
+    const std::vector<unsigned> &highways = draw_state.visible_class_segments[int(RoadClass::HIGHWAY)];
+    for(unsigned int k=0; k<highways.size(); k++){
+        unsigned int i = highways[k];
+        add_segment_polyline(g, i);
     }
+    g.stroke_polylines();
 }
 
 //labels the names of the highways drawn
 //texts are drawn base according to the size of the segment
-//this is a function called inside draw_main_canvas
-void label_highway_names(ezgl::renderer &g){
+//this is a function called inside draw_base_layer
+void label_highway_names(ezgl::renderer &g, LevelLabels &labels){
      //Set two sets of color: one for regular mode, one for night mode
     ezgl::color BACKGROUND(0,0,0);
     ezgl::color WATER(0,0,0);
@@ -2441,7 +2907,7 @@ void label_highway_names(ezgl::renderer &g){
     ezgl::color STREETBORDER(0, 0, 0);
 
     //night mode color palette
-    if(g_m2_data->night_mode_bool){
+    if(draw_state.style.night_mode){
         BACKGROUND=ezgl::N_BACKGROUND;
         WATER=ezgl::N_WATER;
         BUILDING=ezgl::N_BUILDING;
@@ -2464,43 +2930,160 @@ void label_highway_names(ezgl::renderer &g){
         STREETBORDER=ezgl::D_STREETBORDER;
     }
     //labeling highway names
-    //prints out the text with size that are inside each street segment
-    //arrows "-> "points in the direction of the segments
-    for(unsigned int i=0; i<g_m2_data->segments.size();i++){
-        if(g_m2_data->segments[i].highway=="motorway"||g_m2_data->segments[i].highway=="motorway_link"||g_m2_data->segments[i].highway=="trunk"||g_m2_data->segments[i].highway=="trunk_link"){  
-            double width=6+ dynamic_width_large_roads();
-            g.set_font_size(width);
-            for(unsigned int j=0; j<g_m2_data->segments[i].x.size()-1;j++){
-            if(g_m2_data->segments[i].one_way){
-                g.set_color(BUILDING);
-                g.set_text_rotation(g_m2_data->segments[i].angle[j]*180/M_PI);
-                g.draw_text({(g_m2_data->segments[i].x[j]+g_m2_data->segments[i].x[j+1])/2.0,(g_m2_data->segments[i].y[j]+g_m2_data->segments[i].y[j+1])/2},"->", g_m2_data->segments[i].length[j], width);
+    label_segments(g, labels, draw_state.label_class_segments[int(RoadClass::HIGHWAY)], road_width(RoadClass::HIGHWAY), BUILDING);
+}
+
+//Places and draws the names of segments, and arrows along one way segments.
+//Each segment offers the middle of its longest piece, longest first. A street
+//is named again only LABEL_REPEAT_PIXELS from its other names, and labels
+//that collide with placed ones are dropped before any text is drawn. Labels
+//are placed in the level's labels by the first tile they touch and drawn by
+//every tile they touch, each tile showing its part of the label
+void label_segments(ezgl::renderer &g, LevelLabels &labels, const std::vector<unsigned> &segments, double font_size, ezgl::color arrow_color){
+    ezgl::point2d scale = g.get_world_scale_factor();
+    ezgl::rectangle visible = g.get_visible_world();
+
+    //the tile in pixels of its level, which all tiles of the level share
+    Box tile = {visible.left()/scale.x, -visible.top()/scale.y, visible.right()/scale.x, -visible.bottom()/scale.y};
+
+    //longest piece of each segment, in pixels. Labels reach at most the
+    //margin from their piece's middle, so pieces farther from the tile are
+    //skipped
+    struct LabelCandidate{
+        unsigned segment;
+        unsigned point;
+        double length;
+    };
+    std::vector<LabelCandidate> candidates;
+    candidates.reserve(segments.size());
+    for(unsigned k=0; k<segments.size(); k++){
+        unsigned i = segments[k];
+        unsigned j = g_m2_data->segments[i].label_point;
+        if(j+1 < segment_table.point_end(i)){
+            double dx = (segment_table.points[j+1].x-segment_table.points[j].x)/scale.x;
+            double dy = (segment_table.points[j+1].y-segment_table.points[j].y)/scale.y;
+            double length = sqrt(dx*dx+dy*dy);
+            double middle_x = (segment_table.points[j].x+segment_table.points[j+1].x)/2.0/scale.x;
+            double middle_y = -(segment_table.points[j].y+segment_table.points[j+1].y)/2.0/scale.y;
+            if(length > 0 && middle_x > tile.x_min-LABEL_MARGIN_PIXELS && middle_x < tile.x_max+LABEL_MARGIN_PIXELS
+                          && middle_y > tile.y_min-LABEL_MARGIN_PIXELS && middle_y < tile.y_max+LABEL_MARGIN_PIXELS){
+                candidates.push_back({i, j, length});
             }
-            
-            if(g_m2_data->night_mode_bool){
-                g.set_color(ezgl::WHITE);
-            }else{
-                g.set_color(ezgl::BLACK);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const LabelCandidate &a, const LabelCandidate &b){
+        return a.length > b.length;
+    });
+
+    g.set_font_size(font_size);
+    ezgl::point2d arrow_size = g.get_text_size("->");
+
+    //labels to draw on this tile, chosen while holding the level's labels and
+    //drawn after letting them go
+    struct LabelText{
+        ezgl::point2d at;
+        double rotation;
+        unsigned segment;
+        bool arrow;
+    };
+    std::vector<LabelText> texts;
+    {
+        std::lock_guard<std::mutex> m_lock(labels.mutex);
+        for(unsigned k=0; k<candidates.size(); k++){
+            const LabelCandidate &candidate = candidates[k];
+            ezgl::point2d from(segment_table.points[candidate.point].x, segment_table.points[candidate.point].y);
+            ezgl::point2d to(segment_table.points[candidate.point+1].x, segment_table.points[candidate.point+1].y);
+
+            //pixel direction of the piece; pixel y points down
+            ezgl::point2d direction((to.x-from.x)/scale.x/candidate.length, (from.y-to.y)/scale.y/candidate.length);
+            ezgl::point2d middle((from.x+to.x)/2.0, (from.y+to.y)/2.0);
+            ezgl::point2d pixel_middle(middle.x/scale.x, -middle.y/scale.y);
+
+            //a name not placed yet is placed by the first tile it touches
+            unsigned long long name_id = 2ull*candidate.segment;
+            std::unordered_map<unsigned long long, LevelLabels::Choice>::iterator name_choice = labels.choices.find(name_id);
+            if(name_choice == labels.choices.end()){
+                //names are turned to read left to right
+                ezgl::point2d size = g.get_text_size(name_pool.c_str(g_m2_data->segments[candidate.segment].name_id));
+                ezgl::point2d axis = direction.x < 0 ? ezgl::point2d(-direction.x, -direction.y) : direction;
+                LabelBox name_box = {pixel_middle, axis, size.x/2+LABEL_PADDING_PIXELS, size.y/2+LABEL_PADDING_PIXELS};
+                if(label_touches(name_box, tile)){
+                    std::vector<ezgl::point2d> &named = labels.street_labels[segment_table.street_id[candidate.segment]];
+                    bool repeated = false;
+                    for(unsigned n=0; n<named.size() && !repeated; n++){
+                        double dx = named[n].x-pixel_middle.x;
+                        double dy = named[n].y-pixel_middle.y;
+                        repeated = dx*dx+dy*dy < LABEL_REPEAT_PIXELS*LABEL_REPEAT_PIXELS;
+                    }
+
+                    //labels longer than the margin could reach tiles that never look for them
+                    ezgl::point2d extent = label_extent(name_box);
+                    bool placed = !repeated && size.x <= candidate.length && extent.x <= LABEL_MARGIN_PIXELS
+                               && extent.y <= LABEL_MARGIN_PIXELS && labels.grid.place(name_box);
+                    if(placed){
+                        named.push_back(pixel_middle);
+                    }
+                    name_choice = labels.choices.insert({name_id, {placed ? 0 : -1, name_box}}).first;
+                }
             }
-                
-            if(g_m2_data->segments[i].angle[j]>M_PI/2.0){
-                g.set_text_rotation((g_m2_data->segments[i].angle[j]-M_PI)*180/M_PI);
-            }else if(g_m2_data->segments[i].angle[j]<-M_PI/2.0){
-                g.set_text_rotation((g_m2_data->segments[i].angle[j]+M_PI)*180/M_PI);
-            }else
-                g.set_text_rotation(g_m2_data->segments[i].angle[j]*180/M_PI);
-            g.draw_text({(g_m2_data->segments[i].x[j]+g_m2_data->segments[i].x[j+1])/2.0,(g_m2_data->segments[i].y[j]+g_m2_data->segments[i].y[j+1])/2.0},g_m2_data->segments[i].name,g_m2_data->segments[i].length[j],width);
+            if(name_choice != labels.choices.end() && name_choice->second.place == 0 && label_touches(name_choice->second.box, tile)){
+                double angle = atan2(to.y-from.y, to.x-from.x);
+                double rotation = angle;
+                if(angle>M_PI/2.0){
+                    rotation = angle-M_PI;
+                }else if(angle<-M_PI/2.0){
+                    rotation = angle+M_PI;
+                }
+                texts.push_back({middle, rotation*180/M_PI, candidate.segment, false});
+            }
+
+            //arrows "->" point in the direction of one way segments, a quarter of
+            //the way along the piece from either end of the name
+            if(g_m2_data->segments[candidate.segment].one_way && arrow_size.x*2 <= candidate.length){
+                ezgl::point2d at[2] = {{from.x+(to.x-from.x)*0.25, from.y+(to.y-from.y)*0.25},
+                                       {from.x+(to.x-from.x)*0.75, from.y+(to.y-from.y)*0.75}};
+                unsigned long long arrow_id = 2ull*candidate.segment+1;
+                std::unordered_map<unsigned long long, LevelLabels::Choice>::iterator arrow_choice = labels.choices.find(arrow_id);
+                if(arrow_choice == labels.choices.end()){
+                    LabelBox arrow_box[2] = {{{at[0].x/scale.x, -at[0].y/scale.y}, direction, arrow_size.x/2+LABEL_PADDING_PIXELS, arrow_size.y/2+LABEL_PADDING_PIXELS},
+                                             {{at[1].x/scale.x, -at[1].y/scale.y}, direction, arrow_size.x/2+LABEL_PADDING_PIXELS, arrow_size.y/2+LABEL_PADDING_PIXELS}};
+                    if(label_touches(arrow_box[0], tile) || label_touches(arrow_box[1], tile)){
+                        int placed = -1;
+                        for(unsigned p=0; p<2 && placed < 0; p++){
+                            if(labels.grid.place(arrow_box[p])){
+                                placed = p;
+                            }
+                        }
+                        arrow_choice = labels.choices.insert({arrow_id, {placed, arrow_box[placed < 0 ? 0 : placed]}}).first;
+                    }
+                }
+                if(arrow_choice != labels.choices.end() && arrow_choice->second.place >= 0 && label_touches(arrow_choice->second.box, tile)){
+                    double angle = atan2(to.y-from.y, to.x-from.x);
+                    texts.push_back({at[arrow_choice->second.place], angle*180/M_PI, candidate.segment, true});
+                }
             }
         }
     }
+
+    for(unsigned k=0; k<texts.size(); k++){
+        if(texts[k].arrow){
+            g.set_color(arrow_color);
+        }else if(draw_state.style.night_mode){
+            g.set_color(ezgl::WHITE);
+        }else{
+            g.set_color(ezgl::BLACK);
+        }
+        g.set_text_rotation(texts[k].rotation);
+        g.draw_text(texts[k].at, texts[k].arrow ? "->" : name_pool.c_str(g_m2_data->segments[texts[k].segment].name_id));
+    }
 }
 
 //draws the subway line
-//this is a function called inside draw_main_canvas
+//this is a function called inside draw_base_layer
 void draw_subway_line(int check, ezgl::renderer &g){
     //Draw subway lines
-    if(g_m2_data->POIChecks.station&&check>=1){
-        if(g_m2_data->night_mode_bool){
+    if(draw_state.style.POI_checks.station&&check>=1){
+        if(draw_state.style.night_mode){
             g.set_color(ezgl::DARK_SLATE_BLUE);
         }else{
             g.set_color(ezgl::BLUE);
@@ -2508,84 +3091,82 @@ void draw_subway_line(int check, ezgl::renderer &g){
         g.set_line_width(4);
         g.set_line_cap(ezgl::line_cap::round);
         for(unsigned int i = 0; i<g_m2_data->subways.size(); i++){
-            for(unsigned int j =0; j<g_m2_data->subways[i].size()-1;j++){
-                g.draw_line(g_m2_data->subways[i][j], g_m2_data->subways[i][j+1]);
-            }
+            g.add_polyline(g_m2_data->subways[i].data(), g_m2_data->subways[i].size());
         }
+        g.stroke_polylines();
     }
 }
 
 //draw the POIs onto the map
-//this is a function called inside draw_main_canvas
+//this is a function called inside draw_base_layer
 void draw_POIs(int check, ezgl::renderer &g){
 
     //drawing POI icons
     //icons will be drawn base on zoom area
-    ezgl::surface *hospital_png = ezgl::renderer::load_png("libstreetmap/resources/hospital.png");
-    ezgl::surface *cafe_png = ezgl::renderer::load_png("libstreetmap/resources/cafe.png");
-    ezgl::surface *restaurant_png = ezgl::renderer::load_png("libstreetmap/resources/restaurant.png");
-    ezgl::surface *bank_png = ezgl::renderer::load_png("libstreetmap/resources/bank.png");
-    ezgl::surface *gas_png = ezgl::renderer::load_png("libstreetmap/resources/gas.png");
-    ezgl::surface *subway_png = ezgl::renderer::load_png("libstreetmap/resources/subway.png");
+    const POIIcons &icons = g_m2_data->POI_icons;
+
+    //the tile in pixels, to skip names that do not reach it
+    ezgl::point2d scale = g.get_world_scale_factor();
+    ezgl::rectangle visible = g.get_visible_world();
+    Box tile = {visible.left()/scale.x, -visible.top()/scale.y, visible.right()/scale.x, -visible.bottom()/scale.y};
     
     if(check>=1)
-    for(unsigned int i = 0; i < g_m2_data->POIs.size(); i++){
+    for(unsigned int k=0; k<draw_state.visible_POIs.size(); k++){
+        unsigned int i = draw_state.visible_POIs[k];
 
         bool draw = false;
         
-        if(g_m2_data->POIChecks.POI){
+        if(draw_state.style.POI_checks.POI){
             g.set_color(ezgl::RED);
             g.fill_arc(g_m2_data->POIs[i].location, INTERSECTION_DOT_RADIUS,0,360);
             draw = true;
         }
         
-        if(g_m2_data->POIs[i].type=="hospital"&&g_m2_data->POIChecks.hospital){
-            g.draw_surface(hospital_png, g_m2_data->POIs[i].location);
+        if(g_m2_data->POIs[i].category==POICategory::HOSPITAL&&draw_state.style.POI_checks.hospital){
+            g.draw_surface(icons.hospital, g_m2_data->POIs[i].location);
             draw = true;
         }
         
-        if(g_m2_data->POIs[i].type=="cafe"&&g_m2_data->POIChecks.cafe){
-            g.draw_surface(cafe_png, g_m2_data->POIs[i].location);
+        if(g_m2_data->POIs[i].category==POICategory::CAFE&&draw_state.style.POI_checks.cafe){
+            g.draw_surface(icons.cafe, g_m2_data->POIs[i].location);
             draw = true;
         }
         
-        if(g_m2_data->POIs[i].type=="restaurant"&&g_m2_data->POIChecks.restaurant){
-            g.draw_surface(restaurant_png, g_m2_data->POIs[i].location);
+        if(g_m2_data->POIs[i].category==POICategory::RESTAURANT&&draw_state.style.POI_checks.restaurant){
+            g.draw_surface(icons.restaurant, g_m2_data->POIs[i].location);
             draw = true;
         }
         
-        if(g_m2_data->POIs[i].type=="bank"&&g_m2_data->POIChecks.bank){
-            g.draw_surface(bank_png, g_m2_data->POIs[i].location);
+        if(g_m2_data->POIs[i].category==POICategory::BANK&&draw_state.style.POI_checks.bank){
+            g.draw_surface(icons.bank, g_m2_data->POIs[i].location);
             draw = true;
         }
         
-        if(g_m2_data->POIs[i].type=="fuel"&&g_m2_data->POIChecks.gas){
-            g.draw_surface(gas_png, g_m2_data->POIs[i].location);
+        if(g_m2_data->POIs[i].category==POICategory::GAS&&draw_state.style.POI_checks.gas){
+            g.draw_surface(icons.gas, g_m2_data->POIs[i].location);
             draw = true;
         }
         
-        if(g_m2_data->POIs[i].type=="station"&&g_m2_data->POIChecks.station){
-            g.draw_surface(subway_png, g_m2_data->POIs[i].location);
+        if(g_m2_data->POIs[i].category==POICategory::STATION&&draw_state.style.POI_checks.station){
+            g.draw_surface(icons.subway, g_m2_data->POIs[i].location);
             draw = true;
         }
         
         if(check>=3&&draw){
-            if(g_m2_data->night_mode_bool){
+            if(draw_state.style.night_mode){
                 g.set_color(ezgl::WHITE);
             }else{
                 g.set_color(ezgl::BLACK);
             }
             g.set_text_rotation(0);
             g.set_font_size(15);
-            g.draw_text(g_m2_data->POIs[i].location,g_m2_data->POIs[i].name);
+
+            //names wider than the margin could reach tiles that never look for them
+            ezgl::point2d size = g.get_text_size(g_m2_data->POIs[i].name);
+            LabelBox name_box = {{g_m2_data->POIs[i].location.x/scale.x, -g_m2_data->POIs[i].location.y/scale.y}, {1, 0}, size.x/2, size.y/2};
+            if(name_box.half_width <= LABEL_MARGIN_PIXELS && name_box.half_height <= LABEL_MARGIN_PIXELS && label_touches(name_box, tile)){
+                g.draw_text(g_m2_data->POIs[i].location,g_m2_data->POIs[i].name);
+            }
         }
     }
-
-    ezgl::renderer::free_surface(hospital_png);
-    ezgl::renderer::free_surface(cafe_png);
-    ezgl::renderer::free_surface(restaurant_png);
-    ezgl::renderer::free_surface(bank_png);
-    ezgl::renderer::free_surface(gas_png);
-    ezgl::renderer::free_surface(subway_png);
-    
 }
\ No newline at end of file
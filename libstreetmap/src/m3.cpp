@@ -36,6 +36,9 @@
 #include <algorithm>
 #include <queue>
 #include "nodes.h"
+#include "segments.h"
+#include "point_array.h"
+#include "segment_route.h"
 
 
 
@@ -62,9 +65,6 @@ struct comp{
 };
 
 
-double m3_lon_to_x(double lon, double lat1, double lat2);
-double m3_lat_to_y(double lat);
-void latlon_to_point(LatLon loc1, LatLon loc2, double &x1, double &y1, double  &x2, double &y2);
 bool bfsPath(unsigned sourceID, unsigned destID, double right_turn_penalty, double left_turn_penalty, std::vector<Node *> &modified_nodes);
 void bfsTraceBack(unsigned destID, std::vector<unsigned> &path);
 
@@ -83,88 +83,48 @@ void bfsTraceBack(unsigned destID, std::vector<unsigned> &path);
 // have different street IDs.
 TurnType find_turn_type(unsigned street_segment1, unsigned street_segment2){
     
-    double x1_start, y1_start, x2_start, y2_start, x1_end, y1_end, x2_end, y2_end;
-    InfoStreetSegment s1=getInfoStreetSegment(street_segment1);
-    InfoStreetSegment s2=getInfoStreetSegment(street_segment2);
-    //Check if segments are from the same street
-    if(s1.streetID==s2.streetID){
-        return TurnType::STRAIGHT;
+    //Points of the geometry buffer forming the last edge of segment 1 into the
+    //shared intersection and the first edge of segment 2 out of it
+    unsigned start1, start2, end1, end2, shared;
     
-    //Checks if segments are connected to->from to use appropriate points
-    }else if(s1.to==s2.from){
-        
-        //Checks if there are curve points in segment 1 and uses appropriate points
-        if(s1.curvePointCount==0){
-            latlon_to_point(node_list[s1.from].position, node_list[s1.to].position, x1_start, y1_start,x2_start,y2_start);  
-        }else{
-            latlon_to_point(getStreetSegmentCurvePoint(s1.curvePointCount-1, street_segment1),node_list[s1.to].position, x1_start, y1_start, x2_start, y2_start);
-        }
-        
-        //Checks if there are curve points in segment 2 and uses appropriate points
-        if(s2.curvePointCount==0){
-            latlon_to_point(node_list[s2.from].position,node_list[s2.to].position, x1_end, y1_end,x2_end, y2_end);
-        }else{
-            latlon_to_point(node_list[s2.from].position,getStreetSegmentCurvePoint(0, street_segment2), x1_end, y1_end,x2_end, y2_end);
-        }
+    //Read both segments from the packed segment table
+    unsigned s1_from=segment_table.from[street_segment1], s1_to=segment_table.to[street_segment1];
+    unsigned s2_from=segment_table.from[street_segment2], s2_to=segment_table.to[street_segment2];
     
-    //Checks if segments are connected to->to to use appropriate points
-    }else if(s1.to==s2.to){
-        
-        //Checks if there are curve points in segment 1 and uses appropriate points
-        if(s1.curvePointCount==0){
-            latlon_to_point(node_list[s1.from].position, node_list[s1.to].position, x1_start, y1_start,x2_start,y2_start);  
-        }else{
-            latlon_to_point(getStreetSegmentCurvePoint(s1.curvePointCount-1, street_segment1),node_list[s1.to].position, x1_start, y1_start, x2_start, y2_start);
-        }
-        
-        //Checks if there are curve points in segment 2 and uses appropriate points
-        if(s2.curvePointCount==0){
-            latlon_to_point(node_list[s2.to].position,node_list[s2.from].position, x1_end, y1_end,x2_end, y2_end);
-        }else{
-            latlon_to_point(node_list[s2.to].position,getStreetSegmentCurvePoint(s2.curvePointCount-1, street_segment2), x1_end, y1_end,x2_end, y2_end);
-        }
+    //Check if segments are from the same street
+    if(segment_table.street_id[street_segment1]==segment_table.street_id[street_segment2]){
+        return TurnType::STRAIGHT;
     
-    //Checks if segments are connected from->from to use appropriate points
-    }else if(s1.from==s2.from){
-        
-        //Checks if there are curve points in segment 1 and uses appropriate points
-        if(s1.curvePointCount==0){
-            latlon_to_point(node_list[s1.to].position, node_list[s1.from].position, x1_start, y1_start,x2_start,y2_start);  
-        }else{
-            latlon_to_point(getStreetSegmentCurvePoint(0, street_segment1),node_list[s1.from].position, x1_start, y1_start, x2_start, y2_start);
-        }
-        
-        //Checks if there are curve points in segment 2 and uses appropriate points
-        if(s2.curvePointCount==0){
-            latlon_to_point(node_list[s2.from].position,node_list[s2.to].position, x1_end, y1_end,x2_end, y2_end);
-        }else{
-            latlon_to_point(node_list[s2.from].position,getStreetSegmentCurvePoint(0, street_segment2), x1_end, y1_end,x2_end, y2_end);
-        }
-        
-    //Checks if segments are connected from->to to use appropriate points
-    }else if(s1.from==s2.to){
-        
-        //Checks if there are curve points in segment 1 and uses appropriate points
-        if(s1.curvePointCount==0){
-            latlon_to_point(node_list[s1.to].position, node_list[s1.from].position, x1_start, y1_start,x2_start,y2_start);  
-        }else{
-            latlon_to_point(getStreetSegmentCurvePoint(0, street_segment1),node_list[s1.from].position, x1_start, y1_start, x2_start, y2_start);
-        }
-        
-        //Checks if there are curve points in segment 2 and uses appropriate points
-        if(s2.curvePointCount==0){
-            latlon_to_point(node_list[s2.to].position,node_list[s2.from].position, x1_end, y1_end,x2_end, y2_end);
-        }else{
-            latlon_to_point(node_list[s2.to].position,getStreetSegmentCurvePoint(s2.curvePointCount-1, street_segment2), x1_end, y1_end,x2_end, y2_end);
-        }
+    //Checks if segment 1 reaches the shared intersection at its to or from end
+    }else if(s1_to==s2_from || s1_to==s2_to){
+        shared=s1_to;
+        start1=segment_table.point_end(street_segment1)-2;
+        start2=segment_table.point_end(street_segment1)-1;
+    }else if(s1_from==s2_from || s1_from==s2_to){
+        shared=s1_from;
+        start1=segment_table.point_begin(street_segment1)+1;
+        start2=segment_table.point_begin(street_segment1);
     
     //Segments are not connected
     }else{
         return TurnType::NONE;
     }
     
+    //Checks if segment 2 leaves the shared intersection at its from or to end
+    if(s2_from==shared){
+        end1=segment_table.point_begin(street_segment2);
+        end2=segment_table.point_begin(street_segment2)+1;
+    }else{
+        end1=segment_table.point_end(street_segment2)-1;
+        end2=segment_table.point_end(street_segment2)-2;
+    }
+    
+    double dx_start, dy_start, dx_end, dy_end;
+    segment_table.point_delta(start1, start2, dx_start, dy_start);
+    segment_table.point_delta(end1, end2, dx_end, dy_end);
+    
     //Use cross product to determine if turn type is left or right
-    if(((x2_start-x1_start)*(y2_end-y1_end)-(y2_start-y1_start)*(x2_end-x1_end))<=0)
+    if((dx_start*dy_end-dy_start*dx_end)<=0)
         return TurnType::RIGHT;
     else
         return TurnType::LEFT;
@@ -240,23 +200,102 @@ std::vector<unsigned> find_path_between_intersections(
     return path;
 }
 
-//convert lon to x
-double m3_lon_to_x(double lon, double lat1, double lat2){
-    return lon*DEG_TO_RAD*cos((lat1+lat2)/2*DEG_TO_RAD);
-}
-
-//convert lat to y
-double m3_lat_to_y(double lat){
-    return lat*DEG_TO_RAD;
+// Returns the fastest route between two points in the middle of street
+// segments. The start segment can be left through its to intersection (or its
+// from intersection if two way) and the end segment entered through its from
+// intersection (or its to intersection if two way), so every pair of those
+// intersections is routed with the A* search and the fastest total is kept.
+std::vector<unsigned> find_path_between_segment_points(const SegmentProjection &start,
+                                                       const SegmentProjection &end,
+                                                       const double right_turn_penalty,
+                                                       const double left_turn_penalty){
+    
+    std::vector<unsigned> best_path;
+    double best_time = DBL_MAX;
+    
+    //No route on a map without segments to snap to
+    if(start.segment==NO_SEGMENT || end.segment==NO_SEGMENT){
+        return best_path;
+    }
+    
+    //Both points on one segment that can be driven directly
+    if(start.segment==end.segment && (end.offset>=start.offset || !segment_table.one_way[start.segment])){
+        best_path.push_back(start.segment);
+        best_time = compute_segment_path_travel_time(best_path, start, end, right_turn_penalty, left_turn_penalty);
+    }
+    
+    std::vector<unsigned> exits(1, segment_table.to[start.segment]);
+    if(!segment_table.one_way[start.segment]){
+        exits.push_back(segment_table.from[start.segment]);
+    }
+    std::vector<unsigned> entries(1, segment_table.from[end.segment]);
+    if(!segment_table.one_way[end.segment]){
+        entries.push_back(segment_table.to[end.segment]);
+    }
+    
+    for(unsigned i = 0; i < exits.size(); i++){
+        for(unsigned j = 0; j < entries.size(); j++){
+            
+            //Turning back onto the same segment is covered by the direct route
+            if(exits[i]==entries[j] && start.segment==end.segment){
+                continue;
+            }
+            
+            std::vector<unsigned> path(1, start.segment);
+            if(exits[i]!=entries[j]){
+                std::vector<unsigned> middle = find_path_between_intersections(exits[i], entries[j], right_turn_penalty, left_turn_penalty);
+                
+                //No route, or one that drives back over the start or end
+                //segment, which the other exit or entry already covers
+                if(middle.empty() || middle.front()==start.segment || middle.back()==end.segment){
+                    continue;
+                }
+                path.insert(path.end(), middle.begin(), middle.end());
+            }
+            path.push_back(end.segment);
+            
+            double time = compute_segment_path_travel_time(path, start, end, right_turn_penalty, left_turn_penalty);
+            if(time<best_time){
+                best_time=time;
+                best_path.swap(path);
+            }
+        }
+    }
+    return best_path;
 }
 
-
-//convert latlon to x,y
-void latlon_to_point(LatLon loc1, LatLon loc2, double &x1, double &y1, double  &x2, double &y2){
-    x1=m3_lon_to_x(loc1.lon(),loc1.lat(),loc2.lat());
-    y1=m3_lat_to_y(loc1.lat());
-    x2=m3_lon_to_x(loc2.lon(),loc1.lat(),loc2.lat());
-    y2=m3_lat_to_y(loc2.lat());
+// Returns the travel time of a path between two points in the middle of
+// segments: the full path time less the parts of the first and last segments
+// that are not driven
+double compute_segment_path_travel_time(const std::vector<unsigned> &path,
+                                        const SegmentProjection &start,
+                                        const SegmentProjection &end,
+                                        const double right_turn_penalty,
+                                        const double left_turn_penalty){
+    
+    if(path.size()==0 || start.segment==NO_SEGMENT || end.segment==NO_SEGMENT){
+        return 0;
+    }
+    
+    unsigned first=path.front(), last=path.back();
+    if(path.size()==1){
+        return std::abs(end.fraction-start.fraction)*find_street_segment_travel_time(first);
+    }
+    
+    double time = compute_path_travel_time(path, right_turn_penalty, left_turn_penalty);
+    
+    //The first segment is left through its to intersection if the next
+    //segment touches it; the part before start is then not driven
+    unsigned next=path[1];
+    bool leaves_to = segment_table.to[first]==segment_table.from[next] || segment_table.to[first]==segment_table.to[next];
+    time -= (leaves_to ? start.fraction : 1-start.fraction)*find_street_segment_travel_time(first);
+    
+    //Likewise the last segment is entered through its from intersection
+    unsigned previous=path[path.size()-2];
+    bool enters_from = segment_table.from[last]==segment_table.from[previous] || segment_table.from[last]==segment_table.to[previous];
+    time -= (enters_from ? 1-end.fraction : end.fraction)*find_street_segment_travel_time(last);
+    
+    return time;
 }
 
 void bfsTraceBack(unsigned destID, std::vector<unsigned> &path){
@@ -269,10 +308,10 @@ void bfsTraceBack(unsigned destID, std::vector<unsigned> &path){
         path.push_back(curr_node->reaching_edge);
         
         //Determine which node is connected to current node in traceback
-        if(unsigned(getInfoStreetSegment(path.back()).from)==curr_node->id){
-            curr_node=&node_list[getInfoStreetSegment(path.back()).to];
+        if(segment_table.from[path.back()]==curr_node->id){
+            curr_node=&node_list[segment_table.to[path.back()]];
         }else{
-            curr_node=&node_list[getInfoStreetSegment(path.back()).from];
+            curr_node=&node_list[segment_table.from[path.back()]];
         }
         
     }
@@ -289,8 +328,7 @@ bool bfsPath(unsigned sourceID, unsigned destID, double right_turn_penalty, doub
     source_node->reaching_edge=NO_EDGE;
     source_node->best_time=0;
     modified_nodes.push_back(source_node);
-    Node * dest_node = &node_list[destID];
-    wavefront.push(WaveElem(source_node,0,find_distance_between_two_points(source_node->position,dest_node->position)/max_speed));
+    wavefront.push(WaveElem(source_node,0,intersection_points.distance(sourceID,destID)/max_speed));
     /*
     //Insert connected nodes from current node into wavefront
     for(int i=0; i<int(source_node->out_edge.size());i++){
@@ -356,7 +394,8 @@ bool bfsPath(unsigned sourceID, unsigned destID, double right_turn_penalty, doub
                         to_node->reaching_edge=curr_node->out_edge[i];
                         modified_nodes.push_back(to_node);
                         
-                        double weight = time+find_distance_between_two_points(to_node->position,dest_node->position)/max_speed;
+                        //Heuristic from the precomputed intersection arrays (no cos() per node)
+                        double weight = time+intersection_points.distance(curr_node->inter[i],destID)/max_speed;
                         wavefront.push(WaveElem(to_node, time,weight));
                     }
                 }
@@ -28,6 +28,7 @@
 #include <list>
 #include <chrono>
 #include "nodes.h"
+#include "segments.h"
 #include "m4.h"
 #include "m3.h"
 #include <tuple>
@@ -1221,10 +1222,10 @@ Path bfsTraceBack(unsigned destID, std::vector<Node> &nodes_list, double right_t
         path.subpath.push_back(curr_node->reaching_edge);
         
         //Determine which node is connected to current node in traceback
-        if(unsigned(getInfoStreetSegment(path.subpath.back()).from)==curr_node->id){
-            curr_node=&nodes_list[getInfoStreetSegment(path.subpath.back()).to];
+        if(segment_table.from[path.subpath.back()]==curr_node->id){
+            curr_node=&nodes_list[segment_table.to[path.subpath.back()]];
         }else{
-            curr_node=&nodes_list[getInfoStreetSegment(path.subpath.back()).from];
+            curr_node=&nodes_list[segment_table.from[path.subpath.back()]];
         }
         
     }
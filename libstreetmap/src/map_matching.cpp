@@ -0,0 +1,245 @@
+/*
+ * Hidden Markov model map matcher. Hidden states are candidate points on
+ * street segments near each GPS point; emissions score the GPS error and
+ * transitions compare the driving distance between consecutive candidates
+ * with the straight line distance between the GPS points.
+ */
+
+#include "map_matching.h"
+#include "m1.h"
+#include "nodes.h"
+#include "segments.h"
+#include <cmath>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+
+#define NO_CANDIDATE UINT_MAX
+
+//Shortest driving distance in meters from one candidate to each target,
+//INFINITY if longer than limit. Runs a Dijkstra search by segment length that
+//stops at limit, so the visited part of the graph stays small
+static std::vector<double> route_lengths(const SegmentProjection &from, const std::vector<SegmentProjection> &targets, double limit){
+
+    std::vector<double> m_lengths(targets.size(), INFINITY);
+
+    //Intersections a target can be entered from, with the remaining distance
+    std::unordered_map<unsigned, std::vector<std::pair<unsigned, double> > > m_entries;
+    for(unsigned j = 0; j < targets.size(); j++){
+        unsigned m_segment = targets[j].segment;
+        m_entries[segment_table.from[m_segment]].push_back({j, targets[j].offset});
+        if(!segment_table.one_way[m_segment]){
+            m_entries[segment_table.to[m_segment]].push_back({j, find_street_segment_length(m_segment)-targets[j].offset});
+        }
+
+        //Both on the same segment: drive along it if the direction allows
+        if(m_segment == from.segment){
+            if(targets[j].offset >= from.offset){
+                m_lengths[j] = targets[j].offset-from.offset;
+            }else if(!segment_table.one_way[m_segment]){
+                m_lengths[j] = from.offset-targets[j].offset;
+            }
+        }
+    }
+
+    typedef std::pair<double, unsigned> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > m_queue;
+    std::unordered_map<unsigned, double> m_best;
+
+    //Leave the start segment through its to intersection, or its from
+    //intersection if it is two way
+    m_queue.push({find_street_segment_length(from.segment)-from.offset, segment_table.to[from.segment]});
+    if(!segment_table.one_way[from.segment]){
+        m_queue.push({from.offset, segment_table.from[from.segment]});
+    }
+
+    while(!m_queue.empty()){
+        Entry m_entry = m_queue.top();
+        m_queue.pop();
+        if(m_entry.first > limit){
+            break;
+        }
+        std::unordered_map<unsigned, double>::iterator m_seen = m_best.find(m_entry.second);
+        if(m_seen != m_best.end() && m_seen->second <= m_entry.first){
+            continue;
+        }
+        m_best[m_entry.second] = m_entry.first;
+
+        std::unordered_map<unsigned, std::vector<std::pair<unsigned, double> > >::iterator m_entry_targets = m_entries.find(m_entry.second);
+        if(m_entry_targets != m_entries.end()){
+            for(unsigned i = 0; i < m_entry_targets->second.size(); i++){
+                unsigned j = m_entry_targets->second[i].first;
+                m_lengths[j] = std::min(m_lengths[j], m_entry.first+m_entry_targets->second[i].second);
+            }
+        }
+
+        const Node &m_node = node_list[m_entry.second];
+        for(unsigned i = 0; i < m_node.out_edge.size(); i++){
+            double m_length = m_entry.first+find_street_segment_length(m_node.out_edge[i]);
+            if(m_length <= limit){
+                m_queue.push({m_length, m_node.inter[i]});
+            }
+        }
+    }
+
+    for(unsigned j = 0; j < m_lengths.size(); j++){
+        if(m_lengths[j] > limit){
+            m_lengths[j] = INFINITY;
+        }
+    }
+    return m_lengths;
+}
+
+static MatchedPoint unmatched(LatLon gps){
+    MatchedPoint m_point;
+    m_point.gps = gps;
+    m_point.segment = NO_SEGMENT;
+    m_point.offset = 0;
+    m_point.position = gps;
+    return m_point;
+}
+
+MapMatcher::MapMatcher(MatchSettings match_settings) : settings(match_settings){
+}
+
+std::vector<MatchedPoint> MapMatcher::push(LatLon gps){
+
+    std::vector<MatchedPoint> m_matched;
+
+    std::vector<SegmentProjection> m_projections = segment_index.within_radius(gps, settings.candidate_radius);
+    if(m_projections.size() > settings.max_candidates){
+        m_projections.resize(settings.max_candidates);
+    }
+
+    //Nothing nearby: the trace breaks here
+    if(m_projections.empty()){
+        commit_all(m_matched);
+        m_matched.push_back(unmatched(gps));
+        return m_matched;
+    }
+
+    Step m_step;
+    m_step.gps = gps;
+    m_step.candidates.resize(m_projections.size());
+    for(unsigned j = 0; j < m_projections.size(); j++){
+        double m_error = m_projections[j].distance/settings.gps_sigma;
+        m_step.candidates[j] = {m_projections[j], -0.5*m_error*m_error, NO_CANDIDATE};
+    }
+
+    if(!steps.empty()){
+        const Step &m_previous = steps.back();
+        double m_straight = find_distance_between_two_points(m_previous.gps, gps);
+        double m_limit = settings.route_factor*m_straight + 2*settings.candidate_radius;
+
+        std::vector<double> m_transition(m_projections.size(), -INFINITY);
+        for(unsigned i = 0; i < m_previous.candidates.size(); i++){
+            std::vector<double> m_routes = route_lengths(m_previous.candidates[i].projection, m_projections, m_limit);
+            for(unsigned j = 0; j < m_projections.size(); j++){
+                double m_score = m_previous.candidates[i].score - std::abs(m_routes[j]-m_straight)/settings.route_beta;
+                if(m_score > m_transition[j]){
+                    m_transition[j] = m_score;
+                    m_step.candidates[j].back = i;
+                }
+            }
+        }
+
+        //No candidate reachable from the previous point: start a new trace
+        //piece here instead of forcing an impossible route
+        bool m_reachable = false;
+        for(unsigned j = 0; j < m_projections.size(); j++){
+            m_reachable = m_reachable || m_step.candidates[j].back != NO_CANDIDATE;
+        }
+        if(m_reachable){
+            for(unsigned j = 0; j < m_projections.size(); j++){
+                m_step.candidates[j].score += m_transition[j];
+            }
+        }else{
+            commit_all(m_matched);
+        }
+    }
+
+    steps.push_back(m_step);
+    if(steps.size() > settings.window){
+        commit_oldest(m_matched);
+    }
+    return m_matched;
+}
+
+std::vector<MatchedPoint> MapMatcher::finish(){
+    std::vector<MatchedPoint> m_matched;
+    commit_all(m_matched);
+    return m_matched;
+}
+
+//Best scoring candidate of the newest point
+unsigned MapMatcher::best_last() const{
+    const std::vector<Candidate> &m_candidates = steps.back().candidates;
+    unsigned m_best = 0;
+    for(unsigned j = 1; j < m_candidates.size(); j++){
+        if(m_candidates[j].score > m_candidates[m_best].score){
+            m_best = j;
+        }
+    }
+    return m_best;
+}
+
+//Commits the oldest point along the best path through the window
+void MapMatcher::commit_oldest(std::vector<MatchedPoint> &matched){
+    unsigned m_candidate = best_last();
+    for(unsigned k = steps.size()-1; k > 0; k--){
+        m_candidate = steps[k].candidates[m_candidate].back;
+    }
+
+    const SegmentProjection &m_projection = steps.front().candidates[m_candidate].projection;
+    matched.push_back({steps.front().gps, m_projection.segment, m_projection.offset, m_projection.position});
+    steps.pop_front();
+
+    //The new oldest point has no predecessor in the window any more
+    for(unsigned j = 0; !steps.empty() && j < steps.front().candidates.size(); j++){
+        steps.front().candidates[j].back = NO_CANDIDATE;
+    }
+}
+
+//Commits every point in the window along the best path
+void MapMatcher::commit_all(std::vector<MatchedPoint> &matched){
+    if(steps.empty()){
+        return;
+    }
+
+    std::vector<unsigned> m_path(steps.size());
+    m_path.back() = best_last();
+    for(unsigned k = steps.size()-1; k > 0; k--){
+        m_path[k-1] = steps[k].candidates[m_path[k]].back;
+    }
+
+    for(unsigned k = 0; k < steps.size(); k++){
+        const SegmentProjection &m_projection = steps[k].candidates[m_path[k]].projection;
+        matched.push_back({steps[k].gps, m_projection.segment, m_projection.offset, m_projection.position});
+    }
+    steps.clear();
+}
+
+std::vector<MatchedPoint> match_trace(const std::vector<LatLon> &trace, MatchSettings settings){
+    MapMatcher m_matcher(settings);
+    std::vector<MatchedPoint> m_matched;
+    m_matched.reserve(trace.size());
+    for(unsigned i = 0; i < trace.size(); i++){
+        std::vector<MatchedPoint> m_final = m_matcher.push(trace[i]);
+        m_matched.insert(m_matched.end(), m_final.begin(), m_final.end());
+    }
+    std::vector<MatchedPoint> m_final = m_matcher.finish();
+    m_matched.insert(m_matched.end(), m_final.begin(), m_final.end());
+    return m_matched;
+}
+
+//Traces are independent and only read the map, so each thread runs its own
+//matcher. Dynamic scheduling balances traces of different lengths
+std::vector<std::vector<MatchedPoint> > match_traces(const std::vector<std::vector<LatLon> > &traces, MatchSettings settings){
+    std::vector<std::vector<MatchedPoint> > m_matched(traces.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < int(traces.size()); i++){
+        m_matched[i] = match_trace(traces[i], settings);
+    }
+    return m_matched;
+}
@@ -0,0 +1,98 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   map_matching.h
+ *
+ * Hidden Markov model map matching of GPS traces onto street segments
+ */
+
+#ifndef MAP_MATCHING_H
+#define MAP_MATCHING_H
+#include <vector>
+#include <deque>
+#include "LatLon.h"
+#include "segment_index.h"
+
+struct MatchSettings{
+    //Standard deviation of GPS error in meters
+    double gps_sigma = 10;
+
+    //Scale in meters of the difference between route and straight line distance
+    //of consecutive points; smaller values favour direct routes
+    double route_beta = 5;
+
+    //Segments farther than this from a GPS point are not candidates
+    double candidate_radius = 50;
+    unsigned max_candidates = 8;
+
+    //Routes between consecutive candidates are searched up to
+    //route_factor * straight line distance + 2 * candidate_radius meters
+    double route_factor = 3;
+
+    //GPS points held before the oldest one is committed
+    unsigned window = 30;
+};
+
+struct MatchedPoint{
+    LatLon gps;
+
+    //NO_SEGMENT if no segment was within the candidate radius
+    unsigned segment;
+
+    //Meters along the segment from its from intersection
+    double offset;
+
+    //Matched position on the segment
+    LatLon position;
+};
+
+//Streaming matcher. GPS points are pushed in trace order and the most likely
+//sequence of segments is found with the Viterbi algorithm. Only the last
+//window points are kept: once the window is full the oldest point is
+//committed along the best path so far, so latency and memory stay bounded.
+//A point with no reachable candidate breaks the trace and commits the window
+class MapMatcher{
+public:
+    MapMatcher(MatchSettings match_settings = MatchSettings());
+
+    //Adds the next GPS point and returns the points whose match became final
+    std::vector<MatchedPoint> push(LatLon gps);
+
+    //Commits every point still in the window, ending the trace
+    std::vector<MatchedPoint> finish();
+
+private:
+    struct Candidate{
+        SegmentProjection projection;
+
+        //Log probability of the best path ending at this candidate
+        double score;
+
+        //Index of that path's candidate in the previous point
+        unsigned back;
+    };
+
+    struct Step{
+        LatLon gps;
+        std::vector<Candidate> candidates;
+    };
+
+    MatchSettings settings;
+    std::deque<Step> steps;
+
+    unsigned best_last() const;
+    void commit_oldest(std::vector<MatchedPoint> &matched);
+    void commit_all(std::vector<MatchedPoint> &matched);
+};
+
+//Matches a whole trace
+std::vector<MatchedPoint> match_trace(const std::vector<LatLon> &trace, MatchSettings settings = MatchSettings());
+
+//Matches many traces in parallel over all OpenMP threads
+std::vector<std::vector<MatchedPoint> > match_traces(const std::vector<std::vector<LatLon> > &traces, MatchSettings settings = MatchSettings());
+
+#endif /* MAP_MATCHING_H */
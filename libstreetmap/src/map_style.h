@@ -0,0 +1,35 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   map_style.h
+ *
+ * Display settings the map is drawn with
+ */
+
+#ifndef MAP_STYLE_H
+#define MAP_STYLE_H
+
+//bool struct the point of interests to be drawn onto the map
+struct POIBools{
+    bool hospital = false;
+    bool cafe = false;
+    bool restaurant = false;
+    bool bank = false;
+    bool gas = false;
+    bool station = false;
+    bool POI = false;
+};
+
+//Settings the map is drawn in. The GTK thread copies them from the UI's
+//switches at the start of each frame and into each tile request, so drawing
+//never reads them while a switch changes them
+struct MapStyle{
+    bool night_mode = false;
+    POIBools POI_checks;
+};
+
+#endif /* MAP_STYLE_H */
@@ -0,0 +1,30 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   name_search.h
+ *
+ * Point of interest and intersection search by name, answered from inverted
+ * token indices
+ */
+
+#ifndef NAME_SEARCH_H
+#define NAME_SEARCH_H
+#include <vector>
+#include <string>
+
+//A name matches if for every word of query it has a word starting with it
+//(case-insensitive), e.g. "tim hort" matches "Tim Horton's" and "yonge blo"
+//matches "Yonge Street & Bloor Street East". Ids are returned in increasing
+//order, and a query without words matches nothing
+
+//Returns the points of interest whose getPointOfInterestName() matches query
+std::vector<unsigned> find_points_of_interest_by_name(std::string query);
+
+//Returns the intersections whose getIntersectionName() matches query
+std::vector<unsigned> find_intersections_by_name(std::string query);
+
+#endif /* NAME_SEARCH_H */
@@ -0,0 +1,337 @@
+/*
+ * Radix trie over case-folded names. Built breadth first from the sorted
+ * names so the children of every node are contiguous in the node array.
+ */
+
+#include "name_trie.h"
+#include <algorithm>
+#include <queue>
+#include <cctype>
+#include <set>
+#include <climits>
+
+//Case folding used by every name search
+static char fold(char c){
+    return tolower(static_cast<unsigned char>(c));
+}
+
+void NameTrie::build(const std::vector<std::string> &names){
+
+    nodes.clear();
+    labels.clear();
+    name_begin.clear();
+    ids.resize(names.size());
+
+    std::vector<std::string> m_keys(names.size());
+    for(unsigned i = 0; i < names.size(); i++){
+        m_keys[i] = names[i];
+        std::transform(m_keys[i].begin(), m_keys[i].end(), m_keys[i].begin(), fold);
+        ids[i] = i;
+    }
+    std::sort(ids.begin(), ids.end(), [&](unsigned a, unsigned b){
+        return m_keys[a] < m_keys[b] || (m_keys[a] == m_keys[b] && a < b);
+    });
+
+    //Root has an empty label and covers every name
+    nodes.push_back({0, 0, 0, 0, 0, unsigned(ids.size())});
+
+    //Pending nodes with the number of key characters matched on reaching them
+    std::queue<std::pair<unsigned, unsigned> > m_pending;
+    m_pending.push({0, 0});
+    while(!m_pending.empty()){
+        unsigned m_node = m_pending.front().first, m_depth = m_pending.front().second;
+        m_pending.pop();
+
+        //Names ending at this node sort first; the rest are grouped by their
+        //next character into children
+        unsigned i = nodes[m_node].id_begin, m_end = nodes[m_node].id_end;
+        while(i < m_end && m_keys[ids[i]].size() == m_depth){
+            if(i == nodes[m_node].id_begin){
+                name_begin.push_back(i);
+            }
+            i++;
+        }
+        nodes[m_node].child_begin = nodes.size();
+        while(i < m_end){
+            char m_next = m_keys[ids[i]][m_depth];
+            unsigned j = i+1;
+            while(j < m_end && m_keys[ids[j]][m_depth] == m_next){
+                j++;
+            }
+
+            //Sorted keys share the group's longest common prefix exactly when
+            //the first and last key do
+            const std::string &m_first = m_keys[ids[i]], &m_last = m_keys[ids[j-1]];
+            unsigned m_common = m_depth+1;
+            while(m_common < m_first.size() && m_common < m_last.size() && m_first[m_common] == m_last[m_common]){
+                m_common++;
+            }
+
+            nodes.push_back({unsigned(labels.size()), m_common-m_depth, 0, 0, i, j});
+            labels.insert(labels.end(), m_first.begin()+m_depth, m_first.begin()+m_common);
+            m_pending.push({unsigned(nodes.size()-1), m_common});
+            i = j;
+        }
+        nodes[m_node].child_count = nodes.size()-nodes[m_node].child_begin;
+    }
+
+    //Nodes are not visited in name order
+    std::sort(name_begin.begin(), name_begin.end());
+    name_begin.push_back(ids.size());
+}
+
+//Node covering every name starting with prefix, nullptr if there is none
+const NameTrie::Node *NameTrie::find_node(const std::string &prefix) const{
+
+    if(nodes.empty()){
+        return nullptr;
+    }
+
+    const Node *m_node = &nodes[0];
+    unsigned m_matched = 0;
+    while(m_matched < prefix.size()){
+
+        //Find the child whose label starts with the next character
+        char m_next = fold(prefix[m_matched]);
+        const Node *m_child = nullptr;
+        for(unsigned c = m_node->child_begin; c < m_node->child_begin+m_node->child_count; c++){
+            if(labels[nodes[c].label_begin] == m_next){
+                m_child = &nodes[c];
+                break;
+            }
+        }
+        if(m_child == nullptr){
+            return nullptr;
+        }
+
+        //The prefix may end part way through the label
+        for(unsigned k = 0; k < m_child->label_length && m_matched < prefix.size(); k++, m_matched++){
+            if(labels[m_child->label_begin+k] != fold(prefix[m_matched])){
+                return nullptr;
+            }
+        }
+        m_node = m_child;
+    }
+    return m_node;
+}
+
+IdSpan NameTrie::find_prefix(const std::string &prefix) const{
+
+    const Node *m_node = find_node(prefix);
+    if(m_node == nullptr){
+        return IdSpan(nullptr, 0);
+    }
+    return IdSpan(ids.data()+m_node->id_begin, m_node->id_end-m_node->id_begin);
+}
+
+//Node ranges always start and end on name boundaries
+void NameTrie::find_prefix_names(const std::string &prefix, unsigned &first, unsigned &last) const{
+
+    const Node *m_node = find_node(prefix);
+    if(m_node == nullptr){
+        first = last = 0;
+        return;
+    }
+    first = std::lower_bound(name_begin.begin(), name_begin.end(), m_node->id_begin)-name_begin.begin();
+    last = std::lower_bound(name_begin.begin(), name_begin.end(), m_node->id_end)-name_begin.begin();
+}
+
+std::vector<NameMatch> NameTrie::find_approximate_prefix_names(const std::string &prefix, unsigned max_edits) const{
+
+    //Allowing as many edits as the prefix has characters would match everything
+    std::vector<NameMatch> m_matches;
+    if(nodes.empty() || prefix.empty()){
+        return m_matches;
+    }
+    max_edits = std::min<unsigned>(max_edits, prefix.size()-1);
+
+    std::string m_query(prefix);
+    std::transform(m_query.begin(), m_query.end(), m_query.begin(), fold);
+
+    //Row 0 of the table: the empty name prefix against each query prefix
+    std::vector<std::vector<unsigned> > m_rows(1, std::vector<unsigned>(m_query.size()+1));
+    for(unsigned j = 0; j <= m_query.size(); j++){
+        m_rows[0][j] = j;
+    }
+    std::string m_path;
+    approximate_search(0, 0, UINT_MAX, m_query, max_edits, m_rows, m_path, m_matches);
+    return m_matches;
+}
+
+//Extends the table by each character of the node's label. rows[d] holds the
+//edit distances between the first d characters of the name (path) and each
+//prefix of the query. reported is the fewest edits already reported for an
+//ancestor; the node is only reported if it does better
+void NameTrie::approximate_search(unsigned node, unsigned depth, unsigned reported, const std::string &query, unsigned max_edits,
+                                  std::vector<std::vector<unsigned> > &rows, std::string &path, std::vector<NameMatch> &matches) const{
+
+    unsigned m_length = query.size();
+    unsigned m_best = reported, m_row_min = 0;
+    for(unsigned k = 0; k < nodes[node].label_length; k++){
+        char c = labels[nodes[node].label_begin+k];
+        unsigned d = depth+k+1;
+        if(rows.size() <= d){
+            rows.resize(d+1, std::vector<unsigned>(m_length+1));
+        }
+        path.resize(d);
+        path[d-1] = c;
+
+        const std::vector<unsigned> &m_previous = rows[d-1];
+        std::vector<unsigned> &m_row = rows[d];
+        m_row[0] = d;
+        m_row_min = d;
+        for(unsigned j = 1; j <= m_length; j++){
+            m_row[j] = std::min(std::min(m_previous[j], m_row[j-1])+1, m_previous[j-1]+(query[j-1] != c));
+
+            //Two adjacent characters typed in the wrong order
+            if(d > 1 && j > 1 && query[j-1] == path[d-2] && query[j-2] == c){
+                m_row[j] = std::min(m_row[j], rows[d-2][j-2]+1);
+            }
+            m_row_min = std::min(m_row_min, m_row[j]);
+        }
+        m_best = std::min(m_best, m_row[m_length]);
+
+        //Every longer name prefix is at least this far from the query
+        if(m_row_min > max_edits){
+            break;
+        }
+    }
+
+    if(m_best < reported && m_best <= max_edits){
+        const std::vector<unsigned>::const_iterator m_first = std::lower_bound(name_begin.begin(), name_begin.end(), nodes[node].id_begin);
+        const std::vector<unsigned>::const_iterator m_last = std::lower_bound(name_begin.begin(), name_begin.end(), nodes[node].id_end);
+        matches.push_back({unsigned(m_first-name_begin.begin()), unsigned(m_last-name_begin.begin()), m_best});
+    }
+
+    //Children can only do better if some entry of the last row is below the
+    //best reported so far
+    if(m_row_min > max_edits || m_row_min >= m_best){
+        return;
+    }
+    for(unsigned c = nodes[node].child_begin; c < nodes[node].child_begin+nodes[node].child_count; c++){
+        approximate_search(c, depth+nodes[node].label_length, m_best, query, max_edits, rows, path, matches);
+    }
+}
+
+IdSpan NameTrie::name_ids(unsigned name) const{
+    return IdSpan(ids.data()+name_begin[name], name_begin[name+1]-name_begin[name]);
+}
+
+unsigned NameTrie::name_count() const{
+    return name_begin.empty() ? 0 : name_begin.size()-1;
+}
+
+size_t NameTrie::memory_usage() const{
+    return nodes.capacity()*sizeof(Node) + labels.capacity()*sizeof(char)
+           + (ids.capacity()+name_begin.capacity())*sizeof(unsigned);
+}
+
+void NameRanking::build(const NameTrie &trie, const std::vector<double> &scores){
+
+    unsigned m_names = trie.name_count();
+    best_id.resize(m_names);
+    best_score.resize(m_names);
+    for(unsigned n = 0; n < m_names; n++){
+        IdSpan m_ids = trie.name_ids(n);
+        best_id[n] = m_ids[0];
+        for(unsigned i = 1; i < m_ids.size; i++){
+            if(scores[m_ids[i]] > scores[best_id[n]] || (scores[m_ids[i]] == scores[best_id[n]] && m_ids[i] < best_id[n])){
+                best_id[n] = m_ids[i];
+            }
+        }
+        best_score[n] = scores[best_id[n]];
+    }
+
+    //Each level combines two halves of the level below
+    best_name.assign(1, std::vector<unsigned>(m_names));
+    for(unsigned n = 0; n < m_names; n++){
+        best_name[0][n] = n;
+    }
+    for(unsigned l = 1; (1u << l) <= m_names; l++){
+        unsigned m_half = 1u << (l-1);
+        best_name.push_back(std::vector<unsigned>(m_names-(1u << l)+1));
+        for(unsigned n = 0; n < best_name[l].size(); n++){
+            best_name[l][n] = better(best_name[l-1][n], best_name[l-1][n+m_half]);
+        }
+    }
+}
+
+//The better of two names: higher score, then earlier in name order
+unsigned NameRanking::better(unsigned a, unsigned b) const{
+    if(best_score[a] != best_score[b]){
+        return best_score[a] > best_score[b] ? a : b;
+    }
+    return std::min(a, b);
+}
+
+//Best name in [first, last) from two overlapping power of two ranges
+unsigned NameRanking::best_in(unsigned first, unsigned last) const{
+    unsigned m_level = 0;
+    while((2u << m_level) <= last-first){
+        m_level++;
+    }
+    return better(best_name[m_level][first], best_name[m_level][last-(1u << m_level)]);
+}
+
+std::vector<unsigned> NameRanking::top_k(const NameTrie &trie, const std::string &prefix, unsigned k) const{
+
+    NameMatch m_match = {0, 0, 0};
+    trie.find_prefix_names(prefix, m_match.first, m_match.last);
+    return top_k(std::vector<NameMatch>(1, m_match), k);
+}
+
+//Repeatedly takes the best name of a range and splits the range around it.
+//Costs O(k log k) whatever the number of matching names. Ranges are taken in
+//order of edits, and a name found again in a later range is skipped
+std::vector<unsigned> NameRanking::top_k(std::vector<NameMatch> matches, unsigned k) const{
+
+    std::vector<unsigned> m_top;
+    std::set<unsigned> m_taken;
+    std::sort(matches.begin(), matches.end(), [](const NameMatch &a, const NameMatch &b){
+        return a.edits < b.edits;
+    });
+
+    //Ranges ordered by their best name, best on top
+    struct Range{
+        unsigned best;
+        unsigned first;
+        unsigned last;
+    };
+    auto m_worse = [this](const Range &a, const Range &b){
+        return better(a.best, b.best) == b.best;
+    };
+
+    unsigned i = 0;
+    while(i < matches.size() && m_top.size() < k){
+        std::priority_queue<Range, std::vector<Range>, decltype(m_worse)> m_ranges(m_worse);
+        unsigned m_edits = matches[i].edits;
+        for(; i < matches.size() && matches[i].edits == m_edits; i++){
+            if(matches[i].first < matches[i].last){
+                m_ranges.push({best_in(matches[i].first, matches[i].last), matches[i].first, matches[i].last});
+            }
+        }
+
+        while(!m_ranges.empty() && m_top.size() < k){
+            Range m_range = m_ranges.top();
+            m_ranges.pop();
+            if(m_taken.insert(m_range.best).second){
+                m_top.push_back(best_id[m_range.best]);
+            }
+            if(m_range.first < m_range.best){
+                m_ranges.push({best_in(m_range.first, m_range.best), m_range.first, m_range.best});
+            }
+            if(m_range.best+1 < m_range.last){
+                m_ranges.push({best_in(m_range.best+1, m_range.last), m_range.best+1, m_range.last});
+            }
+        }
+    }
+    return m_top;
+}
+
+size_t NameRanking::memory_usage() const{
+    size_t m_bytes = best_id.capacity()*sizeof(unsigned) + best_score.capacity()*sizeof(double);
+    for(unsigned l = 0; l < best_name.size(); l++){
+        m_bytes += best_name[l].capacity()*sizeof(unsigned);
+    }
+    return m_bytes;
+}
@@ -0,0 +1,115 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   name_trie.h
+ *
+ * Radix trie over case-folded names for prefix search
+ */
+
+#ifndef NAME_TRIE_H
+#define NAME_TRIE_H
+#include <vector>
+#include <string>
+#include "spans.h"
+
+//Distinct names [first, last) (see NameTrie::find_prefix_names()) matched
+//with the given number of edits
+struct NameMatch{
+    unsigned first;
+    unsigned last;
+    unsigned edits;
+};
+
+//Compressed (radix) trie stored in flat arrays. Ids are kept once, sorted by
+//case-folded name then id, so the names under any trie node are a contiguous
+//range of that array and a prefix query is a walk down the trie followed by
+//returning the range. Nodes hold no id lists and no pointers
+class NameTrie{
+public:
+    //Builds the trie from one name per id
+    void build(const std::vector<std::string> &names);
+
+    //Ids whose name starts with prefix (case-insensitive), ordered by name
+    //then id. Empty if nothing matches. The span points into the trie
+    IdSpan find_prefix(const std::string &prefix) const;
+
+    //Distinct names (ids with the same case-folded name) are numbered in name
+    //order. Sets [first, last) to the distinct names starting with prefix
+    void find_prefix_names(const std::string &prefix, unsigned &first, unsigned &last) const;
+
+    //Distinct names starting with a string within max_edits edits (insertions,
+    //deletions, substitutions or swaps of adjacent characters) of prefix.
+    //Walks the trie once, keeping a row of the edit distance table per
+    //character and pruning subtrees whose row exceeds max_edits, which is what
+    //running a Levenshtein automaton over the trie does. A descendant of a
+    //reported node is only reported again if it needs fewer edits. max_edits
+    //is capped below the length of prefix
+    std::vector<NameMatch> find_approximate_prefix_names(const std::string &prefix, unsigned max_edits) const;
+
+    //Ids sharing distinct name number name
+    IdSpan name_ids(unsigned name) const;
+
+    unsigned name_count() const;
+
+    //Bytes used by the trie's arrays
+    size_t memory_usage() const;
+
+private:
+    //Edge label labels[label_begin, label_begin+label_length) leading into
+    //the node, children nodes[child_begin, child_begin+child_count) sorted by
+    //first label character, and the node's names ids[id_begin, id_end)
+    struct Node{
+        unsigned label_begin;
+        unsigned label_length;
+        unsigned child_begin;
+        unsigned child_count;
+        unsigned id_begin;
+        unsigned id_end;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<char> labels;
+    std::vector<unsigned> ids;
+
+    //Position in ids where each distinct name starts, plus ids.size()
+    std::vector<unsigned> name_begin;
+
+    const Node *find_node(const std::string &prefix) const;
+    void approximate_search(unsigned node, unsigned depth, unsigned reported, const std::string &query, unsigned max_edits,
+                            std::vector<std::vector<unsigned> > &rows, std::string &path, std::vector<NameMatch> &matches) const;
+};
+
+//Ranks the distinct names of a trie by a score per id, for top-k prefix
+//queries. A distinct name scores as its best id. A sparse table of range
+//maxima over names in trie order lets the best k names of any prefix range be
+//taken one at a time without visiting the rest of the range
+class NameRanking{
+public:
+    void build(const NameTrie &trie, const std::vector<double> &scores);
+
+    //Best scoring id of each of the top k distinct names starting with prefix,
+    //best first. Ties go to the name first in name order
+    std::vector<unsigned> top_k(const NameTrie &trie, const std::string &prefix, unsigned k) const;
+
+    //Best scoring id of each of the top k distinct names in matches, fewest
+    //edits first and then best first
+    std::vector<unsigned> top_k(std::vector<NameMatch> matches, unsigned k) const;
+
+    size_t memory_usage() const;
+
+private:
+    std::vector<unsigned> best_id;
+    std::vector<double> best_score;
+
+    //best_name[l][i] is the best name in [i, i+2^l)
+    std::vector<std::vector<unsigned> > best_name;
+
+    unsigned better(unsigned a, unsigned b) const;
+    unsigned best_in(unsigned first, unsigned last) const;
+};
+
+#endif /* NAME_TRIE_H */
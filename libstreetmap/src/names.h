@@ -0,0 +1,113 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   names.h
+ *
+ * Interned name pool shared by m1 and m2
+ */
+
+#ifndef NAMES_H
+#define NAMES_H
+#include <vector>
+#include <string>
+#include <cstring>
+#include <climits>
+
+#define NO_NAME UINT_MAX
+
+//Stores every distinct name once in a contiguous char arena. Structures keep
+//the unsigned name id instead of their own std::string copy
+class NamePool{
+public:
+
+    //Returns the id of name, adding it to the arena the first time it is seen
+    unsigned intern(const std::string &name){
+
+        //Keep the hash table at most half full
+        if(2*(count()+1) > buckets.size()){
+            rehash(buckets.empty() ? 64 : 2*buckets.size());
+        }
+
+        //Probe linearly until the name or an empty bucket is found
+        unsigned mask = buckets.size()-1;
+        for(unsigned b = hash(name.data(), name.size()) & mask; ; b = (b+1) & mask){
+            if(buckets[b] == NO_NAME){
+                buckets[b] = count();
+                chars.insert(chars.end(), name.begin(), name.end());
+                chars.push_back('\0');
+                offset.push_back(chars.size());
+                return buckets[b];
+            }
+            if(length(buckets[b]) == name.size() && memcmp(c_str(buckets[b]), name.data(), name.size()) == 0){
+                return buckets[b];
+            }
+        }
+    }
+
+    //Returns the id of name, NO_NAME if it was never interned
+    unsigned find(const std::string &name) const{
+        if(buckets.empty()){
+            return NO_NAME;
+        }
+        unsigned mask = buckets.size()-1;
+        for(unsigned b = hash(name.data(), name.size()) & mask; buckets[b] != NO_NAME; b = (b+1) & mask){
+            if(length(buckets[b]) == name.size() && memcmp(c_str(buckets[b]), name.data(), name.size()) == 0){
+                return buckets[b];
+            }
+        }
+        return NO_NAME;
+    }
+
+    //Null terminated name of the given id, valid until the next intern()
+    const char *c_str(unsigned id) const{
+        return &chars[offset[id]];
+    }
+
+    unsigned length(unsigned id) const{
+        return offset[id+1]-offset[id]-1;
+    }
+
+    std::string get(unsigned id) const{
+        return std::string(c_str(id), length(id));
+    }
+
+    //Number of distinct names
+    unsigned count() const{
+        return offset.size()-1;
+    }
+
+private:
+    //Name id i is chars[offset[i]] to chars[offset[i+1]-2] followed by '\0'
+    std::vector<char> chars;
+    std::vector<unsigned> offset = {0};
+
+    //Open addressing table of name ids, size is a power of two
+    std::vector<unsigned> buckets;
+
+    static unsigned hash(const char *str, unsigned len){
+        //FNV-1a
+        unsigned h = 2166136261u;
+        for(unsigned i = 0; i < len; i++){
+            h = (h ^ (unsigned char)str[i]) * 16777619u;
+        }
+        return h;
+    }
+
+    void rehash(unsigned size){
+        buckets.assign(size, NO_NAME);
+        for(unsigned id = 0; id < count(); id++){
+            unsigned b = hash(c_str(id), length(id)) & (size-1);
+            while(buckets[b] != NO_NAME){
+                b = (b+1) & (size-1);
+            }
+            buckets[b] = id;
+        }
+    }
+};
+
+extern NamePool name_pool;
+#endif /* NAMES_H */
@@ -0,0 +1,41 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   poi_search.h
+ *
+ * Point of interest queries answered from the POI spatial index
+ */
+
+#ifndef POI_SEARCH_H
+#define POI_SEARCH_H
+#include <vector>
+#include <string>
+#include <climits>
+#include "LatLon.h"
+
+//Type to pass to search every point of interest
+#define ANY_POI_TYPE ""
+
+//Returned when no point of interest of the type exists
+#define NO_POI UINT_MAX
+
+//type is the getPointOfInterestType() string, e.g. "hospital" or "cafe".
+//Distances are find_distance_between_two_points() in meters, ties go to the lower id
+
+//Returns the nearest point of interest of the given type
+unsigned find_closest_point_of_interest_of_type(LatLon my_position, std::string type);
+
+//Returns the k nearest points of interest of the given type, closest first
+std::vector<unsigned> find_k_closest_points_of_interest(LatLon my_position, unsigned k, std::string type = ANY_POI_TYPE);
+
+//Returns all points of interest of the given type within radius meters, closest first
+std::vector<unsigned> find_points_of_interest_within_radius(LatLon my_position, double radius, std::string type = ANY_POI_TYPE);
+
+//Returns all points of interest of the given type inside the box with the given corners
+std::vector<unsigned> find_points_of_interest_in_box(LatLon corner1, LatLon corner2, std::string type = ANY_POI_TYPE);
+
+#endif /* POI_SEARCH_H */
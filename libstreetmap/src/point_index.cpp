@@ -0,0 +1,282 @@
+/*
+ * Static k-d tree used for nearest neighbour searches over map positions.
+ * Points are stored in tree order so each node is a contiguous range of the
+ * arrays and no child pointers are needed.
+ */
+
+#include "point_index.h"
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "segments.h"
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+
+//Builds the tree over all positions, ids being their indices
+void PointIndex::build(const std::vector<LatLon> &m_positions){
+
+    std::vector<unsigned> m_ids(m_positions.size());
+    std::iota(m_ids.begin(), m_ids.end(), 0);
+    build(m_positions, m_ids);
+}
+
+//Builds the tree over all positions with the given ids
+void PointIndex::build(const std::vector<LatLon> &m_positions, const std::vector<unsigned> &point_ids){
+
+    positions = m_positions;
+    ids = point_ids;
+
+    max_abs_lat = 0;
+    for(unsigned i = 0; i < positions.size(); i++){
+        max_abs_lat = std::max(max_abs_lat, std::abs(positions[i].lat()));
+    }
+
+    //Halving the larger side each level gives the depth of the leaves
+    unsigned m_levels = 0;
+    for(unsigned n = ids.size(); n > POINT_INDEX_LEAF_SIZE; n = (n+1)/2){
+        m_levels++;
+    }
+    split.assign(1u << m_levels, 0);
+
+    std::vector<unsigned> m_order(ids.size());
+    std::iota(m_order.begin(), m_order.end(), 0);
+    build(0, 0, ids.size(), 0, m_order);
+
+    //Store everything in tree order so leaves are contiguous
+    std::vector<LatLon> m_positions_sorted(ids.size());
+    std::vector<unsigned> m_ids_sorted(ids.size());
+    x.resize(ids.size());
+    y.resize(ids.size());
+    cos_half_lat.resize(ids.size());
+    sin_half_lat.resize(ids.size());
+    for(unsigned i = 0; i < ids.size(); i++){
+        m_positions_sorted[i] = positions[m_order[i]];
+        m_ids_sorted[i] = ids[m_order[i]];
+        x[i] = segment_table.project_x(m_positions_sorted[i].lon());
+        y[i] = segment_table.project_y(m_positions_sorted[i].lat());
+        cos_half_lat[i] = cos(y[i]/2.0);
+        sin_half_lat[i] = sin(y[i]/2.0);
+    }
+    positions.swap(m_positions_sorted);
+    ids.swap(m_ids_sorted);
+}
+
+//Partitions order[lo, hi) about its median on this depth's axis, then both halves
+void PointIndex::build(unsigned node, unsigned lo, unsigned hi, unsigned depth, std::vector<unsigned> &order){
+
+    if(hi-lo <= POINT_INDEX_LEAF_SIZE){
+        return;
+    }
+
+    unsigned mid = (lo+hi)/2;
+    if(depth%2 == 0){
+        std::nth_element(order.begin()+lo, order.begin()+mid, order.begin()+hi, [this](unsigned a, unsigned b){
+            return positions[a].lon() < positions[b].lon();
+        });
+        split[node] = segment_table.project_x(positions[order[mid]].lon());
+    }else{
+        std::nth_element(order.begin()+lo, order.begin()+mid, order.begin()+hi, [this](unsigned a, unsigned b){
+            return positions[a].lat() < positions[b].lat();
+        });
+        split[node] = segment_table.project_y(positions[order[mid]].lat());
+    }
+
+    build(2*node+1, lo, mid, depth+1, order);
+    build(2*node+2, mid, hi, depth+1, order);
+}
+
+//Keeps the k best (distance, id) pairs within the radius
+void PointIndex::Candidates::offer(double distance, unsigned id){
+
+    std::pair<double, unsigned> m_candidate(distance, id);
+    if(distance > radius || k == 0){
+        return;
+    }
+    if(heap.size() < k){
+        heap.push_back(m_candidate);
+        std::push_heap(heap.begin(), heap.end());
+    }else if(m_candidate < heap.front()){
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = m_candidate;
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+
+//Returns the id of the closest indexed position
+unsigned PointIndex::nearest(LatLon position) const{
+
+    std::vector<unsigned> m_found = search(position, 1, INFINITY);
+    return m_found.empty() ? NO_POINT : m_found[0];
+}
+
+//Returns the id of the closest indexed position for every position of the batch
+std::vector<unsigned> PointIndex::nearest(const std::vector<LatLon> &batch) const{
+
+    std::vector<unsigned> m_nearest(batch.size(), NO_POINT);
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(unsigned i = 0; i < batch.size(); i++){
+        double m_cos_min = cos(std::max(max_abs_lat, std::abs(batch[i].lat()))*DEG_TO_RAD);
+        double m_x_scale = EARTH_RADIUS_IN_METERS*m_cos_min/segment_table.ref_cos*POINT_INDEX_BOUND_SLACK;
+        double m_qy = segment_table.project_y(batch[i].lat());
+        double m_best_distance = INFINITY;
+
+        search_batch(0, 0, ids.size(), 0, batch[i], segment_table.project_x(batch[i].lon()), m_qy,
+                     cos(m_qy/2.0), sin(m_qy/2.0), m_x_scale, m_nearest[i], m_best_distance);
+    }
+    return m_nearest;
+}
+
+//Same walk as search() with k = 1, but each leaf is first screened with a
+//vectorized approximate distance and only close points get the exact metric
+void PointIndex::search_batch(unsigned node, unsigned lo, unsigned hi, unsigned depth, LatLon position, double qx, double qy,
+                              double cos_half, double sin_half, double x_scale, unsigned &best_id, double &best_distance) const{
+
+    if(hi-lo <= POINT_INDEX_LEAF_SIZE){
+        
+        //cos((a+b)/2) = cos(a/2)cos(b/2) - sin(a/2)sin(b/2) differs from the exact metric
+        //only by rounding, so a small margin keeps every possible winner
+        double m_approx[POINT_INDEX_LEAF_SIZE];
+        double m_inv_ref_cos = 1.0/segment_table.ref_cos;
+        #pragma omp simd
+        for(unsigned i = 0; i < hi-lo; i++){
+            double m_dx = (x[lo+i]-qx)*m_inv_ref_cos*(cos_half_lat[lo+i]*cos_half - sin_half_lat[lo+i]*sin_half);
+            double m_dy = y[lo+i]-qy;
+            m_approx[i] = m_dx*m_dx + m_dy*m_dy;
+        }
+        
+        double m_limit = best_distance/EARTH_RADIUS_IN_METERS/POINT_INDEX_BOUND_SLACK + POINT_INDEX_ABS_SLACK;
+        m_limit *= m_limit;
+        for(unsigned i = 0; i < hi-lo; i++){
+            if(m_approx[i] <= m_limit){
+                double m_distance = find_distance_between_two_points(positions[lo+i], position);
+                if(m_distance < best_distance || (m_distance == best_distance && ids[lo+i] < best_id)){
+                    best_distance = m_distance;
+                    best_id = ids[lo+i];
+                    m_limit = best_distance/EARTH_RADIUS_IN_METERS/POINT_INDEX_BOUND_SLACK + POINT_INDEX_ABS_SLACK;
+                    m_limit *= m_limit;
+                }
+            }
+        }
+        return;
+    }
+
+    unsigned mid = (lo+hi)/2;
+    double m_offset = depth%2 == 0 ? (qx-split[node])*x_scale : (qy-split[node])*EARTH_RADIUS_IN_METERS*POINT_INDEX_BOUND_SLACK;
+
+    if(m_offset < 0){
+        search_batch(2*node+1, lo, mid, depth+1, position, qx, qy, cos_half, sin_half, x_scale, best_id, best_distance);
+        if(-m_offset <= best_distance){
+            search_batch(2*node+2, mid, hi, depth+1, position, qx, qy, cos_half, sin_half, x_scale, best_id, best_distance);
+        }
+    }else{
+        search_batch(2*node+2, mid, hi, depth+1, position, qx, qy, cos_half, sin_half, x_scale, best_id, best_distance);
+        if(m_offset <= best_distance){
+            search_batch(2*node+1, lo, mid, depth+1, position, qx, qy, cos_half, sin_half, x_scale, best_id, best_distance);
+        }
+    }
+}
+
+//Returns the ids of the k closest positions
+std::vector<unsigned> PointIndex::k_nearest(LatLon position, unsigned k) const{
+
+    return search(position, k, INFINITY);
+}
+
+//Returns the ids of all positions within radius meters
+std::vector<unsigned> PointIndex::within_radius(LatLon position, double radius) const{
+
+    return search(position, UINT_MAX, radius);
+}
+
+//Returns up to k ids within radius meters sorted by distance then id
+std::vector<unsigned> PointIndex::search(LatLon position, unsigned k, double radius) const{
+
+    //Candidates::bound() needs a full heap to hold at least one point
+    if(k == 0){
+        return std::vector<unsigned>();
+    }
+
+    Candidates m_found;
+    m_found.k = k;
+    m_found.radius = radius;
+
+    //cos of the mean latitude of any pair is at least the cos of the larger |latitude|,
+    //so scaling x offsets by it never overestimates a distance
+    double m_cos_min = cos(std::max(max_abs_lat, std::abs(position.lat()))*DEG_TO_RAD);
+    double m_x_scale = EARTH_RADIUS_IN_METERS*m_cos_min/segment_table.ref_cos*POINT_INDEX_BOUND_SLACK;
+
+    search(0, 0, ids.size(), 0, position, segment_table.project_x(position.lon()), segment_table.project_y(position.lat()),
+           m_x_scale, m_found);
+
+    std::sort_heap(m_found.heap.begin(), m_found.heap.end());
+    std::vector<unsigned> m_ids(m_found.heap.size());
+    for(unsigned i = 0; i < m_ids.size(); i++){
+        m_ids[i] = m_found.heap[i].second;
+    }
+    return m_ids;
+}
+
+void PointIndex::search(unsigned node, unsigned lo, unsigned hi, unsigned depth, LatLon position, double qx, double qy,
+                        double x_scale, Candidates &found) const{
+
+    //Scan leaves with the exact metric
+    if(hi-lo <= POINT_INDEX_LEAF_SIZE){
+        for(unsigned i = lo; i < hi; i++){
+            found.offer(find_distance_between_two_points(positions[i], position), ids[i]);
+        }
+        return;
+    }
+
+    //Search the side containing the query first, then the other side if its
+    //lower bound could still hold an accepted point
+    unsigned mid = (lo+hi)/2;
+    double m_offset = depth%2 == 0 ? (qx-split[node])*x_scale : (qy-split[node])*EARTH_RADIUS_IN_METERS*POINT_INDEX_BOUND_SLACK;
+
+    if(m_offset < 0){
+        search(2*node+1, lo, mid, depth+1, position, qx, qy, x_scale, found);
+        if(-m_offset <= found.bound()){
+            search(2*node+2, mid, hi, depth+1, position, qx, qy, x_scale, found);
+        }
+    }else{
+        search(2*node+2, mid, hi, depth+1, position, qx, qy, x_scale, found);
+        if(m_offset <= found.bound()){
+            search(2*node+1, lo, mid, depth+1, position, qx, qy, x_scale, found);
+        }
+    }
+}
+
+//Returns the ids of all positions inside the box
+std::vector<unsigned> PointIndex::in_box(LatLon corner1, LatLon corner2) const{
+
+    std::vector<unsigned> m_found;
+    double m_x1 = segment_table.project_x(corner1.lon()), m_x2 = segment_table.project_x(corner2.lon());
+    double m_y1 = segment_table.project_y(corner1.lat()), m_y2 = segment_table.project_y(corner2.lat());
+
+    search_box(0, 0, ids.size(), 0, std::min(m_x1, m_x2), std::min(m_y1, m_y2), std::max(m_x1, m_x2), std::max(m_y1, m_y2), m_found);
+    return m_found;
+}
+
+void PointIndex::search_box(unsigned node, unsigned lo, unsigned hi, unsigned depth, double x_min, double y_min,
+                            double x_max, double y_max, std::vector<unsigned> &found) const{
+
+    if(hi-lo <= POINT_INDEX_LEAF_SIZE){
+        for(unsigned i = lo; i < hi; i++){
+            if(x[i] >= x_min && x[i] <= x_max && y[i] >= y_min && y[i] <= y_max){
+                found.push_back(ids[i]);
+            }
+        }
+        return;
+    }
+
+    //Only visit the children the box overlaps
+    unsigned mid = (lo+hi)/2;
+    double m_min = depth%2 == 0 ? x_min : y_min;
+    double m_max = depth%2 == 0 ? x_max : y_max;
+    if(m_min <= split[node]){
+        search_box(2*node+1, lo, mid, depth+1, x_min, y_min, x_max, y_max, found);
+    }
+    if(m_max >= split[node]){
+        search_box(2*node+2, mid, hi, depth+1, x_min, y_min, x_max, y_max, found);
+    }
+}
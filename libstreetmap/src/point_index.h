@@ -0,0 +1,106 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   point_index.h
+ *
+ * Static k-d tree over map positions for nearest neighbour, radius and box queries
+ */
+
+#ifndef POINT_INDEX_H
+#define POINT_INDEX_H
+#include <vector>
+#include <utility>
+#include <climits>
+#include "LatLon.h"
+
+//Leaves hold at most this many points
+#define POINT_INDEX_LEAF_SIZE 8
+
+//Shrinks pruning bounds slightly so rounding can never skip an exact tie
+#define POINT_INDEX_BOUND_SLACK (1-1e-9)
+
+//Absolute margin in radians for the batch kernel's approximate distances, covers
+//the cancellation error of subtracting nearby coordinates
+#define POINT_INDEX_ABS_SLACK 1e-13
+
+//Returned by nearest() when the index is empty
+#define NO_POINT UINT_MAX
+
+//Built once from a list of positions and their ids. Distances are the same as
+//find_distance_between_two_points() so queries return exactly what a linear
+//scan would, the lowest id winning ties
+class PointIndex{
+public:
+    //Ids are the indices of positions
+    void build(const std::vector<LatLon> &positions);
+
+    //Ids are given per position, e.g. the POIs of one type
+    void build(const std::vector<LatLon> &positions, const std::vector<unsigned> &point_ids);
+
+    //Id of the closest position, NO_POINT if empty
+    unsigned nearest(LatLon position) const;
+
+    //nearest() of every position, spread over OpenMP threads
+    std::vector<unsigned> nearest(const std::vector<LatLon> &batch) const;
+
+    //Ids of the k closest positions, closest first
+    std::vector<unsigned> k_nearest(LatLon position, unsigned k) const;
+
+    //Ids of all positions within radius meters, closest first
+    std::vector<unsigned> within_radius(LatLon position, double radius) const;
+
+    //Ids of all positions inside the box with the given corners, in no particular order
+    std::vector<unsigned> in_box(LatLon corner1, LatLon corner2) const;
+
+    unsigned size() const{
+        return ids.size();
+    }
+
+private:
+    //Points in tree order. Node covering [lo, hi) splits at mid = (lo+hi)/2 on
+    //x at even depths and y at odd depths, x and y being the projected position
+    std::vector<unsigned> ids;
+    std::vector<LatLon> positions;
+    std::vector<double> x;
+    std::vector<double> y;
+
+    //cos and sin of half of each point's latitude, so the cosine of a pair's mean
+    //latitude is a multiply-add the batch leaf kernel can vectorize
+    std::vector<double> cos_half_lat;
+    std::vector<double> sin_half_lat;
+
+    //Split coordinate of each internal node, children of node k are 2k+1 and 2k+2
+    std::vector<double> split;
+
+    //Largest |latitude| of the indexed points, bounds the cosine used for x distances
+    double max_abs_lat = 0;
+
+    //Best (distance, id) pairs found so far, kept as a max heap of at most k entries
+    struct Candidates{
+        unsigned k;
+        double radius;
+        std::vector<std::pair<double, unsigned> > heap;
+
+        //Distance a point must not exceed to still be accepted
+        double bound() const{
+            return heap.size() == k ? heap.front().first : radius;
+        }
+
+        void offer(double distance, unsigned id);
+    };
+
+    void build(unsigned node, unsigned lo, unsigned hi, unsigned depth, std::vector<unsigned> &order);
+    void search(unsigned node, unsigned lo, unsigned hi, unsigned depth, LatLon position, double qx, double qy,
+                double x_scale, Candidates &found) const;
+    void search_box(unsigned node, unsigned lo, unsigned hi, unsigned depth, double x_min, double y_min,
+                    double x_max, double y_max, std::vector<unsigned> &found) const;
+    std::vector<unsigned> search(LatLon position, unsigned k, double radius) const;
+    void search_batch(unsigned node, unsigned lo, unsigned hi, unsigned depth, LatLon position, double qx, double qy,
+                      double cos_half, double sin_half, double x_scale, unsigned &best_id, double &best_distance) const;
+};
+
+#endif /* POINT_INDEX_H */
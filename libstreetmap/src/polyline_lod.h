@@ -0,0 +1,151 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   polyline_lod.h
+ *
+ * Douglas-Peucker simplified copies of polylines, for drawing zoomed out
+ */
+
+#ifndef POLYLINE_LOD_H
+#define POLYLINE_LOD_H
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+
+//Douglas-Peucker simplified geometry levels. Level l is drawn at zoom levels
+//2l+1 and 2l+2, and full geometry past them. Tolerances are LOD_PIXEL_TOLERANCE
+//pixels at the closer of the two zoom levels, taking the initial world to be
+//LOD_SCREEN_PIXELS wide and each zoom step to scale by LOD_ZOOM_STEP
+#define LOD_LEVELS 3
+#define LOD_SCREEN_PIXELS 1000
+#define LOD_PIXEL_TOLERANCE 0.5
+#define LOD_ZOOM_STEP (3.0/5.0)
+
+//Tolerance of each level in world units, for an initial world world_width wide
+inline std::vector<double> LOD_tolerances(double world_width){
+    std::vector<double> tolerances(LOD_LEVELS);
+    for(unsigned level = 0; level < LOD_LEVELS; level++){
+        tolerances[level] = LOD_PIXEL_TOLERANCE*world_width*std::pow(LOD_ZOOM_STEP, 2*level+1)/LOD_SCREEN_PIXELS;
+    }
+    return tolerances;
+}
+
+//Sets keep[i] for the points of polyline points[0, count) kept by
+//Douglas-Peucker with the given tolerance: the ends are kept and a span is
+//split at its point farthest from the span's chord while that point is more
+//than tolerance away. Distances are to the chord segment rather than its
+//line, so every dropped point is within tolerance of the simplified polyline,
+//and a closed ring (first point equal to the last) splits at the point
+//farthest from the start. Uses a stack rather than recursion so long
+//coastlines can't overflow
+template <typename point_type>
+void douglas_peucker(const point_type *points, unsigned count, double tolerance, char *keep){
+
+    if(count == 0){
+        return;
+    }
+    keep[0] = 1;
+    keep[count-1] = 1;
+
+    double tolerance2 = tolerance*tolerance;
+    std::vector<std::pair<unsigned, unsigned> > spans;
+    spans.push_back({0, count-1});
+    while(!spans.empty()){
+        unsigned first = spans.back().first;
+        unsigned last = spans.back().second;
+        spans.pop_back();
+
+        double dx = points[last].x-points[first].x;
+        double dy = points[last].y-points[first].y;
+        double length2 = dx*dx+dy*dy;
+        double farthest2 = tolerance2;
+        unsigned farthest = first;
+        for(unsigned i = first+1; i < last; i++){
+            double px = points[i].x-points[first].x;
+            double py = points[i].y-points[first].y;
+            double t = length2 == 0 ? 0 : std::max(0.0, std::min(1.0, (px*dx+py*dy)/length2));
+            double distance2 = (px-t*dx)*(px-t*dx)+(py-t*dy)*(py-t*dy);
+            if(distance2 > farthest2){
+                farthest2 = distance2;
+                farthest = i;
+            }
+        }
+        if(farthest != first){
+            keep[farthest] = 1;
+            spans.push_back({first, farthest});
+            spans.push_back({farthest, last});
+        }
+    }
+}
+
+//Simplified copies of a set of polylines, one level per tolerance. Each level
+//keeps its points back to back in one buffer like SegmentTable::points, so a
+//level's polyline can be handed straight to ezgl::renderer::add_polyline()
+template <typename point_type>
+class PolylineLOD{
+public:
+    //Builds a level for each tolerance from the polylines
+    //points[line_begin[l], line_begin[l+1]). Lines are simplified over all
+    //OpenMP threads
+    void build(const std::vector<point_type> &points, const std::vector<unsigned> &line_begin, const std::vector<double> &tolerances){
+
+        levels.assign(tolerances.size(), Level());
+        if(line_begin.empty()){
+            return;
+        }
+        unsigned line_count = line_begin.size()-1;
+        std::vector<char> keep(points.size());
+        for(unsigned level = 0; level < tolerances.size(); level++){
+            std::fill(keep.begin(), keep.end(), 0);
+            #pragma omp parallel for schedule(dynamic, 256)
+            for(unsigned l = 0; l < line_count; l++){
+                douglas_peucker(points.data()+line_begin[l], line_begin[l+1]-line_begin[l], tolerances[level], keep.data()+line_begin[l]);
+            }
+
+            Level &current = levels[level];
+            current.begin.resize(line_count+1);
+            for(unsigned l = 0; l < line_count; l++){
+                current.begin[l] = current.points.size();
+                for(unsigned i = line_begin[l]; i < line_begin[l+1]; i++){
+                    if(keep[i]) current.points.push_back(points[i]);
+                }
+            }
+            current.begin[line_count] = current.points.size();
+            current.points.shrink_to_fit();
+        }
+    }
+
+    unsigned level_count() const{
+        return levels.size();
+    }
+
+    //Polyline l at level is line(level, l)[0, line_size(level, l))
+    const point_type *line(unsigned level, unsigned l) const{
+        return levels[level].points.data()+levels[level].begin[l];
+    }
+
+    unsigned line_size(unsigned level, unsigned l) const{
+        return levels[level].begin[l+1]-levels[level].begin[l];
+    }
+
+    //Points kept at level over all lines
+    size_t point_count(unsigned level) const{
+        return levels[level].points.size();
+    }
+
+private:
+    struct Level{
+        std::vector<point_type> points;
+        std::vector<unsigned> begin;
+    };
+
+    std::vector<Level> levels;
+};
+
+#endif /* POLYLINE_LOD_H */
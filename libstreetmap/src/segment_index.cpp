@@ -0,0 +1,281 @@
+/*
+ * Static R-tree over the edges of all street segment polylines. Built once
+ * with sort-tile-recursive packing so every node is full and the children
+ * of a node are contiguous.
+ */
+
+#include "segment_index.h"
+#include "segments.h"
+#include "box_index.h"
+#include "StreetsDatabaseAPI.h"
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <functional>
+
+SegmentIndex segment_index;
+
+//Closest point found on an edge: its distance and position t along the edge
+struct EdgeHit{
+    unsigned edge;
+    double distance;
+    double t;
+};
+
+//Builds the R-tree bottom up, one level at a time
+void SegmentIndex::build(){
+
+    nodes.clear();
+    edges.clear();
+
+    //Collect every polyline edge
+    std::vector<Edge> m_edges;
+    for(unsigned s = 0; s < segment_table.size(); s++){
+        for(unsigned p = segment_table.point_begin(s); p+1 < segment_table.point_end(s); p++){
+            m_edges.push_back({s, p});
+        }
+    }
+
+    std::vector<double> m_center_x(m_edges.size()), m_center_y(m_edges.size());
+    std::vector<unsigned> m_order(m_edges.size());
+    for(unsigned i = 0; i < m_edges.size(); i++){
+        const SegmentPoint &m_a = segment_table.points[m_edges[i].point];
+        const SegmentPoint &m_b = segment_table.points[m_edges[i].point+1];
+        m_center_x[i] = (m_a.x+m_b.x)/2.0;
+        m_center_y[i] = (m_a.y+m_b.y)/2.0;
+        m_order[i] = i;
+    }
+    str_order(m_order, m_center_x, m_center_y, SEGMENT_INDEX_NODE_SIZE);
+
+    //Leaves over runs of edges
+    edges.resize(m_edges.size());
+    std::vector<Node> m_level;
+    for(unsigned i = 0; i < m_order.size(); i++){
+        edges[i] = m_edges[m_order[i]];
+    }
+    for(unsigned first = 0; first < edges.size(); first += SEGMENT_INDEX_NODE_SIZE){
+        Node m_node = {INFINITY, INFINITY, -INFINITY, -INFINITY, first, std::min<unsigned>(SEGMENT_INDEX_NODE_SIZE, edges.size()-first), true};
+        for(unsigned i = first; i < first+m_node.count; i++){
+            for(unsigned p = edges[i].point; p <= edges[i].point+1; p++){
+                m_node.x_min = std::min(m_node.x_min, segment_table.points[p].x);
+                m_node.y_min = std::min(m_node.y_min, segment_table.points[p].y);
+                m_node.x_max = std::max(m_node.x_max, segment_table.points[p].x);
+                m_node.y_max = std::max(m_node.y_max, segment_table.points[p].y);
+            }
+        }
+        m_level.push_back(m_node);
+    }
+
+    //Group each level under parents until a single root is left. Levels are
+    //appended to nodes in order, so the root ends up last
+    while(m_level.size() > 1){
+        std::vector<double> m_level_x(m_level.size()), m_level_y(m_level.size());
+        std::vector<unsigned> m_level_order(m_level.size());
+        for(unsigned i = 0; i < m_level.size(); i++){
+            m_level_x[i] = (m_level[i].x_min+m_level[i].x_max)/2.0;
+            m_level_y[i] = (m_level[i].y_min+m_level[i].y_max)/2.0;
+            m_level_order[i] = i;
+        }
+        str_order(m_level_order, m_level_x, m_level_y, SEGMENT_INDEX_NODE_SIZE);
+
+        unsigned m_base = nodes.size();
+        for(unsigned i = 0; i < m_level_order.size(); i++){
+            nodes.push_back(m_level[m_level_order[i]]);
+        }
+
+        std::vector<Node> m_parents;
+        for(unsigned first = 0; first < m_level_order.size(); first += SEGMENT_INDEX_NODE_SIZE){
+            Node m_node = {INFINITY, INFINITY, -INFINITY, -INFINITY, m_base+first,
+                           std::min<unsigned>(SEGMENT_INDEX_NODE_SIZE, m_level_order.size()-first), false};
+            for(unsigned i = m_base+first; i < m_base+first+m_node.count; i++){
+                m_node.x_min = std::min(m_node.x_min, nodes[i].x_min);
+                m_node.y_min = std::min(m_node.y_min, nodes[i].y_min);
+                m_node.x_max = std::max(m_node.x_max, nodes[i].x_max);
+                m_node.y_max = std::max(m_node.y_max, nodes[i].y_max);
+            }
+            m_parents.push_back(m_node);
+        }
+        m_level.swap(m_parents);
+    }
+    nodes.insert(nodes.end(), m_level.begin(), m_level.end());
+}
+
+//Distance in meters from the query to one polyline edge, with t set to the
+//closest point's position along the edge. x_scale converts projected x to
+//meters at the query's latitude
+double SegmentIndex::edge_distance(unsigned edge, double qx, double qy, double x_scale, double &t) const{
+
+    const SegmentPoint &m_a = segment_table.points[edges[edge].point];
+    const SegmentPoint &m_b = segment_table.points[edges[edge].point+1];
+
+    //Work in meters relative to the edge start
+    double m_ex = (m_b.x-m_a.x)*x_scale, m_ey = (m_b.y-m_a.y)*EARTH_RADIUS_IN_METERS;
+    double m_px = (qx-m_a.x)*x_scale, m_py = (qy-m_a.y)*EARTH_RADIUS_IN_METERS;
+    double m_length_sq = m_ex*m_ex + m_ey*m_ey;
+    t = m_length_sq > 0 ? std::max(0.0, std::min(1.0, (m_px*m_ex + m_py*m_ey)/m_length_sq)) : 0;
+    return std::hypot(m_px-t*m_ex, m_py-t*m_ey);
+}
+
+//Fills in the projection of the closest point found on an edge. Only done for
+//results since the offset walks the whole segment polyline
+SegmentProjection SegmentIndex::project(unsigned edge, double t, double distance) const{
+
+    unsigned m_segment = edges[edge].segment, m_point = edges[edge].point;
+    SegmentProjection m_projection;
+    m_projection.segment = m_segment;
+    m_projection.distance = distance;
+
+    //Offset and length are measured like find_street_segment_length(), edge by edge
+    double m_length = 0, m_dx, m_dy;
+    for(unsigned p = segment_table.point_begin(m_segment); p+1 < segment_table.point_end(m_segment); p++){
+        segment_table.point_delta(p, p+1, m_dx, m_dy);
+        double m_edge = EARTH_RADIUS_IN_METERS*sqrt(m_dx*m_dx + m_dy*m_dy);
+        if(p == m_point){
+            m_projection.offset = m_length + t*m_edge;
+        }
+        m_length += m_edge;
+    }
+    m_projection.fraction = m_length > 0 ? m_projection.offset/m_length : 0;
+
+    const SegmentPoint &m_a = segment_table.points[m_point];
+    const SegmentPoint &m_b = segment_table.points[m_point+1];
+    double m_x = m_a.x + t*(m_b.x-m_a.x), m_y = m_a.y + t*(m_b.y-m_a.y);
+    m_projection.position = LatLon(m_y/DEG_TO_RAD, m_x/(DEG_TO_RAD*segment_table.ref_cos));
+    return m_projection;
+}
+
+//Best first search: nodes are visited in order of the distance to their box,
+//so the search ends once the next box is farther than the best edge found
+SegmentProjection SegmentIndex::nearest(LatLon position) const{
+
+    if(nodes.empty()){
+        SegmentProjection m_none;
+        m_none.segment = NO_SEGMENT;
+        m_none.distance = INFINITY;
+        m_none.offset = 0;
+        m_none.fraction = 0;
+        m_none.position = position;
+        return m_none;
+    }
+
+    double qx = segment_table.project_x(position.lon()), qy = segment_table.project_y(position.lat());
+    double m_x_scale = EARTH_RADIUS_IN_METERS*cos(qy)/segment_table.ref_cos;
+
+    //Closest edge so far and the position along it
+    unsigned m_best_edge = 0;
+    double m_best_distance = INFINITY, m_best_t = 0;
+
+    typedef std::pair<double, unsigned> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > m_queue;
+    m_queue.push({0.0, unsigned(nodes.size()-1)});
+
+    while(!m_queue.empty() && m_queue.top().first <= m_best_distance){
+        const Node &m_node = nodes[m_queue.top().second];
+        m_queue.pop();
+
+        for(unsigned i = m_node.first; i < m_node.first+m_node.count; i++){
+            if(m_node.leaf){
+                double m_t;
+                double m_distance = edge_distance(i, qx, qy, m_x_scale, m_t);
+                if(m_distance < m_best_distance || (m_distance == m_best_distance && edges[i].segment < edges[m_best_edge].segment)){
+                    m_best_edge = i;
+                    m_best_distance = m_distance;
+                    m_best_t = m_t;
+                }
+            }else{
+                double m_dx = std::max(0.0, std::max(nodes[i].x_min-qx, qx-nodes[i].x_max))*m_x_scale;
+                double m_dy = std::max(0.0, std::max(nodes[i].y_min-qy, qy-nodes[i].y_max))*EARTH_RADIUS_IN_METERS;
+                double m_box_distance = sqrt(m_dx*m_dx + m_dy*m_dy);
+                if(m_box_distance <= m_best_distance){
+                    m_queue.push({m_box_distance, i});
+                }
+            }
+        }
+    }
+    return project(m_best_edge, m_best_t, m_best_distance);
+}
+
+//Returns the closest point of every segment within radius meters of position
+std::vector<SegmentProjection> SegmentIndex::within_radius(LatLon position, double radius) const{
+
+    std::vector<SegmentProjection> m_found;
+    if(nodes.empty()){
+        return m_found;
+    }
+
+    double qx = segment_table.project_x(position.lon()), qy = segment_table.project_y(position.lat());
+    double m_x_scale = EARTH_RADIUS_IN_METERS*cos(qy)/segment_table.ref_cos;
+
+    //Closest edge of each segment found so far
+    std::map<unsigned, EdgeHit> m_best;
+
+    std::vector<unsigned> m_stack(1, nodes.size()-1);
+    while(!m_stack.empty()){
+        const Node &m_node = nodes[m_stack.back()];
+        m_stack.pop_back();
+
+        //Skip boxes entirely farther than the radius
+        double m_dx = std::max(0.0, std::max(m_node.x_min-qx, qx-m_node.x_max))*m_x_scale;
+        double m_dy = std::max(0.0, std::max(m_node.y_min-qy, qy-m_node.y_max))*EARTH_RADIUS_IN_METERS;
+        if(m_dx*m_dx + m_dy*m_dy > radius*radius){
+            continue;
+        }
+
+        for(unsigned i = m_node.first; i < m_node.first+m_node.count; i++){
+            if(!m_node.leaf){
+                m_stack.push_back(i);
+                continue;
+            }
+            double m_t;
+            double m_distance = edge_distance(i, qx, qy, m_x_scale, m_t);
+            if(m_distance <= radius){
+                std::map<unsigned, EdgeHit>::iterator m_existing = m_best.find(edges[i].segment);
+                if(m_existing == m_best.end() || m_distance < m_existing->second.distance){
+                    m_best[edges[i].segment] = {i, m_distance, m_t};
+                }
+            }
+        }
+    }
+
+    for(std::map<unsigned, EdgeHit>::iterator i = m_best.begin(); i != m_best.end(); i++){
+        m_found.push_back(project(i->second.edge, i->second.t, i->second.distance));
+    }
+    std::sort(m_found.begin(), m_found.end(), [](const SegmentProjection &a, const SegmentProjection &b){
+        return a.distance < b.distance || (a.distance == b.distance && a.segment < b.segment);
+    });
+    return m_found;
+}
+
+//Returns every segment with an edge whose bounding box overlaps the box
+std::vector<unsigned> SegmentIndex::in_box(double x_min, double y_min, double x_max, double y_max) const{
+
+    std::vector<unsigned> m_found;
+    if(nodes.empty()){
+        return m_found;
+    }
+
+    std::vector<unsigned> m_stack(1, nodes.size()-1);
+    while(!m_stack.empty()){
+        const Node &m_node = nodes[m_stack.back()];
+        m_stack.pop_back();
+        if(m_node.x_min > x_max || m_node.x_max < x_min || m_node.y_min > y_max || m_node.y_max < y_min){
+            continue;
+        }
+        for(unsigned i = m_node.first; i < m_node.first+m_node.count; i++){
+            if(!m_node.leaf){
+                m_stack.push_back(i);
+                continue;
+            }
+            const SegmentPoint &m_a = segment_table.points[edges[i].point];
+            const SegmentPoint &m_b = segment_table.points[edges[i].point+1];
+            if(std::min(m_a.x, m_b.x) <= x_max && std::max(m_a.x, m_b.x) >= x_min &&
+               std::min(m_a.y, m_b.y) <= y_max && std::max(m_a.y, m_b.y) >= y_min){
+                m_found.push_back(edges[i].segment);
+            }
+        }
+    }
+    std::sort(m_found.begin(), m_found.end());
+    m_found.erase(std::unique(m_found.begin(), m_found.end()), m_found.end());
+    return m_found;
+}
@@ -0,0 +1,87 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   segment_index.h
+ *
+ * Static R-tree over street segment geometry
+ */
+
+#ifndef SEGMENT_INDEX_H
+#define SEGMENT_INDEX_H
+#include <vector>
+#include <climits>
+#include "LatLon.h"
+
+//Segment of a query with no street segment to snap to
+#define NO_SEGMENT UINT_MAX
+
+//Entries per R-tree node
+#define SEGMENT_INDEX_NODE_SIZE 16
+
+//Closest point of a street segment to a query position
+struct SegmentProjection{
+    unsigned segment;
+
+    //Meters from the query position to the closest point
+    double distance;
+
+    //Meters along the segment from its from intersection to the closest point
+    double offset;
+
+    //offset as a fraction of the segment's length, from 0 at the from
+    //intersection to 1 at the to intersection
+    double fraction;
+
+    //Closest point on the segment
+    LatLon position;
+};
+
+//Packed (sort-tile-recursive) R-tree over every edge of every segment polyline
+//in the segment table. Distances use a local projection about the query's
+//latitude, which matches find_distance_between_two_points() at street scale
+class SegmentIndex{
+public:
+    //Builds the tree from the segment table's geometry buffer
+    void build();
+
+    //Closest point on the closest segment, segment NO_SEGMENT if the tree is
+    //empty. Ties go to the lower segment id
+    SegmentProjection nearest(LatLon position) const;
+
+    //Closest point of every segment within radius meters, closest first
+    std::vector<SegmentProjection> within_radius(LatLon position, double radius) const;
+
+    //Segments with an edge overlapping the box in segment table coordinates,
+    //in increasing order. Used to cull drawing to the visible world
+    std::vector<unsigned> in_box(double x_min, double y_min, double x_max, double y_max) const;
+
+private:
+    //Bounding box of a node and its children: nodes[first, first+count) for
+    //internal nodes or edges[first, first+count) for leaves
+    struct Node{
+        double x_min, y_min, x_max, y_max;
+        unsigned first;
+        unsigned count;
+        bool leaf;
+    };
+
+    //Edge from points[point] to points[point+1] of the segment table
+    struct Edge{
+        unsigned segment;
+        unsigned point;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+
+    double edge_distance(unsigned edge, double qx, double qy, double x_scale, double &t) const;
+    SegmentProjection project(unsigned edge, double t, double distance) const;
+};
+
+extern SegmentIndex segment_index;
+
+#endif /* SEGMENT_INDEX_H */
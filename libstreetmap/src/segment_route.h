@@ -0,0 +1,42 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   segment_route.h
+ *
+ * Snapping positions onto street segments and routing between points in the
+ * middle of segments
+ */
+
+#ifndef SEGMENT_ROUTE_H
+#define SEGMENT_ROUTE_H
+#include <vector>
+#include "LatLon.h"
+#include "segment_index.h"
+
+//Returns the closest point on any street segment to my_position, found with
+//the segment R-tree. Its segment is NO_SEGMENT if the map has no segments
+SegmentProjection find_closest_street_segment(LatLon my_position);
+
+//Returns the fastest route from the point start to the point end, each on a
+//street segment (e.g. from find_closest_street_segment()). The path starts
+//with start.segment and ends with end.segment, which are only partially
+//travelled; it has one segment if both points are on the same segment and it
+//can be driven from start to end. Returns an empty path if there is no route
+std::vector<unsigned> find_path_between_segment_points(const SegmentProjection &start,
+                                                       const SegmentProjection &end,
+                                                       const double right_turn_penalty,
+                                                       const double left_turn_penalty);
+
+//Returns the travel time of a path from find_path_between_segment_points(),
+//counting only the travelled part of its first and last segments
+double compute_segment_path_travel_time(const std::vector<unsigned> &path,
+                                        const SegmentProjection &start,
+                                        const SegmentProjection &end,
+                                        const double right_turn_penalty,
+                                        const double left_turn_penalty);
+
+#endif /* SEGMENT_ROUTE_H */
@@ -0,0 +1,79 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/* 
+ * File:   segments.h
+ *
+ * Packed street segment table shared by m1-m4
+ */
+
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+#include <vector>
+#include <cmath>
+#include "StreetsDatabaseAPI.h"
+
+//Point of a segment polyline, projected with the map-wide reference latitude
+struct SegmentPoint{
+    double x;
+    double y;
+};
+
+//Structure of arrays holding the street segment info used in hot loops.
+//Built once in load_map() so getInfoStreetSegment() stays out of the per-step code
+class SegmentTable{
+public:
+    std::vector<unsigned> from;
+    std::vector<unsigned> to;
+    std::vector<unsigned> street_id;
+    std::vector<char> one_way;
+    std::vector<float> speed_limit;
+    std::vector<OSMID> way_osmid;
+    
+    //Curve points of segment s are [curve_offset[s], curve_offset[s+1])
+    std::vector<unsigned> curve_offset;
+    
+    //Polylines (from, curve points, to) of all segments back to back in one buffer
+    std::vector<SegmentPoint> points;
+    
+    //cos of the reference latitude used to project the points
+    double ref_cos = 1;
+    
+    int curve_point_count(unsigned s) const{
+        return curve_offset[s+1]-curve_offset[s];
+    }
+    
+    //Polyline of segment s is points[point_begin(s)] to points[point_end(s)-1]
+    unsigned point_begin(unsigned s) const{
+        return curve_offset[s]+2*s;
+    }
+    
+    unsigned point_end(unsigned s) const{
+        return curve_offset[s+1]+2*(s+1);
+    }
+    
+    double project_x(double lon) const{
+        return lon*DEG_TO_RAD*ref_cos;
+    }
+    
+    double project_y(double lat) const{
+        return lat*DEG_TO_RAD;
+    }
+    
+    //Offset in radians from point p1 to p2, with x scaled by the pair's own mean
+    //latitude like find_distance_between_two_points() rather than the reference one
+    void point_delta(unsigned p1, unsigned p2, double &dx, double &dy) const{
+        dx = (points[p2].x-points[p1].x)/ref_cos*cos((points[p1].y+points[p2].y)/2.0);
+        dy = points[p2].y-points[p1].y;
+    }
+    
+    unsigned size() const{
+        return from.size();
+    }
+};
+
+extern SegmentTable segment_table;
+#endif /* SEGMENTS_H */
@@ -0,0 +1,47 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   spans.h
+ *
+ * Non-copying variants of the m1 id list accessors
+ */
+
+#ifndef SPANS_H
+#define SPANS_H
+#include <vector>
+
+//Read only view (pointer + length) of ids owned by the m1 data structures.
+//Valid until close_map() is called
+class IdSpan{
+public:
+    const unsigned *data;
+    unsigned size;
+
+    IdSpan(const std::vector<unsigned> &ids) : data(ids.data()), size(ids.size()){}
+
+    IdSpan(const unsigned *first, unsigned count) : data(first), size(count){}
+
+    const unsigned *begin() const{
+        return data;
+    }
+
+    const unsigned *end() const{
+        return data+size;
+    }
+
+    unsigned operator[](unsigned i) const{
+        return data[i];
+    }
+};
+
+//Same results as the std::vector versions in m1.h without copying
+IdSpan find_intersection_street_segments_span(unsigned intersection_id);
+IdSpan find_adjacent_intersections_span(unsigned intersection_id);
+IdSpan find_street_street_segments_span(unsigned street_id);
+IdSpan find_all_street_intersections_span(unsigned street_id);
+
+#endif /* SPANS_H */
@@ -0,0 +1,51 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   street_search.h
+ *
+ * Street name search for the search boxes
+ */
+
+#ifndef STREET_SEARCH_H
+#define STREET_SEARCH_H
+#include <vector>
+#include <string>
+
+//Orders autocomplete results
+enum class StreetRank{
+    LENGTH,
+    SEGMENT_COUNT
+};
+
+//Returns up to k street ids whose names start with street_prefix
+//(case-insensitive), one per distinct name, best ranked first. Streets sharing
+//a name are represented by the best ranked of them. Each call costs
+//O(prefix length + k log k) regardless of how many streets match. Returns an
+//empty vector if the prefix is empty
+std::vector<unsigned> find_top_street_ids_from_partial_street_name(std::string street_prefix, unsigned k, StreetRank rank = StreetRank::LENGTH);
+
+//Fuzzy search edit bounds by prefix length: exact up to
+//FUZZY_EXACT_LENGTH characters, one edit up to FUZZY_ONE_EDIT_LENGTH, then two
+#define FUZZY_EXACT_LENGTH 2
+#define FUZZY_ONE_EDIT_LENGTH 5
+
+//Returns street_name lower cased with one space between words, periods
+//dropped and street type abbreviations spelled out ("St." -> "street",
+//"Ave" -> "avenue"). Search names and queries are compared in this form
+std::string normalize_street_name(std::string street_name);
+
+//Typo tolerant version of find_top_street_ids_from_partial_street_name().
+//Returns up to k street ids, one per distinct normalized name, whose
+//normalized names start with something within a few edits of the normalized
+//prefix (insertions, deletions, substitutions or swapped neighbours; the
+//bound grows with the prefix length). Fewest edits first, then longest street
+std::vector<unsigned> find_street_ids_from_approximate_street_name(std::string street_prefix, unsigned k);
+
+//Same with an explicit bound on the number of edits
+std::vector<unsigned> find_street_ids_from_approximate_street_name(std::string street_prefix, unsigned k, unsigned max_edits);
+
+#endif /* STREET_SEARCH_H */
@@ -0,0 +1,128 @@
+/*
+ * Tile pyramid geometry and the LRU cache of rendered base map tiles. A
+ * tile's image is a cairo image surface, freed when the tile is evicted.
+ */
+
+#include "tile_cache.h"
+#include <cmath>
+
+TilePyramid::TilePyramid(ezgl::point2d m_origin, double m_base_scale, double m_scale_ratio, int m_tile_size)
+    : origin(m_origin), base_scale(m_base_scale), scale_ratio(m_scale_ratio), size(m_tile_size){
+}
+
+bool TilePyramid::valid() const{
+
+    return base_scale > 0;
+}
+
+int TilePyramid::level_for(double scale) const{
+
+    return (int)std::lround(std::log(scale/base_scale)/std::log(scale_ratio));
+}
+
+double TilePyramid::level_scale(int level) const{
+
+    return base_scale*std::pow(scale_ratio, level);
+}
+
+ezgl::rectangle TilePyramid::tile_bounds(const TileKey &key) const{
+
+    double m_tile_world = size*level_scale(key.level);
+    ezgl::point2d m_corner = {origin.x+key.x*m_tile_world, origin.y+key.y*m_tile_world};
+    return {m_corner, {m_corner.x+m_tile_world, m_corner.y+m_tile_world}};
+}
+
+std::vector<TileKey> TilePyramid::tiles_in(const ezgl::rectangle &world, int level) const{
+
+    double m_tile_world = size*level_scale(level);
+    int m_x_first = (int)std::floor((world.left()-origin.x)/m_tile_world);
+    int m_x_last = (int)std::floor((world.right()-origin.x)/m_tile_world);
+    int m_y_first = (int)std::floor((world.bottom()-origin.y)/m_tile_world);
+    int m_y_last = (int)std::floor((world.top()-origin.y)/m_tile_world);
+
+    std::vector<TileKey> m_tiles;
+    for(int y = m_y_last; y >= m_y_first; y--){
+        for(int x = m_x_first; x <= m_x_last; x++){
+            m_tiles.push_back({level, x, y});
+        }
+    }
+    return m_tiles;
+}
+
+int TilePyramid::tile_size() const{
+
+    return size;
+}
+
+TileCache::TileCache(size_t m_max_bytes) : max_bytes(m_max_bytes){
+}
+
+TileCache::~TileCache(){
+
+    clear();
+}
+
+ezgl::surface *TileCache::find(const TileKey &key){
+
+    std::unordered_map<TileKey, std::list<Entry>::iterator, TileKeyHash>::iterator m_found = index.find(key);
+    if(m_found == index.end()){
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, m_found->second);
+    return m_found->second->tile;
+}
+
+void TileCache::insert(const TileKey &key, ezgl::surface *tile){
+
+    std::unordered_map<TileKey, std::list<Entry>::iterator, TileKeyHash>::iterator m_found = index.find(key);
+    if(m_found != index.end()){
+        bytes -= m_found->second->bytes;
+        ezgl::renderer::free_surface(m_found->second->tile);
+        entries.erase(m_found->second);
+        index.erase(m_found);
+    }
+
+    size_t m_bytes = (size_t)cairo_image_surface_get_stride(tile)*cairo_image_surface_get_height(tile);
+    evict_to(max_bytes > m_bytes ? max_bytes-m_bytes : 0);
+    entries.push_front({key, tile, m_bytes});
+    index[key] = entries.begin();
+    bytes += m_bytes;
+}
+
+//Frees least recently used tiles until at most limit bytes are held
+void TileCache::evict_to(size_t limit){
+
+    while(bytes > limit && !entries.empty()){
+        bytes -= entries.back().bytes;
+        ezgl::renderer::free_surface(entries.back().tile);
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+void TileCache::clear(){
+
+    evict_to(0);
+}
+
+size_t TileCache::size() const{
+
+    return entries.size();
+}
+
+size_t TileCache::memory_usage() const{
+
+    return bytes;
+}
+
+unsigned long TileCache::hit_count() const{
+
+    return hits;
+}
+
+unsigned long TileCache::miss_count() const{
+
+    return misses;
+}
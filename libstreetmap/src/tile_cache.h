@@ -0,0 +1,121 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   tile_cache.h
+ *
+ * Tile pyramid and least recently used cache of pre-rendered base map tiles
+ */
+
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <cstddef>
+#include <ezgl/graphics.hpp>
+
+//Tile in column x and row y of the grid at a pyramid level, drawn for a view
+//at zoom_level. Line widths and which roads and labels are shown follow the
+//view's zoom level rather than the level's scale, so the same tile drawn for
+//two zoom levels is two different tiles
+struct TileKey{
+    int level;
+    int x;
+    int y;
+    int zoom_level = 0;
+
+    bool operator==(const TileKey &other) const{
+        return level == other.level && x == other.x && y == other.y && zoom_level == other.zoom_level;
+    }
+};
+
+struct TileKeyHash{
+    size_t operator()(const TileKey &key) const{
+        return (size_t(unsigned(key.level))*73856093u) ^ (size_t(unsigned(key.x))*19349663u) ^ (size_t(unsigned(key.y))*83492791u)
+             ^ (size_t(unsigned(key.zoom_level))*2654435761u);
+    }
+};
+
+//Square tiles of tile_size pixels over the world. Level 0 has base_scale
+//world units per pixel and each level is scale_ratio times the one before, so
+//tiles of a level are drawn 1:1 whenever the view is zoomed to that level's
+//scale. Rows and columns count from origin
+class TilePyramid{
+public:
+    TilePyramid() = default;
+    TilePyramid(ezgl::point2d origin, double base_scale, double scale_ratio, int tile_size);
+
+    //False until constructed with a base scale
+    bool valid() const;
+
+    //Level whose scale is nearest to scale world units per pixel
+    int level_for(double scale) const;
+
+    //World units per pixel of a level
+    double level_scale(int level) const;
+
+    //World rectangle covered by a tile
+    ezgl::rectangle tile_bounds(const TileKey &key) const;
+
+    //Tiles of level intersecting the world rectangle, row by row
+    std::vector<TileKey> tiles_in(const ezgl::rectangle &world, int level) const;
+
+    int tile_size() const;
+
+private:
+    ezgl::point2d origin = {0, 0};
+    double base_scale = 0;
+    double scale_ratio = 1;
+    int size = 0;
+};
+
+//Rendered tiles, most recently used first, evicting the least recently used
+//once their images take more than max_bytes. Owns the tile surfaces
+class TileCache{
+public:
+    explicit TileCache(size_t max_bytes);
+    ~TileCache();
+
+    TileCache(const TileCache &) = delete;
+    TileCache &operator=(const TileCache &) = delete;
+
+    //Surface of a cached tile, now the most recently used, or nullptr
+    ezgl::surface *find(const TileKey &key);
+
+    //Adds a rendered tile, replacing any tile with the same key
+    void insert(const TileKey &key, ezgl::surface *tile);
+
+    //Frees every tile, e.g. when the base map's style changes
+    void clear();
+
+    size_t size() const;
+
+    //Bytes of tile images held
+    size_t memory_usage() const;
+
+    //Lookups that found / didn't find their tile
+    unsigned long hit_count() const;
+    unsigned long miss_count() const;
+
+private:
+    struct Entry{
+        TileKey key;
+        ezgl::surface *tile;
+        size_t bytes;
+    };
+
+    std::list<Entry> entries;
+    std::unordered_map<TileKey, std::list<Entry>::iterator, TileKeyHash> index;
+    size_t max_bytes;
+    size_t bytes = 0;
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+
+    void evict_to(size_t limit);
+};
+
+#endif /* TILE_CACHE_H */
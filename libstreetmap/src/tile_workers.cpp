@@ -0,0 +1,123 @@
+/*
+ * Tile rendering threads. Requests wait in a queue that the GTK thread
+ * replaces with each frame's missing tiles, so tiles of views panned past
+ * are never rendered. A generation count lets invalidate() discard tiles
+ * rendered in an old style without waiting for them.
+ */
+
+#include "tile_workers.h"
+
+TileWorkers::TileWorkers(unsigned m_thread_count, render_fn m_render, std::function<void()> m_on_finished)
+    : render(m_render), on_finished(m_on_finished){
+
+    for(unsigned i = 0; i < m_thread_count; i++){
+        threads.push_back(std::thread(&TileWorkers::run, this));
+    }
+}
+
+TileWorkers::~TileWorkers(){
+
+    {
+        std::lock_guard<std::mutex> m_lock(mutex);
+        stopping = true;
+        waiting.clear();
+    }
+    work_ready.notify_all();
+    for(unsigned i = 0; i < threads.size(); i++){
+        threads[i].join();
+    }
+    for(unsigned i = 0; i < finished.size(); i++){
+        ezgl::renderer::free_surface(finished[i].second);
+    }
+}
+
+void TileWorkers::request(const std::vector<TileRequest> &requests){
+
+    {
+        std::lock_guard<std::mutex> m_lock(mutex);
+        for(unsigned i = 0; i < waiting.size(); i++){
+            requested.erase(waiting[i].key);
+        }
+        waiting.clear();
+        for(unsigned i = 0; i < requests.size(); i++){
+            if(requested.insert(requests[i].key).second){
+                waiting.push_back(requests[i]);
+            }
+        }
+    }
+    work_ready.notify_all();
+}
+
+std::vector<std::pair<TileKey, ezgl::surface *> > TileWorkers::take_finished(){
+
+    std::lock_guard<std::mutex> m_lock(mutex);
+    std::vector<std::pair<TileKey, ezgl::surface *> > m_tiles;
+    m_tiles.swap(finished);
+    for(unsigned i = 0; i < m_tiles.size(); i++){
+        requested.erase(m_tiles[i].first);
+    }
+    return m_tiles;
+}
+
+void TileWorkers::invalidate(){
+
+    std::lock_guard<std::mutex> m_lock(mutex);
+    generation++;
+    waiting.clear();
+    requested.clear();
+    for(unsigned i = 0; i < finished.size(); i++){
+        ezgl::renderer::free_surface(finished[i].second);
+    }
+    finished.clear();
+    idle.notify_all();
+}
+
+void TileWorkers::wait_idle(){
+
+    std::unique_lock<std::mutex> m_lock(mutex);
+    idle.wait(m_lock, [this]{ return waiting.empty() && rendering == 0; });
+}
+
+unsigned TileWorkers::thread_count() const{
+
+    return threads.size();
+}
+
+//Renders waiting tiles until stopped
+void TileWorkers::run(){
+
+    std::unique_lock<std::mutex> m_lock(mutex);
+    while(true){
+        work_ready.wait(m_lock, [this]{ return stopping || !waiting.empty(); });
+        if(stopping){
+            return;
+        }
+        TileRequest m_request = waiting.front();
+        waiting.pop_front();
+        unsigned m_generation = generation;
+        rendering++;
+
+        m_lock.unlock();
+        ezgl::surface *m_tile = render(m_request);
+        m_lock.lock();
+
+        rendering--;
+        bool m_wake = false;
+        if(m_generation == generation){
+            m_wake = finished.empty();
+            finished.push_back({m_request.key, m_tile});
+        }else{
+            ezgl::renderer::free_surface(m_tile);
+        }
+        if(waiting.empty() && rendering == 0){
+            idle.notify_all();
+        }
+
+        //Only the first tile of a batch needs to wake the GTK thread
+        if(m_wake && !stopping){
+            m_lock.unlock();
+            on_finished();
+            m_lock.lock();
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   tile_workers.h
+ *
+ * Background threads rendering base map tiles off the GTK main thread
+ */
+
+#ifndef TILE_WORKERS_H
+#define TILE_WORKERS_H
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <utility>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "tile_cache.h"
+#include "map_style.h"
+
+//Tile to render: its key, holding the zoom level of the view it was
+//requested for, where it is, and the style of that view
+struct TileRequest{
+    TileKey key;
+    ezgl::rectangle bounds;
+    MapStyle style;
+};
+
+//Pool of threads rendering requested tiles into image surfaces. The GTK
+//thread requests the tiles it is missing and collects finished ones with
+//take_finished() without ever waiting on a render. on_finished is called on
+//the worker thread when finished tiles become available, to wake the GTK
+//thread (e.g. with g_idle_add())
+class TileWorkers{
+public:
+    using render_fn = std::function<ezgl::surface *(const TileRequest &)>;
+
+    TileWorkers(unsigned thread_count, render_fn render, std::function<void()> on_finished);
+
+    //Drops waiting requests, waits for tiles being rendered and frees every
+    //tile not taken
+    ~TileWorkers();
+
+    TileWorkers(const TileWorkers &) = delete;
+    TileWorkers &operator=(const TileWorkers &) = delete;
+
+    //Replaces the waiting requests, which are rendered in the given order.
+    //Tiles already being rendered or finished are not requested again
+    void request(const std::vector<TileRequest> &requests);
+
+    //Tiles finished since the last call; the caller owns the surfaces
+    std::vector<std::pair<TileKey, ezgl::surface *> > take_finished();
+
+    //Drops waiting requests and discards tiles started before the call, for
+    //when the base map changes style
+    void invalidate();
+
+    //Blocks until no tile is waiting or being rendered
+    void wait_idle();
+
+    unsigned thread_count() const;
+
+private:
+    render_fn render;
+    std::function<void()> on_finished;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable idle;
+
+    std::deque<TileRequest> waiting;
+    std::vector<std::pair<TileKey, ezgl::surface *> > finished;
+
+    //Keys waiting, being rendered or finished and not yet taken
+    std::unordered_set<TileKey, TileKeyHash> requested;
+
+    unsigned rendering = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+
+    void run();
+};
+
+#endif /* TILE_WORKERS_H */
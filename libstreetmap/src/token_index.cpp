@@ -0,0 +1,211 @@
+/*
+ * Inverted token index for searching point of interest and intersection
+ * names by word. Postings and per-name token lists are flat arrays, built by
+ * tokenizing names and sorting (token, id) pairs over all threads.
+ */
+
+#include "token_index.h"
+#include <algorithm>
+#include <utility>
+#include <cctype>
+
+//Number of runs the (token, id) pairs are sorted in before being merged
+#define TOKEN_INDEX_SORT_RUNS 16
+
+//Unions of more than 1/TOKEN_INDEX_BITMAP_RATIO of all names are built with
+//a bitmap over the names rather than by sorting
+#define TOKEN_INDEX_BITMAP_RATIO 32
+
+//Splits name into lower cased tokens
+std::vector<std::string> tokenize_name(const std::string &name){
+
+    std::vector<std::string> m_tokens;
+    std::string m_token;
+    for(unsigned char c : name){
+        if(c == '\''){
+            continue;
+        }
+        if(isalnum(c) || c >= 128){
+            m_token.push_back(tolower(c));
+        }else if(!m_token.empty()){
+            m_tokens.push_back(m_token);
+            m_token.clear();
+        }
+    }
+    if(!m_token.empty()){
+        m_tokens.push_back(m_token);
+    }
+    return m_tokens;
+}
+
+//Builds the dictionary, postings and per-name token lists
+void TokenIndex::build(const std::vector<std::string> &names){
+
+    //Distinct tokens of every name
+    std::vector<std::vector<std::string> > m_name_tokens(names.size());
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(unsigned i = 0; i < names.size(); i++){
+        m_name_tokens[i] = tokenize_name(names[i]);
+        std::sort(m_name_tokens[i].begin(), m_name_tokens[i].end());
+        m_name_tokens[i].erase(std::unique(m_name_tokens[i].begin(), m_name_tokens[i].end()), m_name_tokens[i].end());
+    }
+
+    std::vector<std::pair<std::string, unsigned> > m_pairs;
+    for(unsigned i = 0; i < names.size(); i++){
+        for(unsigned j = 0; j < m_name_tokens[i].size(); j++){
+            m_pairs.push_back({std::move(m_name_tokens[i][j]), i});
+        }
+    }
+
+    //Sort runs in parallel, then merge neighbouring runs in rounds
+    std::vector<size_t> m_run_begin(TOKEN_INDEX_SORT_RUNS+1);
+    for(unsigned r = 0; r <= TOKEN_INDEX_SORT_RUNS; r++){
+        m_run_begin[r] = m_pairs.size()*r/TOKEN_INDEX_SORT_RUNS;
+    }
+    #pragma omp parallel for
+    for(unsigned r = 0; r < TOKEN_INDEX_SORT_RUNS; r++){
+        std::sort(m_pairs.begin()+m_run_begin[r], m_pairs.begin()+m_run_begin[r+1]);
+    }
+    for(unsigned width = 1; width < TOKEN_INDEX_SORT_RUNS; width *= 2){
+        #pragma omp parallel for
+        for(unsigned r = 0; r < TOKEN_INDEX_SORT_RUNS-width; r += 2*width){
+            std::inplace_merge(m_pairs.begin()+m_run_begin[r], m_pairs.begin()+m_run_begin[r+width],
+                               m_pairs.begin()+m_run_begin[std::min(r+2*width, (unsigned)TOKEN_INDEX_SORT_RUNS)]);
+        }
+    }
+
+    //Number the distinct tokens; each token's ids are already increasing
+    token_chars.clear();
+    token_begin.clear();
+    posting_begin.clear();
+    posting_ids.assign(m_pairs.size(), 0);
+    std::vector<unsigned> m_pair_token(m_pairs.size());
+    for(unsigned i = 0; i < m_pairs.size(); i++){
+        if(i == 0 || m_pairs[i].first != m_pairs[i-1].first){
+            token_begin.push_back(token_chars.size());
+            posting_begin.push_back(i);
+            token_chars.insert(token_chars.end(), m_pairs[i].first.begin(), m_pairs[i].first.end());
+        }
+        posting_ids[i] = m_pairs[i].second;
+        m_pair_token[i] = token_begin.size()-1;
+    }
+    token_begin.push_back(token_chars.size());
+    posting_begin.push_back(m_pairs.size());
+
+    //Per-name token numbers, increasing since pairs are in token order
+    name_begin.assign(names.size()+1, 0);
+    for(unsigned i = 0; i < m_pairs.size(); i++){
+        name_begin[m_pairs[i].second+1]++;
+    }
+    for(unsigned i = 0; i < names.size(); i++){
+        name_begin[i+1] += name_begin[i];
+    }
+    name_tokens.assign(m_pairs.size(), 0);
+    std::vector<unsigned> m_next(name_begin.begin(), name_begin.end()-1);
+    for(unsigned i = 0; i < m_pairs.size(); i++){
+        name_tokens[m_next[m_pairs[i].second]++] = m_pair_token[i];
+    }
+}
+
+//Negative if token sorts before every token starting with prefix, zero if it
+//starts with prefix, positive if it sorts after
+int TokenIndex::compare_prefix(unsigned token, const std::string &prefix) const{
+
+    unsigned m_length = token_begin[token+1]-token_begin[token];
+    unsigned m_common = std::min<unsigned>(m_length, prefix.size());
+    for(unsigned i = 0; i < m_common; i++){
+        char m_char = token_chars[token_begin[token]+i];
+        if(m_char != prefix[i]){
+            return (unsigned char)m_char < (unsigned char)prefix[i] ? -1 : 1;
+        }
+    }
+    return m_length < prefix.size() ? -1 : 0;
+}
+
+//Sets [first, last) to the tokens starting with prefix
+void TokenIndex::find_token_range(const std::string &prefix, unsigned &first, unsigned &last) const{
+
+    unsigned m_lo = 0, m_hi = token_count();
+    while(m_lo < m_hi){
+        unsigned m_mid = (m_lo+m_hi)/2;
+        if(compare_prefix(m_mid, prefix) < 0) m_lo = m_mid+1;
+        else m_hi = m_mid;
+    }
+    first = m_lo;
+    m_hi = token_count();
+    while(m_lo < m_hi){
+        unsigned m_mid = (m_lo+m_hi)/2;
+        if(compare_prefix(m_mid, prefix) <= 0) m_lo = m_mid+1;
+        else m_hi = m_mid;
+    }
+    last = m_lo;
+}
+
+//Ids of the names matching every token of query
+std::vector<unsigned> TokenIndex::find(const std::string &query) const{
+
+    std::vector<std::string> m_tokens = tokenize_name(query);
+    if(m_tokens.empty()){
+        return std::vector<unsigned>();
+    }
+
+    //Token range of each query token; start from the one with fewest ids
+    std::vector<std::pair<unsigned, unsigned> > m_ranges(m_tokens.size());
+    unsigned m_rarest = 0;
+    for(unsigned i = 0; i < m_tokens.size(); i++){
+        find_token_range(m_tokens[i], m_ranges[i].first, m_ranges[i].second);
+        if(m_ranges[i].first == m_ranges[i].second){
+            return std::vector<unsigned>();
+        }
+        if(posting_begin[m_ranges[i].second]-posting_begin[m_ranges[i].first] <
+           posting_begin[m_ranges[m_rarest].second]-posting_begin[m_ranges[m_rarest].first]){
+            m_rarest = i;
+        }
+    }
+
+    //Union of the range's id lists; a large union is marked in a bitmap
+    //instead of sorted
+    std::vector<unsigned>::const_iterator m_begin = posting_ids.begin()+posting_begin[m_ranges[m_rarest].first];
+    std::vector<unsigned>::const_iterator m_end = posting_ids.begin()+posting_begin[m_ranges[m_rarest].second];
+    std::vector<unsigned> m_ids;
+    if(m_ranges[m_rarest].second-m_ranges[m_rarest].first == 1){
+        m_ids.assign(m_begin, m_end);
+    }else if((size_t)(m_end-m_begin)*TOKEN_INDEX_BITMAP_RATIO < name_begin.size()){
+        m_ids.assign(m_begin, m_end);
+        std::sort(m_ids.begin(), m_ids.end());
+        m_ids.erase(std::unique(m_ids.begin(), m_ids.end()), m_ids.end());
+    }else{
+        std::vector<bool> m_marked(name_begin.size()-1, false);
+        for(std::vector<unsigned>::const_iterator i = m_begin; i != m_end; i++){
+            m_marked[*i] = true;
+        }
+        for(unsigned id = 0; id < m_marked.size(); id++){
+            if(m_marked[id]) m_ids.push_back(id);
+        }
+    }
+
+    //Keep the names that also have a token in every other range
+    for(unsigned i = 0; i < m_ranges.size(); i++){
+        if(i == m_rarest) continue;
+        unsigned m_first = m_ranges[i].first, m_last = m_ranges[i].second;
+        m_ids.erase(std::remove_if(m_ids.begin(), m_ids.end(), [&](unsigned id){
+            std::vector<unsigned>::const_iterator m_tokens_end = name_tokens.begin()+name_begin[id+1];
+            std::vector<unsigned>::const_iterator m_token = std::lower_bound(name_tokens.begin()+name_begin[id], m_tokens_end, m_first);
+            return m_token == m_tokens_end || *m_token >= m_last;
+        }), m_ids.end());
+    }
+    return m_ids;
+}
+
+unsigned TokenIndex::token_count() const{
+
+    return token_begin.empty() ? 0 : token_begin.size()-1;
+}
+
+//Bytes used by the index's arrays
+size_t TokenIndex::memory_usage() const{
+
+    return token_chars.capacity()*sizeof(char) + token_begin.capacity()*sizeof(unsigned)
+         + posting_begin.capacity()*sizeof(unsigned) + posting_ids.capacity()*sizeof(unsigned)
+         + name_begin.capacity()*sizeof(unsigned) + name_tokens.capacity()*sizeof(unsigned);
+}
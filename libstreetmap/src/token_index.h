@@ -0,0 +1,63 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   token_index.h
+ *
+ * Inverted index from the words of names to the ids of those names
+ */
+
+#ifndef TOKEN_INDEX_H
+#define TOKEN_INDEX_H
+#include <vector>
+#include <string>
+
+//Splits name into lower cased tokens, each a run of letters, digits and
+//non-ASCII characters. Apostrophes are dropped ("Tim Horton's" -> "tim",
+//"hortons") and anything else separates tokens
+std::vector<std::string> tokenize_name(const std::string &name);
+
+//Sorted token dictionary stored in flat arrays, with the ids of the names
+//containing each token. Tokens starting with a prefix are a contiguous range
+//of the dictionary, and the tokens of each name are kept as dictionary
+//numbers so a candidate can be checked against a range without touching the
+//other tokens' id lists
+class TokenIndex{
+public:
+    //Builds the index from one name per id. Tokenizing and sorting run over
+    //all OpenMP threads
+    void build(const std::vector<std::string> &names);
+
+    //Ids, in increasing order, of the names having for every token of query a
+    //token starting with it, e.g. "king st" finds "King Street East & Bay
+    //Street". Empty if query has no tokens
+    std::vector<unsigned> find(const std::string &query) const;
+
+    unsigned token_count() const;
+
+    //Bytes used by the index's arrays
+    size_t memory_usage() const;
+
+private:
+    //Token t is token_chars[token_begin[t], token_begin[t+1]); tokens are
+    //distinct and sorted
+    std::vector<char> token_chars;
+    std::vector<unsigned> token_begin;
+
+    //Ids of the names containing token t, increasing:
+    //posting_ids[posting_begin[t], posting_begin[t+1])
+    std::vector<unsigned> posting_begin;
+    std::vector<unsigned> posting_ids;
+
+    //Distinct tokens of name id: name_tokens[name_begin[id], name_begin[id+1])
+    std::vector<unsigned> name_begin;
+    std::vector<unsigned> name_tokens;
+
+    int compare_prefix(unsigned token, const std::string &prefix) const;
+    void find_token_range(const std::string &prefix, unsigned &first, unsigned &last) const;
+};
+
+#endif /* TOKEN_INDEX_H */
@@ -0,0 +1,39 @@
+/*
+ * Checks the batched closest intersection query agrees with one
+ * find_closest_intersection() call per point.
+ */
+#include <random>
+#include <algorithm>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "batch.h"
+#include "map_fixture.h"
+
+#define BATCH_TEST_POINTS 100000
+
+SUITE(batch_nearest){
+
+    TEST_FIXTURE(MapFixture, batch_matches_single){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        //GPS-like pings scattered around random intersections
+        std::mt19937 rng(297);
+        std::uniform_int_distribution<int> intersection(0, getNumIntersections()-1);
+        std::normal_distribution<double> noise(0, 0.0005);
+        std::vector<LatLon> pings(BATCH_TEST_POINTS);
+        for(unsigned i = 0; i < pings.size(); i++){
+            LatLon center = getIntersectionPosition(intersection(rng));
+            pings[i] = LatLon(center.lat()+noise(rng), center.lon()+noise(rng));
+        }
+
+        std::vector<unsigned> single(pings.size());
+        for(unsigned i = 0; i < pings.size(); i++){
+            single[i] = find_closest_intersection(pings[i]);
+        }
+        std::vector<unsigned> batch = find_closest_intersections(pings);
+
+        CHECK(single == batch);
+    }
+}
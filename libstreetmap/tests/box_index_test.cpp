@@ -0,0 +1,119 @@
+/*
+ * Checks the view culling queries of the segment R-tree and the box R-tree
+ * against full scans.
+ */
+#include <random>
+#include <algorithm>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "segments.h"
+#include "segment_index.h"
+#include "box_index.h"
+#include "map_fixture.h"
+
+#define BOX_INDEX_VIEWS 20
+
+//Views about 1/50 of the map across
+#define BOX_INDEX_VIEW_FRACTION 0.02
+
+SUITE(box_index){
+
+    TEST(boxes_vs_scan){
+        std::mt19937 rng(41);
+        std::uniform_real_distribution<double> coordinate(0, 100), size(0, 5);
+        std::vector<Box> boxes(5000);
+        for(unsigned i = 0; i < boxes.size(); i++){
+            boxes[i].x_min = coordinate(rng);
+            boxes[i].y_min = coordinate(rng);
+            boxes[i].x_max = boxes[i].x_min+size(rng);
+            boxes[i].y_max = boxes[i].y_min+size(rng);
+        }
+        BoxIndex index;
+        index.build(boxes);
+
+        for(unsigned q = 0; q < 200; q++){
+            Box view;
+            view.x_min = coordinate(rng);
+            view.y_min = coordinate(rng);
+            view.x_max = view.x_min+4*size(rng);
+            view.y_max = view.y_min+4*size(rng);
+            std::vector<unsigned> expected;
+            for(unsigned i = 0; i < boxes.size(); i++){
+                if(boxes[i].x_min <= view.x_max && view.x_min <= boxes[i].x_max &&
+                   boxes[i].y_min <= view.y_max && view.y_min <= boxes[i].y_max){
+                    expected.push_back(i);
+                }
+            }
+            CHECK(expected == index.in_box(view));
+        }
+        CHECK(BoxIndex().in_box({0, 0, 1, 1}).empty());
+    }
+
+    TEST(empty_and_degenerate){
+        BoxIndex empty;
+        empty.build(std::vector<Box>());
+        CHECK(empty.in_box({0, 0, 1, 1}).empty());
+
+        //Boxes collapsed to one point are found only by views touching it
+        BoxIndex points;
+        points.build(std::vector<Box>(40, {1, 1, 1, 1}));
+        CHECK(points.in_box({2, 2, 3, 3}).empty());
+        CHECK(points.in_box({1, 1, 1, 1}).size() == 40);
+
+        //A view with its corners swapped holds nothing
+        CHECK(points.in_box({1.5, 1.5, 0.5, 0.5}).empty());
+
+        //Segment index over a map with no segments, as before any map is loaded
+        SegmentTable no_segments;
+        std::swap(segment_table, no_segments);
+        SegmentIndex no_segment_index;
+        no_segment_index.build();
+        std::swap(segment_table, no_segments);
+        CHECK(no_segment_index.in_box(-INFINITY, -INFINITY, INFINITY, INFINITY).empty());
+        CHECK(SegmentIndex().in_box(-INFINITY, -INFINITY, INFINITY, INFINITY).empty());
+    }
+
+    TEST_FIXTURE(MapFixture, visible_segments){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        double x_min = INFINITY, y_min = INFINITY, x_max = -INFINITY, y_max = -INFINITY;
+        for(unsigned p = 0; p < segment_table.points.size(); p++){
+            x_min = std::min(x_min, segment_table.points[p].x);
+            y_min = std::min(y_min, segment_table.points[p].y);
+            x_max = std::max(x_max, segment_table.points[p].x);
+            y_max = std::max(y_max, segment_table.points[p].y);
+        }
+        double width = (x_max-x_min)*BOX_INDEX_VIEW_FRACTION, height = (y_max-y_min)*BOX_INDEX_VIEW_FRACTION;
+
+        std::mt19937 rng(41);
+        std::uniform_real_distribution<double> view_x(x_min, x_max-width), view_y(y_min, y_max-height);
+        std::vector<Box> views(BOX_INDEX_VIEWS);
+        for(unsigned v = 0; v < views.size(); v++){
+            views[v].x_min = view_x(rng);
+            views[v].y_min = view_y(rng);
+            views[v].x_max = views[v].x_min+width;
+            views[v].y_max = views[v].y_min+height;
+        }
+
+        for(unsigned v = 0; v < views.size(); v++){
+            std::vector<unsigned> expected;
+            for(unsigned s = 0; s < segment_table.size(); s++){
+                bool overlaps = false;
+                for(unsigned p = segment_table.point_begin(s); p+1 < segment_table.point_end(s) && !overlaps; p++){
+                    const SegmentPoint &a = segment_table.points[p], &b = segment_table.points[p+1];
+                    overlaps = std::min(a.x, b.x) <= views[v].x_max && std::max(a.x, b.x) >= views[v].x_min &&
+                               std::min(a.y, b.y) <= views[v].y_max && std::max(a.y, b.y) >= views[v].y_min;
+                }
+                if(overlaps) expected.push_back(s);
+            }
+            CHECK(expected == segment_index.in_box(views[v].x_min, views[v].y_min, views[v].x_max, views[v].y_max));
+        }
+
+        //Views beside the map or with their corners swapped hold nothing
+        CHECK(segment_index.in_box(x_max+width, y_min, x_max+2*width, y_max).empty());
+        CHECK(segment_index.in_box(x_min, y_max+height, x_max, y_max+2*height).empty());
+        CHECK(segment_index.in_box(x_max, y_max, x_min, y_min).empty());
+    }
+}
@@ -0,0 +1,86 @@
+/*
+ * Checks the k-d tree behind find_closest_intersection() against a linear
+ * scan over every intersection, inside and outside the map's bounds and on
+ * exact ties.
+ */
+#include <random>
+#include <algorithm>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "map_fixture.h"
+
+#define CLOSEST_TEST_POINTS 1000
+
+//Each scan is linear, so only every this many intersections and segments are tried
+#define CLOSEST_TEST_STRIDE 97
+
+//Closest intersection by scanning them all, the lowest id winning ties
+static unsigned scan_closest_intersection(LatLon position){
+    unsigned closest = 0;
+    double closest_distance = find_distance_between_two_points(position, getIntersectionPosition(0));
+    for(int i = 1; i < getNumIntersections(); i++){
+        double distance = find_distance_between_two_points(position, getIntersectionPosition(i));
+        if(distance < closest_distance){
+            closest_distance = distance;
+            closest = i;
+        }
+    }
+    return closest;
+}
+
+SUITE(closest_intersection){
+
+    TEST_FIXTURE(MapFixture, matches_scan_inside_and_outside_bounds){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        double min_lat = 90, max_lat = -90, min_lon = 180, max_lon = -180;
+        for(int i = 0; i < getNumIntersections(); i++){
+            LatLon position = getIntersectionPosition(i);
+            min_lat = std::min(min_lat, (double)position.lat());
+            max_lat = std::max(max_lat, (double)position.lat());
+            min_lon = std::min(min_lon, (double)position.lon());
+            max_lon = std::max(max_lon, (double)position.lon());
+        }
+
+        //Uniform over the bounding box grown by its own size on every side,
+        //so most of the points lie outside it
+        std::mt19937 rng(297);
+        std::uniform_real_distribution<double> lat(2*min_lat-max_lat, 2*max_lat-min_lat);
+        std::uniform_real_distribution<double> lon(2*min_lon-max_lon, 2*max_lon-min_lon);
+        for(unsigned i = 0; i < CLOSEST_TEST_POINTS; i++){
+            LatLon position(lat(rng), lon(rng));
+            CHECK_EQUAL(scan_closest_intersection(position), find_closest_intersection(position));
+        }
+
+        //Far from the map, including across the antimeridian and at the poles
+        LatLon far_away[] = {LatLon(0, 0), LatLon(-min_lat, min_lon+180), LatLon(89.9, max_lon), LatLon(-89.9, min_lon)};
+        for(LatLon position : far_away){
+            CHECK_EQUAL(scan_closest_intersection(position), find_closest_intersection(position));
+        }
+    }
+
+    TEST_FIXTURE(MapFixture, ties_resolve_to_lowest_id){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        //Each intersection's own position is at distance 0 from it and from
+        //any other intersection at the same position
+        for(int i = 0; i < getNumIntersections(); i += CLOSEST_TEST_STRIDE){
+            LatLon position = getIntersectionPosition(i);
+            unsigned found = find_closest_intersection(position);
+            CHECK_EQUAL(scan_closest_intersection(position), found);
+            CHECK(found <= (unsigned)i);
+        }
+
+        //Midpoints of the segments are often equally far from both ends
+        for(int i = 0; i < getNumStreetSegments(); i += CLOSEST_TEST_STRIDE){
+            InfoStreetSegment info = getInfoStreetSegment(i);
+            LatLon from = getIntersectionPosition(info.from);
+            LatLon to = getIntersectionPosition(info.to);
+            LatLon position((from.lat()+to.lat())/2, (from.lon()+to.lon())/2);
+            CHECK_EQUAL(scan_closest_intersection(position), find_closest_intersection(position));
+        }
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * Checks the label occupancy grid's collision tests, including across cells
+ * on both sides of the origin, and which tiles a label reaches.
+ */
+#include <cmath>
+#include <unittest++/UnitTest++.h>
+#include "label_placement.h"
+
+SUITE(label_placement){
+
+    TEST(rotated_overlap){
+        double diagonal = std::sqrt(0.5);
+        LabelBox flat = {{100, 100}, {1, 0}, 40, 5};
+
+        //Boxes whose bounds overlap but whose rotated rectangles do not
+        LabelBox tilted = {{150, 85}, {diagonal, diagonal}, 20, 5};
+        CHECK(!labels_overlap(flat, tilted));
+        CHECK(!labels_overlap(tilted, flat));
+
+        LabelBox crossing = {{100, 100}, {0, 1}, 40, 5};
+        CHECK(labels_overlap(flat, crossing));
+
+        LabelBox beside = {{100, 111}, {1, 0}, 40, 5};
+        CHECK(!labels_overlap(flat, beside));
+        beside.center.y = 109;
+        CHECK(labels_overlap(flat, beside));
+    }
+
+    TEST(grid_placement){
+        LabelGrid grid(64);
+
+        CHECK(grid.place({{100, 100}, {1, 0}, 40, 5}));
+        CHECK(!grid.place({{130, 102}, {1, 0}, 40, 5}));
+        CHECK(grid.place({{100, 120}, {1, 0}, 40, 5}));
+
+        //Boxes spanning several cells still find their neighbours
+        CHECK(grid.place({{250, 150}, {0, 1}, 120, 6}));
+        CHECK(!grid.place({{200, 250}, {1, 0}, 60, 5}));
+
+        //The plane has no edges: boxes across the origin collide as anywhere
+        CHECK(grid.place({{-10, -10}, {1, 0}, 40, 5}));
+        CHECK(!grid.place({{20, -12}, {0, 1}, 20, 5}));
+        CHECK(grid.place({{-10, 10}, {1, 0}, 40, 5}));
+        CHECK(!grid.place({{-45, 0}, {0, 1}, 40, 5}));
+        CHECK_EQUAL(5u, grid.size());
+    }
+
+    TEST(label_across_tile_edge){
+        Box left_tile = {0, 0, 256, 256}, right_tile = {256, 0, 512, 256};
+
+        //A POI name centered 20 pixels left of the edge, 100 pixels wide
+        LabelBox name = {{236, 100}, {1, 0}, 50, 7};
+        CHECK(label_touches(name, left_tile));
+        CHECK(label_touches(name, right_tile));
+
+        //A name short enough to end before the edge only reaches its own tile
+        LabelBox short_name = {{236, 100}, {1, 0}, 15, 7};
+        CHECK(label_touches(short_name, left_tile));
+        CHECK(!label_touches(short_name, right_tile));
+
+        //Centered past the tile's corner, it still reaches the tile's corner
+        LabelBox corner = {{-40, 260}, {1, 0}, 50, 7};
+        CHECK(label_touches(corner, left_tile));
+        CHECK(!label_touches(corner, right_tile));
+
+        //A rotated label reaches as far as its bounds
+        double diagonal = std::sqrt(0.5);
+        LabelBox tilted = {{240, 300}, {diagonal, -diagonal}, 60, 5};
+        CHECK(label_touches(tilted, left_tile));
+        CHECK(label_touches(tilted, right_tile));
+    }
+}
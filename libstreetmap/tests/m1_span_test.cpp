@@ -0,0 +1,38 @@
+/*
+ * Checks the IdSpan variants of the m1 id list accessors return the same ids
+ * as the copying accessors.
+ */
+#include <algorithm>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "spans.h"
+#include "map_fixture.h"
+
+SUITE(m1_span_accessors){
+
+    TEST_FIXTURE(MapFixture, span_matches_vector){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        for(int i = 0; i < getNumIntersections(); i++){
+            std::vector<unsigned> segments = find_intersection_street_segments(i);
+            IdSpan segments_span = find_intersection_street_segments_span(i);
+            CHECK(std::equal(segments.begin(), segments.end(), segments_span.begin(), segments_span.end()));
+
+            std::vector<unsigned> adjacent = find_adjacent_intersections(i);
+            IdSpan adjacent_span = find_adjacent_intersections_span(i);
+            CHECK(std::equal(adjacent.begin(), adjacent.end(), adjacent_span.begin(), adjacent_span.end()));
+        }
+
+        for(int i = 0; i < getNumStreets(); i++){
+            std::vector<unsigned> segments = find_street_street_segments(i);
+            IdSpan segments_span = find_street_street_segments_span(i);
+            CHECK(std::equal(segments.begin(), segments.end(), segments_span.begin(), segments_span.end()));
+
+            std::vector<unsigned> intersections = find_all_street_intersections(i);
+            IdSpan intersections_span = find_all_street_intersections_span(i);
+            CHECK(std::equal(intersections.begin(), intersections.end(), intersections_span.begin(), intersections_span.end()));
+        }
+    }
+}
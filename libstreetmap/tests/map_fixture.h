@@ -0,0 +1,23 @@
+/*
+ * Fixture loading the test map for the length of one test, shared by the
+ * tests that run against real map data.
+ */
+#ifndef MAP_FIXTURE_H
+#define MAP_FIXTURE_H
+#include "m1.h"
+
+#define TEST_MAP "/cad2/ece297s/public/maps/toronto_canada.streets.bin"
+
+struct MapFixture{
+    MapFixture(){
+        loaded = load_map(TEST_MAP);
+    }
+
+    ~MapFixture(){
+        if(loaded) close_map();
+    }
+
+    bool loaded;
+};
+
+#endif /* MAP_FIXTURE_H */
@@ -0,0 +1,95 @@
+/*
+ * Matches noisy GPS traces sampled along computed routes and checks they
+ * land back on the route's segments.
+ */
+#include <random>
+#include <set>
+#include <algorithm>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "m3.h"
+#include "StreetsDatabaseAPI.h"
+#include "map_matching.h"
+#include "map_fixture.h"
+
+#define MATCH_TEST_TRACES 200
+#define MATCH_TEST_SPACING 20
+#define MATCH_TEST_NOISE 5
+
+SUITE(map_matching){
+
+    //Polyline of a path in driving order
+    static std::vector<LatLon> path_polyline(unsigned start, const std::vector<unsigned> &path){
+        std::vector<LatLon> polyline(1, getIntersectionPosition(start));
+        unsigned current = start;
+        for(unsigned i = 0; i < path.size(); i++){
+            InfoStreetSegment info = getInfoStreetSegment(path[i]);
+            std::vector<LatLon> points;
+            for(int c = 0; c < info.curvePointCount; c++){
+                points.push_back(getStreetSegmentCurvePoint(c, path[i]));
+            }
+            if(unsigned(info.from) != current){
+                std::reverse(points.begin(), points.end());
+            }
+            current = unsigned(info.from) == current ? info.to : info.from;
+            points.push_back(getIntersectionPosition(current));
+            polyline.insert(polyline.end(), points.begin(), points.end());
+        }
+        return polyline;
+    }
+
+    //GPS-like samples every MATCH_TEST_SPACING meters with Gaussian noise
+    static std::vector<LatLon> sample_trace(const std::vector<LatLon> &polyline, std::mt19937 &rng){
+        std::normal_distribution<double> noise(0, MATCH_TEST_NOISE/111000.0);
+        std::vector<LatLon> trace;
+        double walked = 0, next = 0;
+        for(unsigned i = 0; i+1 < polyline.size(); i++){
+            double length = find_distance_between_two_points(polyline[i], polyline[i+1]);
+            for(; length > 0 && next <= walked+length; next += MATCH_TEST_SPACING){
+                double t = (next-walked)/length;
+                trace.push_back(LatLon(polyline[i].lat()+t*(polyline[i+1].lat()-polyline[i].lat())+noise(rng),
+                                       polyline[i].lon()+t*(polyline[i+1].lon()-polyline[i].lon())+noise(rng)));
+            }
+            walked += length;
+        }
+        return trace;
+    }
+
+    TEST_FIXTURE(MapFixture, traces_follow_routes){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        std::mt19937 rng(297);
+        std::uniform_int_distribution<int> intersection(0, getNumIntersections()-1);
+        std::vector<std::vector<LatLon> > traces;
+        std::vector<std::set<unsigned> > routes;
+        while(traces.size() < MATCH_TEST_TRACES){
+            unsigned start = intersection(rng), end = intersection(rng);
+            std::vector<unsigned> path = find_path_between_intersections(start, end, 0, 0);
+            if(path.empty()) continue;
+            traces.push_back(sample_trace(path_polyline(start, path), rng));
+            routes.push_back(std::set<unsigned>(path.begin(), path.end()));
+        }
+
+        std::vector<std::vector<MatchedPoint> > matched = match_traces(traces);
+
+        unsigned points = 0, on_route = 0;
+        for(unsigned i = 0; i < traces.size(); i++){
+            CHECK_EQUAL(traces[i].size(), matched[i].size());
+            for(unsigned j = 0; j < matched[i].size(); j++){
+                points++;
+                on_route += routes[i].count(matched[i][j].segment);
+            }
+        }
+        CHECK(on_route >= 0.9*points);
+
+        //A small window commits early but must still return every point in order
+        MatchSettings streaming;
+        streaming.window = 3;
+        std::vector<MatchedPoint> short_window = match_trace(traces[0], streaming);
+        CHECK_EQUAL(traces[0].size(), short_window.size());
+        for(unsigned j = 0; j < short_window.size() && j < traces[0].size(); j++){
+            CHECK_EQUAL(traces[0][j].lat(), short_window[j].gps.lat());
+        }
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Checks the point of interest and intersection word searches against a scan
+ * of every name, and the batched searches against single queries.
+ */
+#include <random>
+#include <algorithm>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "name_search.h"
+#include "batch.h"
+#include "token_index.h"
+#include "map_fixture.h"
+
+#define NAME_SEARCH_QUERIES 2000
+
+SUITE(name_search){
+
+    //True if name has, for every token of query, a token starting with it
+    static bool scan_match(const std::string &name, const std::string &query){
+        std::vector<std::string> name_tokens = tokenize_name(name);
+        std::vector<std::string> query_tokens = tokenize_name(query);
+        if(query_tokens.empty()) return false;
+        for(unsigned q = 0; q < query_tokens.size(); q++){
+            bool found = false;
+            for(unsigned n = 0; n < name_tokens.size() && !found; n++){
+                found = name_tokens[n].compare(0, query_tokens[q].size(), query_tokens[q]) == 0;
+            }
+            if(!found) return false;
+        }
+        return true;
+    }
+
+    //Queries made of one or two word prefixes taken from a random name
+    static std::vector<std::string> make_queries(const std::vector<std::string> &names, unsigned count){
+        std::mt19937 rng(40);
+        std::vector<std::string> queries;
+        while(queries.size() < count){
+            std::vector<std::string> tokens = tokenize_name(names[rng()%names.size()]);
+            if(tokens.empty()) continue;
+            std::string query;
+            for(unsigned t = 0; t < tokens.size() && t < 1+rng()%2; t++){
+                unsigned at = rng()%tokens.size();
+                query += tokens[at].substr(0, 1+rng()%tokens[at].size()) + " ";
+            }
+            queries.push_back(query);
+        }
+        return queries;
+    }
+
+    TEST(tokenize){
+        std::vector<std::string> expected = {"tim", "hortons", "king", "st", "w"};
+        CHECK(expected == tokenize_name("Tim Horton's (King St. W)"));
+        CHECK(tokenize_name(" & ").empty());
+    }
+
+    TEST_FIXTURE(MapFixture, search_vs_scan){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        std::vector<std::string> poi_names(getNumPointsOfInterest());
+        for(unsigned i = 0; i < poi_names.size(); i++) poi_names[i] = getPointOfInterestName(i);
+        std::vector<std::string> intersection_names(getNumIntersections());
+        for(unsigned i = 0; i < intersection_names.size(); i++) intersection_names[i] = getIntersectionName(i);
+
+        std::vector<std::string> poi_queries = make_queries(poi_names, NAME_SEARCH_QUERIES);
+        std::vector<std::string> intersection_queries = make_queries(intersection_names, NAME_SEARCH_QUERIES);
+        poi_queries.push_back("#no such place#");
+        poi_queries.push_back("");
+
+        for(unsigned q = 0; q < poi_queries.size(); q += 37){
+            std::vector<unsigned> expected;
+            for(unsigned i = 0; i < poi_names.size(); i++){
+                if(scan_match(poi_names[i], poi_queries[q])) expected.push_back(i);
+            }
+            CHECK(expected == find_points_of_interest_by_name(poi_queries[q]));
+        }
+        for(unsigned q = 0; q < intersection_queries.size(); q += 37){
+            std::vector<unsigned> expected;
+            for(unsigned i = 0; i < intersection_names.size(); i++){
+                if(scan_match(intersection_names[i], intersection_queries[q])) expected.push_back(i);
+            }
+            CHECK(expected == find_intersections_by_name(intersection_queries[q]));
+        }
+
+        std::vector<std::vector<unsigned> > single(intersection_queries.size());
+        for(unsigned q = 0; q < intersection_queries.size(); q++){
+            single[q] = find_intersections_by_name(intersection_queries[q]);
+        }
+        std::vector<std::vector<unsigned> > batch = find_intersections_by_names(intersection_queries);
+        CHECK(single == batch);
+
+        std::vector<std::vector<unsigned> > poi_batch = find_points_of_interest_by_names(poi_queries);
+        CHECK_EQUAL(poi_queries.size(), poi_batch.size());
+        for(unsigned q = 0; q < poi_queries.size(); q++){
+            CHECK(find_points_of_interest_by_name(poi_queries[q]) == poi_batch[q]);
+        }
+    }
+}
@@ -0,0 +1,220 @@
+/*
+ * Checks the radix street name trie against a per-character pointer trie
+ * (the layout it replaced). Also checks ranked top-k autocomplete and the
+ * typo tolerant search against full scans.
+ */
+#include <map>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "name_trie.h"
+#include "street_search.h"
+#include "map_fixture.h"
+
+#define TRIE_TEST_TOP_K 10
+#define TRIE_TEST_ALL 1000000
+
+SUITE(name_trie){
+
+    //One heap node per character, each holding every id below it
+    struct PointerTrie{
+        std::vector<unsigned> street_ids;
+        std::map<char, PointerTrie*> names;
+
+        ~PointerTrie(){
+            for(std::map<char, PointerTrie*>::iterator i = names.begin(); i != names.end(); i++)
+                delete i->second;
+        }
+    };
+
+    TEST_FIXTURE(MapFixture, radix_vs_pointer_trie){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        std::vector<std::string> names(getNumStreets());
+        for(unsigned i = 0; i < names.size(); i++){
+            names[i] = getStreetName(i);
+        }
+
+        PointerTrie pointer_trie;
+        for(unsigned i = 0; i < names.size(); i++){
+            PointerTrie *current = &pointer_trie;
+            for(unsigned j = 0; j < names[i].size(); j++){
+                char c = tolower(names[i][j]);
+                if(!current->names.count(c)){
+                    current->names.insert({c, new PointerTrie()});
+                }
+                current = current->names[c];
+                current->street_ids.push_back(i);
+            }
+        }
+        NameTrie radix_trie;
+        radix_trie.build(names);
+
+        //Every prefix of every name, as typed into a search box
+        std::vector<std::string> prefixes;
+        for(unsigned i = 0; i < names.size(); i++){
+            for(unsigned length = 1; length <= names[i].size() && length <= 12; length++){
+                prefixes.push_back(names[i].substr(0, length));
+            }
+        }
+        prefixes.push_back("#no such street#");
+
+        size_t pointer_total = 0;
+        for(unsigned p = 0; p < prefixes.size(); p++){
+            const PointerTrie *current = &pointer_trie;
+            for(unsigned j = 0; j < prefixes[p].size() && current != nullptr; j++){
+                std::map<char, PointerTrie*>::const_iterator next = current->names.find(tolower(prefixes[p][j]));
+                current = next == current->names.end() ? nullptr : next->second;
+            }
+            if(current != nullptr){
+                std::vector<unsigned> found = current->street_ids;
+                pointer_total += found.size();
+            }
+        }
+        size_t radix_total = 0;
+        for(unsigned p = 0; p < prefixes.size(); p++){
+            std::vector<unsigned> found = find_street_ids_from_partial_street_name(prefixes[p]);
+            radix_total += found.size();
+        }
+        CHECK_EQUAL(pointer_total, radix_total);
+
+        //Same ids for a sample of prefixes
+        for(unsigned p = 0; p < prefixes.size(); p += 97){
+            std::vector<unsigned> expected;
+            const PointerTrie *current = &pointer_trie;
+            for(unsigned j = 0; j < prefixes[p].size() && current != nullptr; j++){
+                std::map<char, PointerTrie*>::const_iterator next = current->names.find(tolower(prefixes[p][j]));
+                current = next == current->names.end() ? nullptr : next->second;
+            }
+            if(current != nullptr){
+                expected = current->street_ids;
+            }
+            IdSpan found = radix_trie.find_prefix(prefixes[p]);
+            std::vector<unsigned> actual(found.begin(), found.end());
+            std::sort(actual.begin(), actual.end());
+            CHECK(expected == actual);
+        }
+    }
+
+    //Top k by a full scan: best street per distinct folded name, then by
+    //score with ties to the alphabetically first name
+    static std::vector<unsigned> scan_top_k(const std::string &prefix, unsigned k, double (*score)(unsigned)){
+        std::string folded_prefix = prefix;
+        std::transform(folded_prefix.begin(), folded_prefix.end(), folded_prefix.begin(), ::tolower);
+        std::map<std::string, unsigned> best;
+        for(int i = 0; i < getNumStreets(); i++){
+            std::string name = getStreetName(i);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            if(name.compare(0, folded_prefix.size(), folded_prefix) != 0) continue;
+            std::map<std::string, unsigned>::iterator found = best.find(name);
+            if(found == best.end() || score(i) > score(found->second)){
+                best[name] = i;
+            }
+        }
+        std::vector<std::pair<std::string, unsigned> > ranked(best.begin(), best.end());
+        std::stable_sort(ranked.begin(), ranked.end(), [score](const std::pair<std::string, unsigned> &a, const std::pair<std::string, unsigned> &b){
+            return score(a.second) > score(b.second);
+        });
+        std::vector<unsigned> top;
+        for(unsigned i = 0; i < ranked.size() && i < k; i++){
+            top.push_back(ranked[i].second);
+        }
+        return top;
+    }
+
+    static double street_segment_count(unsigned street_id){
+        return find_street_street_segments(street_id).size();
+    }
+
+    TEST_FIXTURE(MapFixture, top_k_autocomplete){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        std::vector<std::string> prefixes;
+        for(int i = 0; i < getNumStreets(); i++){
+            std::string name = getStreetName(i);
+            for(unsigned length = 1; length <= name.size() && length <= 6; length++){
+                prefixes.push_back(name.substr(0, length));
+            }
+        }
+
+        for(unsigned p = 0; p < prefixes.size(); p += 211){
+            CHECK(scan_top_k(prefixes[p], TRIE_TEST_TOP_K, find_street_length)
+                  == find_top_street_ids_from_partial_street_name(prefixes[p], TRIE_TEST_TOP_K));
+            CHECK(scan_top_k(prefixes[p], TRIE_TEST_TOP_K, street_segment_count)
+                  == find_top_street_ids_from_partial_street_name(prefixes[p], TRIE_TEST_TOP_K, StreetRank::SEGMENT_COUNT));
+        }
+    }
+
+    //Fewest edits (with adjacent swaps) turning query into a prefix of name
+    static unsigned prefix_edits(const std::string &query, const std::string &name){
+        std::vector<std::vector<unsigned> > table(name.size()+1, std::vector<unsigned>(query.size()+1));
+        unsigned best = query.size();
+        for(unsigned j = 0; j <= query.size(); j++) table[0][j] = j;
+        for(unsigned i = 1; i <= name.size(); i++){
+            table[i][0] = i;
+            for(unsigned j = 1; j <= query.size(); j++){
+                table[i][j] = std::min(std::min(table[i-1][j], table[i][j-1])+1, table[i-1][j-1]+(query[j-1] != name[i-1]));
+                if(i > 1 && j > 1 && query[j-1] == name[i-2] && query[j-2] == name[i-1]){
+                    table[i][j] = std::min(table[i][j], table[i-2][j-2]+1);
+                }
+            }
+            best = std::min(best, table[i][query.size()]);
+        }
+        return best;
+    }
+
+    TEST_FIXTURE(MapFixture, approximate_search){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        CHECK_EQUAL("king street east", normalize_street_name("King  St. East"));
+        CHECK_EQUAL("avenue road", normalize_street_name("Ave Rd"));
+
+        //Mistyped names: one character replaced or two neighbours swapped
+        std::mt19937 rng(39);
+        std::vector<std::string> queries;
+        std::vector<unsigned> targets;
+        for(int i = 0; i < getNumStreets() && queries.size() < 500; i += 1+getNumStreets()/500){
+            std::string name = normalize_street_name(getStreetName(i));
+            if(name.size() < 8) continue;
+            std::string typo = name;
+            unsigned at = 1+rng()%(typo.size()-2);
+            if(rng()%2) typo[at] = typo[at] == 'x' ? 'y' : 'x';
+            else std::swap(typo[at], typo[at+1]);
+            queries.push_back(typo);
+            targets.push_back(i);
+        }
+
+        unsigned found = 0;
+        for(unsigned q = 0; q < queries.size(); q++){
+            std::vector<unsigned> top = find_street_ids_from_approximate_street_name(queries[q], TRIE_TEST_TOP_K);
+            for(unsigned t = 0; t < top.size(); t++){
+                if(normalize_street_name(getStreetName(top[t])) == normalize_street_name(getStreetName(targets[q]))){
+                    found++;
+                    break;
+                }
+            }
+        }
+        CHECK(found >= 0.95*queries.size());
+
+        //Every distinct name within the bound, against a scan of all names
+        for(unsigned q = 0; q < queries.size(); q += 25){
+            std::set<std::string> expected, actual;
+            for(int i = 0; i < getNumStreets(); i++){
+                std::string name = normalize_street_name(getStreetName(i));
+                if(prefix_edits(queries[q], name) <= 2) expected.insert(name);
+            }
+            std::vector<unsigned> all = find_street_ids_from_approximate_street_name(queries[q], TRIE_TEST_ALL, 2);
+            for(unsigned t = 0; t < all.size(); t++){
+                actual.insert(normalize_street_name(getStreetName(all[t])));
+            }
+            CHECK(expected == actual);
+            CHECK_EQUAL(actual.size(), all.size());
+        }
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * Checks the point of interest queries of every type against linear scans
+ * over all points of interest.
+ */
+#include <random>
+#include <algorithm>
+#include <set>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "poi_search.h"
+#include "map_fixture.h"
+
+#define POI_TEST_POSITIONS 50
+#define POI_TEST_K 12
+#define POI_TEST_RADIUS 2000
+
+//(distance, id) of every point of interest of the type, closest first with the lower id winning ties
+static std::vector<std::pair<double, unsigned> > scan_points_of_interest(LatLon position, const std::string &type){
+    std::vector<std::pair<double, unsigned> > found;
+    for(int i = 0; i < getNumPointsOfInterest(); i++){
+        if(type == ANY_POI_TYPE || getPointOfInterestType(i) == type){
+            found.push_back(std::make_pair(find_distance_between_two_points(position, getPointOfInterestPosition(i)), i));
+        }
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+//The types to query: any type, the types on the map and one that is not
+static std::vector<std::string> poi_test_types(){
+    std::set<std::string> types;
+    for(int i = 0; i < getNumPointsOfInterest(); i++){
+        types.insert(getPointOfInterestType(i));
+    }
+    std::vector<std::string> test_types(types.begin(), types.end());
+    test_types.push_back(ANY_POI_TYPE);
+    test_types.push_back("no such type");
+    return test_types;
+}
+
+//Random positions around the points of interest
+static std::vector<LatLon> poi_test_positions(){
+    std::mt19937 rng(297);
+    std::uniform_int_distribution<int> poi(0, getNumPointsOfInterest()-1);
+    std::normal_distribution<double> noise(0, 0.01);
+    std::vector<LatLon> positions;
+    for(unsigned i = 0; i < POI_TEST_POSITIONS; i++){
+        LatLon center = getPointOfInterestPosition(poi(rng));
+        positions.push_back(LatLon(center.lat()+noise(rng), center.lon()+noise(rng)));
+    }
+    return positions;
+}
+
+SUITE(poi_search){
+
+    TEST_FIXTURE(MapFixture, nearest_and_k_nearest_match_scan){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        for(const std::string &type : poi_test_types()){
+            for(LatLon position : poi_test_positions()){
+                std::vector<std::pair<double, unsigned> > expected = scan_points_of_interest(position, type);
+
+                unsigned closest = type == ANY_POI_TYPE ? find_closest_point_of_interest(position)
+                                                        : find_closest_point_of_interest_of_type(position, type);
+                CHECK_EQUAL(expected.empty() ? NO_POI : expected[0].second, closest);
+
+                //k of none, some, and more than there are
+                unsigned counts[] = {0, 1, POI_TEST_K, (unsigned)expected.size()+1};
+                for(unsigned k : counts){
+                    std::vector<unsigned> k_closest = find_k_closest_points_of_interest(position, k, type);
+                    CHECK_EQUAL(std::min(k, (unsigned)expected.size()), k_closest.size());
+                    for(unsigned i = 0; i < k_closest.size(); i++){
+                        CHECK_EQUAL(expected[i].second, k_closest[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    TEST_FIXTURE(MapFixture, radius_and_box_match_scan){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        for(const std::string &type : poi_test_types()){
+            for(LatLon position : poi_test_positions()){
+                std::vector<std::pair<double, unsigned> > expected = scan_points_of_interest(position, type);
+
+                std::vector<unsigned> in_radius = find_points_of_interest_within_radius(position, POI_TEST_RADIUS, type);
+                std::vector<unsigned> expected_in_radius;
+                for(unsigned i = 0; i < expected.size() && expected[i].first <= POI_TEST_RADIUS; i++){
+                    expected_in_radius.push_back(expected[i].second);
+                }
+                CHECK(expected_in_radius == in_radius);
+
+                //Box reaching about 1km either way, corners given in the opposite order
+                LatLon corner1(position.lat()+0.009, position.lon()+0.012);
+                LatLon corner2(position.lat()-0.009, position.lon()-0.012);
+                std::vector<unsigned> in_box = find_points_of_interest_in_box(corner1, corner2, type);
+                std::vector<unsigned> expected_in_box;
+                for(unsigned i = 0; i < expected.size(); i++){
+                    LatLon poi = getPointOfInterestPosition(expected[i].second);
+                    if(poi.lat() >= corner2.lat() && poi.lat() <= corner1.lat() && poi.lon() >= corner2.lon() && poi.lon() <= corner1.lon()){
+                        expected_in_box.push_back(expected[i].second);
+                    }
+                }
+                std::sort(in_box.begin(), in_box.end());
+                std::sort(expected_in_box.begin(), expected_in_box.end());
+                CHECK(expected_in_box == in_box);
+            }
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * Validates the batched PointArray distances against the scalar
+ * find_distance_between_two_points().
+ */
+#include <random>
+#include <algorithm>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "point_array.h"
+
+#define POINT_ARRAY_TOLERANCE 1e-9
+
+SUITE(point_array_distances){
+
+    //Positions spread over a city sized area and over the whole globe
+    static std::vector<LatLon> random_positions(unsigned count, double lat_center, double lon_center, double spread, unsigned seed){
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> offset(-spread, spread);
+        std::vector<LatLon> positions(count);
+        for(unsigned i = 0; i < count; i++){
+            positions[i] = LatLon(std::max(-89.0, std::min(89.0, lat_center+offset(rng))), lon_center+offset(rng));
+        }
+        return positions;
+    }
+
+    TEST(batch_matches_scalar){
+        const double centers[][3] = {{43.7, -79.4, 0.3}, {-33.9, 151.2, 0.3}, {64.1, -21.9, 0.3}, {0, 0, 80}};
+
+        for(unsigned c = 0; c < 4; c++){
+            std::vector<LatLon> from = random_positions(10000, centers[c][0], centers[c][1], centers[c][2], 1+c);
+            std::vector<LatLon> to = random_positions(10000, centers[c][0], centers[c][1], centers[c][2], 11+c);
+            PointArray from_array(from), to_array(to);
+
+            std::vector<double> pairwise, one_to_many;
+            from_array.distances_to(to_array, pairwise);
+            to_array.distances_from(from[0], one_to_many);
+
+            double worst = 0;
+            for(unsigned i = 0; i < from.size(); i++){
+                double expected = find_distance_between_two_points(from[i], to[i]);
+                worst = std::max(worst, std::abs(pairwise[i]-expected)/std::max(expected, 1.0));
+
+                expected = find_distance_between_two_points(from[0], to[i]);
+                worst = std::max(worst, std::abs(one_to_many[i]-expected)/std::max(expected, 1.0));
+            }
+            CHECK(worst < POINT_ARRAY_TOLERANCE);
+        }
+    }
+
+    TEST(single_pair_matches_scalar){
+        std::vector<LatLon> positions = random_positions(1000, 43.7, -79.4, 0.3, 5);
+        PointArray array(positions);
+        for(unsigned i = 0; i+1 < positions.size(); i++){
+            double expected = find_distance_between_two_points(positions[i], positions[i+1]);
+            CHECK_CLOSE(expected, array.distance(i, i+1), POINT_ARRAY_TOLERANCE*std::max(expected, 1.0));
+        }
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Checks the Douglas-Peucker levels of detail against their tolerances, and
+ * that the street segment levels keep every segment's ends.
+ */
+#include <random>
+#include <cmath>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "StreetsDatabaseAPI.h"
+#include "segments.h"
+#include "polyline_lod.h"
+#include "map_fixture.h"
+
+SUITE(polyline_lod){
+
+    //Distance from p to the segment a-b
+    static double distance_to_segment(const SegmentPoint &p, const SegmentPoint &a, const SegmentPoint &b){
+        double dx = b.x-a.x, dy = b.y-a.y;
+        double length2 = dx*dx+dy*dy;
+        double t = length2 == 0 ? 0 : std::max(0.0, std::min(1.0, ((p.x-a.x)*dx+(p.y-a.y)*dy)/length2));
+        return std::hypot(p.x-a.x-t*dx, p.y-a.y-t*dy);
+    }
+
+    //Every point of line is within tolerance of the simplified polyline,
+    //which is a subsequence of line with the same ends
+    static bool within_tolerance(const std::vector<SegmentPoint> &line, const SegmentPoint *simplified, unsigned count, double tolerance){
+        if(count < 2 || simplified[0].x != line[0].x || simplified[count-1].x != line.back().x) return false;
+        unsigned next = 0;
+        for(unsigned i = 0; i < line.size(); i++){
+            if(next < count && line[i].x == simplified[next].x && line[i].y == simplified[next].y){
+                next++;
+                continue;
+            }
+            if(next == 0 || next == count) return false;
+            if(distance_to_segment(line[i], simplified[next-1], simplified[next]) > tolerance*(1+1e-9)) return false;
+        }
+        return next == count;
+    }
+
+    TEST(random_walks){
+        std::mt19937 rng(45);
+        std::normal_distribution<double> step(0, 1);
+        std::vector<SegmentPoint> points;
+        std::vector<unsigned> line_begin;
+        for(unsigned l = 0; l < 300; l++){
+            line_begin.push_back(points.size());
+            unsigned length = 2+rng()%200;
+            SegmentPoint current = {0, 0};
+            for(unsigned i = 0; i < length; i++){
+                points.push_back(current);
+                current.x += step(rng);
+                current.y += step(rng);
+            }
+            //Every third line is a closed ring
+            if(l%3 == 0) points.push_back(points[line_begin.back()]);
+        }
+        line_begin.push_back(points.size());
+
+        std::vector<double> tolerances = {8, 2, 0.5};
+        PolylineLOD<SegmentPoint> lod;
+        lod.build(points, line_begin, tolerances);
+        CHECK_EQUAL(tolerances.size(), lod.level_count());
+
+        for(unsigned l = 0; l+1 < line_begin.size(); l++){
+            std::vector<SegmentPoint> line(points.begin()+line_begin[l], points.begin()+line_begin[l+1]);
+            for(unsigned level = 0; level < lod.level_count(); level++){
+                CHECK(within_tolerance(line, lod.line(level, l), lod.line_size(level, l), tolerances[level]));
+                if(level > 0) CHECK(lod.line_size(level, l) >= lod.line_size(level-1, l));
+            }
+        }
+        CHECK(lod.point_count(0) < lod.point_count(2));
+        CHECK(lod.point_count(2) < points.size());
+    }
+
+    TEST_FIXTURE(MapFixture, segment_levels){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        unsigned segment_count = getNumStreetSegments();
+        std::vector<unsigned> segment_begin(segment_count+1);
+        for(unsigned i = 0; i <= segment_count; i++){
+            segment_begin[i] = segment_table.point_begin(i);
+        }
+
+        //The levels drawn by m2, for a world as wide as the segments
+        double x_min = segment_table.points[0].x, x_max = segment_table.points[0].x;
+        for(unsigned i = 0; i < segment_table.points.size(); i++){
+            x_min = std::min(x_min, segment_table.points[i].x);
+            x_max = std::max(x_max, segment_table.points[i].x);
+        }
+        PolylineLOD<SegmentPoint> lod;
+        lod.build(segment_table.points, segment_begin, LOD_tolerances(x_max-x_min));
+        CHECK_EQUAL((unsigned)LOD_LEVELS, lod.level_count());
+
+        //Segments stay connected: both ends are always kept
+        for(unsigned level = 0; level < lod.level_count(); level++){
+            for(unsigned i = 0; i < segment_count; i += 7){
+                const SegmentPoint *line = lod.line(level, i);
+                unsigned size = lod.line_size(level, i);
+                CHECK(size >= 2);
+                CHECK(line[0].x == segment_table.points[segment_begin[i]].x && line[0].y == segment_table.points[segment_begin[i]].y);
+                CHECK(line[size-1].x == segment_table.points[segment_begin[i+1]-1].x && line[size-1].y == segment_table.points[segment_begin[i+1]-1].y);
+            }
+        }
+        for(unsigned level = 1; level < lod.level_count(); level++){
+            CHECK(lod.point_count(level-1) <= lod.point_count(level));
+        }
+    }
+}
@@ -0,0 +1,202 @@
+/*
+ * Checks snapping positions onto street segments against a scan of every
+ * segment, and routing between points in the middle of segments.
+ */
+#include <random>
+#include <cmath>
+#include <unittest++/UnitTest++.h>
+#include "m1.h"
+#include "m3.h"
+#include "StreetsDatabaseAPI.h"
+#include "segment_route.h"
+#include "map_fixture.h"
+
+#define SEGMENT_TEST_POSITIONS 200
+#define SEGMENT_TEST_ROUTES 100
+#define SEGMENT_TEST_TOLERANCE 1e-6
+
+//Points of a segment's polyline, from its from intersection to its to intersection
+static std::vector<LatLon> segment_polyline(unsigned segment){
+    InfoStreetSegment info = getInfoStreetSegment(segment);
+    std::vector<LatLon> points(1, getIntersectionPosition(info.from));
+    for(int i = 0; i < info.curvePointCount; i++){
+        points.push_back(getStreetSegmentCurvePoint(i, segment));
+    }
+    points.push_back(getIntersectionPosition(info.to));
+    return points;
+}
+
+//Closest point of one segment to position, in meters on a plane tangent at
+//the position's latitude
+static SegmentProjection scan_segment(LatLon position, unsigned segment){
+    std::vector<LatLon> points = segment_polyline(segment);
+    double x_scale = EARTH_RADIUS_IN_METERS*DEG_TO_RAD*cos(position.lat()*DEG_TO_RAD);
+    double y_scale = EARTH_RADIUS_IN_METERS*DEG_TO_RAD;
+
+    SegmentProjection closest = {segment, INFINITY, 0, 0, position};
+    double length = 0;
+    for(unsigned p = 0; p+1 < points.size(); p++){
+        double ex = (points[p+1].lon()-points[p].lon())*x_scale, ey = (points[p+1].lat()-points[p].lat())*y_scale;
+        double px = (position.lon()-points[p].lon())*x_scale, py = (position.lat()-points[p].lat())*y_scale;
+        double length_sq = ex*ex + ey*ey;
+        double t = length_sq > 0 ? std::max(0.0, std::min(1.0, (px*ex + py*ey)/length_sq)) : 0;
+        double distance = std::hypot(px-t*ex, py-t*ey);
+        double edge = find_distance_between_two_points(points[p], points[p+1]);
+        if(distance < closest.distance){
+            closest.distance = distance;
+            closest.offset = length + t*edge;
+            closest.position = LatLon(points[p].lat() + t*(points[p+1].lat()-points[p].lat()),
+                                      points[p].lon() + t*(points[p+1].lon()-points[p].lon()));
+        }
+        length += edge;
+    }
+    closest.fraction = length > 0 ? closest.offset/length : 0;
+    return closest;
+}
+
+//A point a fraction of the way along a segment, as find_closest_street_segment() would give it
+static SegmentProjection point_on_segment(unsigned segment, double fraction){
+    SegmentProjection point = {segment, 0, fraction*find_street_segment_length(segment), fraction, LatLon(0, 0)};
+    return point;
+}
+
+//Whether each segment of the path shares an intersection with the next
+static bool is_connected(const std::vector<unsigned> &path){
+    for(unsigned i = 0; i+1 < path.size(); i++){
+        InfoStreetSegment a = getInfoStreetSegment(path[i]), b = getInfoStreetSegment(path[i+1]);
+        if(a.from != b.from && a.from != b.to && a.to != b.from && a.to != b.to){
+            return false;
+        }
+    }
+    return true;
+}
+
+SUITE(segment_route){
+
+    TEST(no_segment_ends){
+        SegmentProjection none = {NO_SEGMENT, 0, 0, 0, LatLon(0, 0)};
+        CHECK(find_path_between_segment_points(none, none, 15, 25).empty());
+        CHECK_EQUAL(0, compute_segment_path_travel_time(std::vector<unsigned>(1, 0), none, none, 15, 25));
+    }
+
+    TEST_FIXTURE(MapFixture, one_end_without_segment){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        SegmentProjection none = {NO_SEGMENT, 0, 0, 0, LatLon(0, 0)};
+        SegmentProjection start = find_closest_street_segment(getIntersectionPosition(0));
+        CHECK(start.segment != NO_SEGMENT);
+        CHECK(find_path_between_segment_points(start, none, 15, 25).empty());
+        CHECK(find_path_between_segment_points(none, start, 15, 25).empty());
+        CHECK_EQUAL(0, compute_segment_path_travel_time(std::vector<unsigned>(1, start.segment), start, none, 15, 25));
+    }
+
+    TEST_FIXTURE(MapFixture, closest_segment_matches_scan){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        //Positions scattered around random intersections
+        std::mt19937 rng(297);
+        std::uniform_int_distribution<int> intersection(0, getNumIntersections()-1);
+        std::normal_distribution<double> noise(0, 0.0005);
+        for(unsigned q = 0; q < SEGMENT_TEST_POSITIONS; q++){
+            LatLon center = getIntersectionPosition(intersection(rng));
+            LatLon position(center.lat()+noise(rng), center.lon()+noise(rng));
+
+            double closest_distance = INFINITY;
+            for(int s = 0; s < getNumStreetSegments(); s++){
+                closest_distance = std::min(closest_distance, scan_segment(position, s).distance);
+            }
+
+            //Segments as close as the closest may be found instead of it, so
+            //the found one is checked against its own scan
+            SegmentProjection found = find_closest_street_segment(position);
+            SegmentProjection expected = scan_segment(position, found.segment);
+            CHECK_CLOSE(closest_distance, found.distance, SEGMENT_TEST_TOLERANCE*std::max(closest_distance, 1.0));
+            CHECK_CLOSE(expected.distance, found.distance, SEGMENT_TEST_TOLERANCE*std::max(expected.distance, 1.0));
+            CHECK_CLOSE(expected.fraction, found.fraction, SEGMENT_TEST_TOLERANCE);
+            CHECK_CLOSE(expected.offset, found.offset, SEGMENT_TEST_TOLERANCE*std::max(expected.offset, 1.0));
+            CHECK(find_distance_between_two_points(expected.position, found.position) < 1e-3);
+        }
+    }
+
+    TEST_FIXTURE(MapFixture, same_segment_routes){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        for(int s = 0; s < getNumStreetSegments(); s += 97){
+            double time = find_street_segment_travel_time(s);
+            SegmentProjection first = point_on_segment(s, 0.25), second = point_on_segment(s, 0.75);
+
+            //Along the segment's direction it is driven directly
+            std::vector<unsigned> forward = find_path_between_segment_points(first, second, 15, 25);
+            CHECK(forward == std::vector<unsigned>(1, s));
+            CHECK_CLOSE(0.5*time, compute_segment_path_travel_time(forward, first, second, 15, 25), SEGMENT_TEST_TOLERANCE);
+
+            std::vector<unsigned> backward = find_path_between_segment_points(second, first, 15, 25);
+            if(!getInfoStreetSegment(s).oneWay){
+                CHECK(backward == std::vector<unsigned>(1, s));
+                CHECK_CLOSE(0.5*time, compute_segment_path_travel_time(backward, second, first, 15, 25), SEGMENT_TEST_TOLERANCE);
+            }else if(!backward.empty()){
+                //A one way segment is left through its end and entered again
+                //through its start to go back along it
+                CHECK(backward.size() > 1);
+                CHECK_EQUAL(s, backward.front());
+                CHECK_EQUAL(s, backward.back());
+                CHECK(is_connected(backward));
+                CHECK(compute_segment_path_travel_time(backward, second, first, 15, 25) > 0.5*time);
+            }
+        }
+    }
+
+    TEST_FIXTURE(MapFixture, routes_between_segment_points){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        std::mt19937 rng(297);
+        std::uniform_int_distribution<int> segment(0, getNumStreetSegments()-1);
+        std::uniform_real_distribution<double> fraction(0, 1);
+        for(unsigned r = 0; r < SEGMENT_TEST_ROUTES; r++){
+            SegmentProjection start = point_on_segment(segment(rng), fraction(rng));
+            SegmentProjection end = point_on_segment(segment(rng), fraction(rng));
+
+            std::vector<unsigned> path = find_path_between_segment_points(start, end, 15, 25);
+            if(path.empty()) continue;
+
+            CHECK_EQUAL(start.segment, path.front());
+            CHECK_EQUAL(end.segment, path.back());
+            CHECK(is_connected(path));
+
+            //The undriven parts of the end segments are never counted
+            double time = compute_segment_path_travel_time(path, start, end, 15, 25);
+            CHECK(time >= 0);
+            CHECK(time <= compute_path_travel_time(path, 15, 25) + SEGMENT_TEST_TOLERANCE);
+        }
+    }
+
+    TEST_FIXTURE(MapFixture, travel_time_counts_driven_parts){
+        CHECK(loaded);
+        if(!loaded) return;
+
+        //Two consecutive segments of one street, so no turn is taken between them
+        for(int street = 0; street < getNumStreets(); street += 13){
+            std::vector<unsigned> segments = find_street_street_segments(street);
+            for(unsigned i = 0; i+1 < segments.size(); i++){
+                InfoStreetSegment a = getInfoStreetSegment(segments[i]), b = getInfoStreetSegment(segments[i+1]);
+                unsigned shared = (a.from == b.from || a.from == b.to) ? a.from : a.to;
+                if(shared != b.from && shared != b.to) continue;
+
+                SegmentProjection start = point_on_segment(segments[i], 0.3);
+                SegmentProjection end = point_on_segment(segments[i+1], 0.6);
+                std::vector<unsigned> path = {segments[i], segments[i+1]};
+
+                //The first segment is driven from start to the shared intersection,
+                //the second from the shared intersection to end
+                double expected = (shared == a.to ? 0.7 : 0.3)*find_street_segment_travel_time(segments[i])
+                                + (shared == b.from ? 0.6 : 0.4)*find_street_segment_travel_time(segments[i+1]);
+                CHECK_CLOSE(expected, compute_segment_path_travel_time(path, start, end, 15, 25), SEGMENT_TEST_TOLERANCE);
+                break;
+            }
+        }
+    }
+}
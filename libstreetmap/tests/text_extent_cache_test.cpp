@@ -0,0 +1,81 @@
+/*
+ * Checks the LRU eviction and memory bound of ezgl's text measurement cache,
+ * and that the renderer measures repeated text from it.
+ */
+#include <unittest++/UnitTest++.h>
+#include <ezgl/graphics.hpp>
+
+static ezgl::text_extent_cache::extents text_extents(double width){
+    ezgl::text_extent_cache::extents value{};
+    value.text.width = width;
+    return value;
+}
+
+SUITE(text_extent_cache){
+
+    TEST(lru_eviction){
+        ezgl::text_extent_cache probe(1 << 20);
+        probe.insert("a", text_extents(1));
+        size_t entry = probe.memory_usage();
+
+        ezgl::text_extent_cache cache(3*entry);
+        cache.insert("a", text_extents(1));
+        cache.insert("b", text_extents(2));
+        cache.insert("c", text_extents(3));
+        CHECK_EQUAL(3u, cache.size());
+        CHECK_EQUAL(3*entry, cache.memory_usage());
+
+        //Using the oldest entry keeps it when the next insert evicts
+        CHECK(cache.find("a") != nullptr);
+        cache.insert("d", text_extents(4));
+        CHECK_EQUAL(3u, cache.size());
+        CHECK(cache.find("b") == nullptr);
+        CHECK_EQUAL(1, cache.find("a")->text.width);
+        CHECK_EQUAL(4, cache.find("d")->text.width);
+        CHECK_EQUAL(3ul, cache.hit_count());
+        CHECK_EQUAL(1ul, cache.miss_count());
+
+        //Shrinking the bound drops the least recently used entries
+        cache.set_max_bytes(entry);
+        CHECK_EQUAL(1u, cache.size());
+        CHECK(cache.find("d") != nullptr);
+
+        cache.clear();
+        CHECK_EQUAL(0u, cache.size());
+        CHECK_EQUAL(0u, cache.memory_usage());
+    }
+
+    TEST(memory_bound){
+        ezgl::text_extent_cache cache(16*1024);
+        for(int i = 0; i < 1000; i++){
+            cache.insert("street " + std::to_string(i), text_extents(i));
+            CHECK(cache.memory_usage() <= 16*1024);
+        }
+        CHECK(cache.size() > 10);
+        CHECK(cache.find("street 999") != nullptr);
+        CHECK(cache.find("street 0") == nullptr);
+    }
+
+    TEST(renderer_reuses_measurements){
+        ezgl::text_extent_cache &cache = ezgl::renderer::text_cache();
+        cache.clear();
+        unsigned long hits = cache.hit_count();
+        unsigned long misses = cache.miss_count();
+
+        ezgl::point2d first{0, 0}, second{0, 0};
+        ezgl::surface *image = ezgl::renderer::render_to_image([&](ezgl::renderer &g){
+            g.set_font_size(12);
+            first = g.get_text_size("King Street West");
+            second = g.get_text_size("King Street West");
+            g.set_font_size(24);
+            g.get_text_size("King Street West");
+        }, {{0, 0}, {1, 1}}, 16, 16);
+        ezgl::renderer::free_surface(image);
+
+        //The font size is part of the key, so only the repeat is a hit
+        CHECK_EQUAL(first.x, second.x);
+        CHECK_EQUAL(hits+1, cache.hit_count());
+        CHECK_EQUAL(misses+2, cache.miss_count());
+        CHECK_EQUAL(2u, cache.size());
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Checks the tile pyramid's grid and the LRU eviction and memory cap of the
+ * base map tile cache.
+ */
+#include <cmath>
+#include <unittest++/UnitTest++.h>
+#include "tile_cache.h"
+
+#define TILE_TEST_SIZE 64
+
+//Bytes of one test tile image
+static size_t tile_bytes(){
+    ezgl::surface *tile = cairo_image_surface_create(CAIRO_FORMAT_RGB24, TILE_TEST_SIZE, TILE_TEST_SIZE);
+    size_t bytes = (size_t)cairo_image_surface_get_stride(tile)*TILE_TEST_SIZE;
+    ezgl::renderer::free_surface(tile);
+    return bytes;
+}
+
+static ezgl::surface *new_tile(){
+    return cairo_image_surface_create(CAIRO_FORMAT_RGB24, TILE_TEST_SIZE, TILE_TEST_SIZE);
+}
+
+SUITE(tile_cache){
+
+    TEST(pyramid_grid){
+        TilePyramid pyramid({10, 20}, 0.5, 3.0/5.0, TILE_TEST_SIZE);
+        CHECK(pyramid.valid());
+        CHECK(!TilePyramid().valid());
+
+        CHECK_EQUAL(0, pyramid.level_for(0.5));
+        CHECK_EQUAL(1, pyramid.level_for(0.3));
+        CHECK_EQUAL(3, pyramid.level_for(0.5*std::pow(0.6, 3)*1.05));
+        CHECK_EQUAL(-2, pyramid.level_for(0.5/0.36));
+
+        //A tile is tile_size pixels of its level, and neighbours share edges
+        ezgl::rectangle bounds = pyramid.tile_bounds({2, -1, 3});
+        CHECK_CLOSE(TILE_TEST_SIZE*pyramid.level_scale(2), bounds.width(), 1e-9);
+        CHECK_CLOSE(bounds.width(), bounds.height(), 1e-9);
+        CHECK_EQUAL(bounds.right(), pyramid.tile_bounds({2, 0, 3}).left());
+        CHECK_EQUAL(bounds.top(), pyramid.tile_bounds({2, -1, 4}).bottom());
+
+        //The tiles found cover the rectangle, and no more than one tile past it
+        ezgl::rectangle world({3, 7}, {150, 61});
+        std::vector<TileKey> tiles = pyramid.tiles_in(world, 1);
+        double left = INFINITY, right = -INFINITY, bottom = INFINITY, top = -INFINITY;
+        for(unsigned i = 0; i < tiles.size(); i++){
+            CHECK_EQUAL(1, tiles[i].level);
+            ezgl::rectangle tile = pyramid.tile_bounds(tiles[i]);
+            left = std::min(left, tile.left());
+            right = std::max(right, tile.right());
+            bottom = std::min(bottom, tile.bottom());
+            top = std::max(top, tile.top());
+        }
+        double tile_world = TILE_TEST_SIZE*pyramid.level_scale(1);
+        CHECK(left <= world.left() && left > world.left()-tile_world);
+        CHECK(right >= world.right() && right < world.right()+tile_world);
+        CHECK(bottom <= world.bottom() && bottom > world.bottom()-tile_world);
+        CHECK(top >= world.top() && top < world.top()+tile_world);
+        CHECK_EQUAL((size_t)std::lround((right-left)/tile_world*(top-bottom)/tile_world), tiles.size());
+    }
+
+    TEST(lru_eviction){
+        TileCache cache(3*tile_bytes());
+        cache.insert({0, 0, 0}, new_tile());
+        cache.insert({0, 1, 0}, new_tile());
+        cache.insert({0, 2, 0}, new_tile());
+        CHECK_EQUAL(3u, cache.size());
+        CHECK_EQUAL(3*tile_bytes(), cache.memory_usage());
+
+        //Using the oldest tile keeps it when the next insert evicts
+        CHECK(cache.find({0, 0, 0}) != nullptr);
+        cache.insert({0, 3, 0}, new_tile());
+        CHECK_EQUAL(3u, cache.size());
+        CHECK(cache.find({0, 1, 0}) == nullptr);
+        CHECK(cache.find({0, 0, 0}) != nullptr);
+        CHECK(cache.find({0, 2, 0}) != nullptr);
+        CHECK(cache.find({0, 3, 0}) != nullptr);
+        CHECK(cache.find({1, 0, 0}) == nullptr);
+        CHECK(cache.find({0, 0, 0, 1}) == nullptr);
+        CHECK_EQUAL(4ul, cache.hit_count());
+        CHECK_EQUAL(3ul, cache.miss_count());
+
+        //The same tile drawn for another zoom level is kept beside it
+        cache.insert({0, 2, 0, 1}, new_tile());
+        CHECK_EQUAL(3u, cache.size());
+        CHECK(cache.find({0, 2, 0, 1}) != nullptr);
+        CHECK(cache.find({0, 2, 0}) != nullptr);
+
+        //Replacing a tile frees the old one
+        ezgl::surface *tile = new_tile();
+        cache.insert({0, 3, 0}, tile);
+        CHECK_EQUAL(3u, cache.size());
+        CHECK(cache.find({0, 3, 0}) == tile);
+
+        cache.clear();
+        CHECK_EQUAL(0u, cache.size());
+        CHECK_EQUAL(0u, cache.memory_usage());
+        CHECK(cache.find({0, 0, 0}) == nullptr);
+    }
+
+    TEST(memory_cap){
+        TileCache cache(10*tile_bytes()+tile_bytes()/2);
+        for(int i = 0; i < 100; i++){
+            cache.insert({i%3, i, -i}, new_tile());
+            CHECK(cache.memory_usage() <= 10*tile_bytes()+tile_bytes()/2);
+        }
+        CHECK_EQUAL(10u, cache.size());
+        for(int i = 90; i < 100; i++){
+            CHECK(cache.find({i%3, i, -i}) != nullptr);
+        }
+    }
+}
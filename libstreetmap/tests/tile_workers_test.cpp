@@ -0,0 +1,97 @@
+/*
+ * Checks that the tile rendering threads render every requested tile once,
+ * that a new request replaces the waiting one, and that invalidated tiles are
+ * discarded.
+ */
+#include <atomic>
+#include <unittest++/UnitTest++.h>
+#include "tile_workers.h"
+
+#define TILE_TEST_SIZE 16
+
+static std::vector<TileRequest> tile_requests(int level, int count){
+    std::vector<TileRequest> requests;
+    for(int i = 0; i < count; i++){
+        requests.push_back({{level, i, 0, 1}, {{0, 0}, {1, 1}}, MapStyle()});
+    }
+    return requests;
+}
+
+static void free_tiles(std::vector<std::pair<TileKey, ezgl::surface *> > &tiles){
+    for(unsigned i = 0; i < tiles.size(); i++){
+        ezgl::renderer::free_surface(tiles[i].second);
+    }
+}
+
+SUITE(tile_workers){
+
+    TEST(renders_each_request){
+        std::atomic<int> renders(0), wakes(0);
+        TileWorkers workers(2, [&](const TileRequest &){
+            renders++;
+            return cairo_image_surface_create(CAIRO_FORMAT_RGB24, TILE_TEST_SIZE, TILE_TEST_SIZE);
+        }, [&]{ wakes++; });
+        CHECK_EQUAL(2u, workers.thread_count());
+
+        //Repeating a request while it is pending does not render it twice
+        std::vector<TileRequest> requests = tile_requests(0, 20);
+        workers.request(requests);
+        workers.request(requests);
+        workers.wait_idle();
+
+        std::vector<std::pair<TileKey, ezgl::surface *> > tiles = workers.take_finished();
+        CHECK_EQUAL(20u, tiles.size());
+        CHECK_EQUAL(20, renders.load());
+        CHECK(wakes.load() >= 1);
+        free_tiles(tiles);
+
+        CHECK(workers.take_finished().empty());
+    }
+
+    TEST(request_replaces_waiting){
+        std::mutex gate;
+        gate.lock();
+        TileWorkers workers(1, [&](const TileRequest &){
+            std::lock_guard<std::mutex> m_lock(gate);
+            return cairo_image_surface_create(CAIRO_FORMAT_RGB24, TILE_TEST_SIZE, TILE_TEST_SIZE);
+        }, []{});
+
+        //The first tile of level 0 may already be rendering; the rest of
+        //level 0 is dropped by the level 1 request
+        workers.request(tile_requests(0, 10));
+        workers.request(tile_requests(1, 3));
+        gate.unlock();
+        workers.wait_idle();
+
+        std::vector<std::pair<TileKey, ezgl::surface *> > tiles = workers.take_finished();
+        int level_0 = 0, level_1 = 0;
+        for(unsigned i = 0; i < tiles.size(); i++){
+            (tiles[i].first.level == 0 ? level_0 : level_1)++;
+        }
+        CHECK(level_0 <= 1);
+        CHECK_EQUAL(3, level_1);
+        free_tiles(tiles);
+    }
+
+    TEST(invalidate_discards){
+        std::mutex gate;
+        gate.lock();
+        TileWorkers workers(1, [&](const TileRequest &){
+            std::lock_guard<std::mutex> m_lock(gate);
+            return cairo_image_surface_create(CAIRO_FORMAT_RGB24, TILE_TEST_SIZE, TILE_TEST_SIZE);
+        }, []{});
+
+        workers.request(tile_requests(0, 5));
+        workers.invalidate();
+        gate.unlock();
+        workers.wait_idle();
+        CHECK(workers.take_finished().empty());
+
+        //Tiles requested after invalidating are kept
+        workers.request(tile_requests(0, 5));
+        workers.wait_idle();
+        std::vector<std::pair<TileKey, ezgl::surface *> > tiles = workers.take_finished();
+        CHECK_EQUAL(5u, tiles.size());
+        free_tiles(tiles);
+    }
+}